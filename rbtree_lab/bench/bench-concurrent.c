@@ -0,0 +1,283 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 동시 읽기 처리량 벤치마크 (-DRBTREE_CONCURRENT로 빌드)
+// 키 n개가 든 트리에 쓰기 스레드 하나가 계속 삽입/삭제를 하는 동안, 읽기 스레드 1~32개가 rbtree_find를 반복
+// 같은 부하를 세 가지 동기화 방식으로 측정해서 비교
+//   seqlock : RBTREE_CONCURRENT 모드의 락 없는 읽기 (쓰기만 시퀀스 카운터를 올림)
+//   mutex   : 트리 전체를 전역 mutex 하나로 보호 (지금 서비스에서 쓰는 방식)
+//   rwlock  : 읽기는 공유, 쓰기는 배타인 pthread_rwlock
+// 출력 : workload가 find_<방식>인 줄은 읽기 스레드 전체의 처리량, update_<방식>인 줄은 같은 시간 동안의 쓰기 처리량
+//
+// 사용법 : ./bench-concurrent [-n keys] [-t 1,2,4,8,16,32] [-m seqlock,mutex,rwlock] [-p random|zipf] [-d ms] [-r] [-H]
+
+#define MAX_THREADS 64
+// 쓰기 스레드가 최근에 넣은 노드를 기억해 두는 수. 이만큼 넣은 뒤부터는 넣을 때마다 가장 오래된 것을 지움
+#define WRITER_WINDOW 4096
+
+typedef enum { SYNC_SEQLOCK, SYNC_MUTEX, SYNC_RWLOCK, SYNC_COUNT } sync_t;
+
+static const char *const find_names[SYNC_COUNT] = {"find_seqlock", "find_mutex", "find_rwlock"};
+static const char *const update_names[SYNC_COUNT] = {"update_seqlock", "update_mutex", "update_rwlock"};
+
+typedef struct {
+    rbtree *t;
+    sync_t sync;
+    const key_t *keys; // 읽기 스레드가 찾을 키 순서 (모두 트리에 있는 키)
+    size_t n;
+    pthread_mutex_t mutex;
+    pthread_rwlock_t rwlock;
+    int start, stop; // 모든 스레드가 준비된 뒤 함께 출발, 측정 시간이 끝나면 함께 멈춤
+    int ready;
+} shared_t;
+
+typedef struct {
+    shared_t *sh;
+    int id;
+    size_t ops;
+    size_t found;
+} worker_t;
+
+// 읽기 스레드 : 자기 번호만큼 떨어진 위치부터 키 배열을 돌며 탐색
+static void *reader_main(void *arg) {
+    worker_t *w = arg;
+    shared_t *sh = w->sh;
+    size_t i = (size_t)w->id * (sh->n / MAX_THREADS), ops = 0, found = 0;
+    __atomic_fetch_add(&sh->ready, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&sh->start, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    while (!__atomic_load_n(&sh->stop, __ATOMIC_RELAXED)) {
+        for (int k = 0; k < 64; k++) { // 멈춤 플래그는 64번에 한 번만 확인
+            const key_t key = sh->keys[i];
+            i = i + 1 == sh->n ? 0 : i + 1;
+            switch (sh->sync) {
+            case SYNC_SEQLOCK:
+                found += rbtree_find(sh->t, key) != NULL;
+                break;
+            case SYNC_MUTEX:
+                pthread_mutex_lock(&sh->mutex);
+                found += rbtree_find(sh->t, key) != NULL;
+                pthread_mutex_unlock(&sh->mutex);
+                break;
+            default:
+                pthread_rwlock_rdlock(&sh->rwlock);
+                found += rbtree_find(sh->t, key) != NULL;
+                pthread_rwlock_unlock(&sh->rwlock);
+                break;
+            }
+        }
+        ops += 64;
+    }
+    w->ops = ops;
+    w->found = found;
+    return NULL;
+}
+
+static void write_lock(shared_t *sh) {
+    if (sh->sync == SYNC_MUTEX) {
+        pthread_mutex_lock(&sh->mutex);
+    } else if (sh->sync == SYNC_RWLOCK) {
+        pthread_rwlock_wrlock(&sh->rwlock);
+    }
+}
+
+static void write_unlock(shared_t *sh) {
+    if (sh->sync == SYNC_MUTEX) {
+        pthread_mutex_unlock(&sh->mutex);
+    } else if (sh->sync == SYNC_RWLOCK) {
+        pthread_rwlock_unlock(&sh->rwlock);
+    }
+}
+
+// 쓰기 스레드 : 트리에 없는 음수 키를 넣고, 창이 차면 가장 오래된 것을 지워 트리 크기를 일정하게 유지
+static void *writer_main(void *arg) {
+    worker_t *w = arg;
+    shared_t *sh = w->sh;
+    node_t **window = calloc(WRITER_WINDOW, sizeof(node_t *));
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    size_t ops = 0, head = 0;
+    __atomic_fetch_add(&sh->ready, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&sh->start, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    while (!__atomic_load_n(&sh->stop, __ATOMIC_RELAXED)) {
+        const key_t key = -1 - (key_t)(bench_rand(&state) % sh->n); // 읽기 스레드의 키(0 이상)와 겹치지 않음
+        write_lock(sh);
+        if (window[head] != NULL) {
+            rbtree_erase(sh->t, window[head]);
+        }
+        window[head] = rbtree_insert(sh->t, key);
+        write_unlock(sh);
+        head = (head + 1) % WRITER_WINDOW;
+        ops++;
+    }
+    w->ops = ops;
+    free(window);
+    return NULL;
+}
+
+static int run_case(shared_t *sh, const sync_t sync, const int readers, const bool writer, const unsigned ms,
+                    const char *pattern) {
+    sh->sync = sync;
+    sh->start = sh->stop = sh->ready = 0;
+    worker_t workers[MAX_THREADS + 1];
+    pthread_t th[MAX_THREADS + 1];
+    const int total = readers + (writer ? 1 : 0);
+    for (int i = 0; i < total; i++) {
+        workers[i] = (worker_t){.sh = sh, .id = i};
+        if (pthread_create(&th[i], NULL, i < readers ? reader_main : writer_main, &workers[i]) != 0) {
+            fprintf(stderr, "bench-concurrent: pthread_create failed\n");
+            return -1;
+        }
+    }
+    while (__atomic_load_n(&sh->ready, __ATOMIC_ACQUIRE) < total) {
+        sched_yield();
+    }
+
+    uint64_t begin = bench_now_ns();
+    __atomic_store_n(&sh->start, 1, __ATOMIC_RELEASE);
+    usleep(ms * 1000);
+    __atomic_store_n(&sh->stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < total; i++) {
+        pthread_join(th[i], NULL);
+    }
+    uint64_t ns = bench_now_ns() - begin;
+
+    size_t reads = 0, found = 0;
+    for (int i = 0; i < readers; i++) {
+        reads += workers[i].ops;
+        found += workers[i].found;
+    }
+    if (found != reads) { // 읽는 키는 쓰기 스레드가 건드리지 않으므로 항상 찾아져야 함
+        fprintf(stderr, "bench-concurrent: %zu of %zu lookups missed\n", reads - found, reads);
+        return -1;
+    }
+    bench_report("concurrent", find_names[sync], pattern, sh->n, readers, reads, ns);
+    if (writer) {
+        bench_report("concurrent", update_names[sync], pattern, sh->n, 1, workers[readers].ops, ns);
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n keys] [-t threads] [-m modes] [-p pattern] [-d ms] [-r] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  keys in the tree (default 1000000)\n");
+    fprintf(stderr, "  -t  comma separated reader thread counts (default 1,2,4,8,16,32)\n");
+    fprintf(stderr, "  -m  seqlock,mutex,rwlock (default all)\n");
+    fprintf(stderr, "  -p  reader key pattern: random or zipf (default random)\n");
+    fprintf(stderr, "  -d  duration of each case in ms (default 1000)\n");
+    fprintf(stderr, "  -r  readers only, no writer thread\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    int threads[16] = {1, 2, 4, 8, 16, 32};
+    int n_threads = 6;
+    bool modes[SYNC_COUNT] = {true, true, true};
+    int pattern = PATTERN_RANDOM;
+    unsigned ms = 1000;
+    bool writer = true, header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:m:p:d:rs:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n = strtoull(optarg, NULL, 10);
+            break;
+        case 't':
+            n_threads = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_threads < 16; tok = strtok(NULL, ",")) {
+                threads[n_threads] = atoi(tok);
+                if (threads[n_threads] < 1 || threads[n_threads] > MAX_THREADS) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_threads++;
+            }
+            break;
+        case 'm':
+            memset(modes, 0, sizeof(modes));
+            for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                int m = 0;
+                while (m < SYNC_COUNT && strcmp(tok, find_names[m] + 5) != 0) { // "find_" 뒤의 이름과 비교
+                    m++;
+                }
+                if (m == SYNC_COUNT) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                modes[m] = true;
+            }
+            break;
+        case 'p':
+            pattern = bench_pattern_parse(optarg);
+            if (pattern != PATTERN_RANDOM && pattern != PATTERN_ZIPF) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'd':
+            ms = (unsigned)atoi(optarg);
+            break;
+        case 'r':
+            writer = false;
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (n < MAX_THREADS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // 0..n-1을 무작위 순서로 넣은 트리. 읽기 스레드의 키는 패턴에 따라 같은 범위에서 뽑음
+    shared_t sh = {.n = n};
+    key_t *keys = bench_make_keys(PATTERN_RANDOM, n, seed);
+    sh.keys = pattern == PATTERN_RANDOM ? keys : bench_make_keys(pattern, n, seed + 1);
+    sh.t = new_rbtree();
+    if (keys == NULL || sh.keys == NULL || sh.t == NULL) {
+        fprintf(stderr, "bench-concurrent: out of memory (n=%zu)\n", n);
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        rbtree_insert(sh.t, keys[i]);
+    }
+    pthread_mutex_init(&sh.mutex, NULL);
+    pthread_rwlock_init(&sh.rwlock, NULL);
+
+    if (header) {
+        bench_report_header();
+    }
+    for (int m = 0; m < SYNC_COUNT; m++) {
+        for (int i = 0; modes[m] && i < n_threads; i++) {
+            if (run_case(&sh, m, threads[i], writer, ms, bench_pattern_names[pattern]) != 0) {
+                return 1;
+            }
+        }
+    }
+
+    pthread_rwlock_destroy(&sh.rwlock);
+    pthread_mutex_destroy(&sh.mutex);
+    delete_rbtree(sh.t);
+    if (sh.keys != keys) {
+        free((void *)sh.keys);
+    }
+    free(keys);
+    return 0;
+}
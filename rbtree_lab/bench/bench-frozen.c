@@ -0,0 +1,152 @@
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 얼린 트리(rbtree_freeze) 조회 벤치마크
+// 키 n개(0, 2, 4, ...)가 든 트리에서 [0, 2n) 구간의 무작위 키 q개를 찾음 -> 절반은 있는 키, 절반은 없는 키
+// 같은 조회를 세 가지 구조로 측정해서 비교
+//   find_rbtree : rbtree_find (노드마다 포인터를 따라감)
+//   find_sorted : rbtree_to_array 결과에서 분기 없는 이진 탐색 (캐시 라인마다 키 하나만 씀)
+//   find_frozen : rbtree_frozen_find (층마다 캐시 라인 한 줄 + SIMD 비교)
+//   freeze      : rbtree_freeze 자체의 비용 (ops = n)
+// 트리는 rbtree_from_sorted로 만듦 (insert를 n번 하는 것보다 훨씬 빠르고, 노드가 한 덩어리에 모여 있어 rbtree에 유리한 쪽)
+// 구조가 L3 캐시보다 커야 차이가 드러나므로 기본 크기는 1M, 10M, 50M (50M은 rbtree만 약 2GB)
+//
+// 사용법 : ./bench-frozen [-n 1000000,10000000,50000000] [-q queries] [-s seed] [-H]
+
+// arr(오름차순 n개)에 key가 있는지. 남은 구간의 절반을 조건부 이동으로 줄여 분기 예측 실패가 없음
+static int sorted_find(const key_t *arr, size_t n, const key_t key) {
+    const key_t *base = arr;
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = base[half] <= key ? base + half : base;
+        n -= half;
+    }
+    return n == 1 && *base == key;
+}
+
+static int run_case(const size_t n, const size_t queries, const uint64_t seed) {
+    key_t *arr = malloc(n * sizeof(key_t)), *probe = malloc(queries * sizeof(key_t));
+    if (arr == NULL || probe == NULL) {
+        fprintf(stderr, "bench-frozen: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        arr[i] = (key_t)(2 * i);
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < queries; i++) {
+        probe[i] = (key_t)(bench_rand(&state) % (2 * n));
+    }
+    rbtree *t = rbtree_from_sorted(arr, n);
+    if (t == NULL) {
+        fprintf(stderr, "bench-frozen: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+
+    uint64_t start = bench_now_ns();
+    rbtree_frozen *f = rbtree_freeze(t);
+    if (f == NULL) {
+        fprintf(stderr, "bench-frozen: rbtree_freeze failed (n=%zu)\n", n);
+        return -1;
+    }
+    bench_report("frozen", "freeze", "random", n, 1, n, bench_now_ns() - start);
+
+    size_t hits[3] = {0, 0, 0}; // 찾은 개수를 결과로 쓰고, 세 구조가 같은 답을 냈는지도 확인
+    start = bench_now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        hits[0] += rbtree_find(t, probe[i]) != NULL;
+    }
+    bench_report("frozen", "find_rbtree", "random", n, 1, queries, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        hits[1] += sorted_find(arr, n, probe[i]);
+    }
+    bench_report("frozen", "find_sorted", "random", n, 1, queries, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        hits[2] += rbtree_frozen_find(f, probe[i]);
+    }
+    bench_report("frozen", "find_frozen", "random", n, 1, queries, bench_now_ns() - start);
+    if (hits[0] != hits[1] || hits[0] != hits[2]) {
+        fprintf(stderr, "bench-frozen: results differ (%zu, %zu, %zu)\n", hits[0], hits[1], hits[2]);
+        return -1;
+    }
+
+    rbtree_frozen_free(f);
+    delete_rbtree(t);
+    free(probe);
+    free(arr);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-q queries] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts (default 1000000,10000000,50000000)\n");
+    fprintf(stderr, "  -q  random lookups per structure (default 5000000)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000000, 10000000, 50000000};
+    size_t n_sizes = 3, queries = 5000000;
+    bool header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:q:s:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n_sizes = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_sizes < 16; tok = strtok(NULL, ",")) {
+                sizes[n_sizes] = strtoull(tok, NULL, 10);
+                if (sizes[n_sizes] == 0 || sizes[n_sizes] > 1000000000) { // 키 2n이 int에 들어가야 함
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+            }
+            break;
+        case 'q':
+            queries = strtoull(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (queries == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        // 크기마다 자식 프로세스에서 측정해서 peak_rss_kb가 그 크기만의 최대 메모리가 되게 함
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(run_case(sizes[s], queries, seed) == 0 ? 0 : 1);
+        }
+        int status;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "bench-frozen: case n=%zu failed\n", sizes[s]);
+            return 1;
+        }
+    }
+    return 0;
+}
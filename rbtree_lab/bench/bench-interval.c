@@ -0,0 +1,184 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 구간 트리 모드(-DRBTREE_INTERVAL)의 겹침 질의 벤치마크
+// 구간 n개 : 시작점은 [0, 16n)에서 무작위, 길이는 [0, l) 에서 무작위
+// 폭이 w인 무작위 질의 [lo, lo + w]와 겹치는 구간의 개수를 두 가지 방법으로 세어 비교
+//   insert  : rbtree_insert_interval n번 (max_end를 함께 갱신하는 비용, ops = n)
+//   overlap : rbtree_overlap (max_end로 서브트리를 건너뛰는 중위 순회)
+//   scan    : 트리를 시작점 순서의 (start, end) 배열로 내보낸 뒤 선형 탐색 (start > hi에서 멈춤)
+//             rbtree_to_array는 시작점만 옮기므로 끝점까지 rbtree_range로 옮기고, 옮기는 시간은 재지 않음
+// scan은 질의 하나가 O(n)이라 질의 수의 1/100만 수행하고, 두 방법이 그 질의들에서 같은 개수를 냈는지 확인
+// pattern 열은 질의 폭 (width_w)
+//
+// 사용법 : ./bench-interval [-n 1000000] [-w 0,1000,100000] [-l 1000] [-q queries] [-s seed] [-H]
+
+typedef struct {
+    key_t *start, *end;
+    size_t count;
+} export_ctx;
+
+static int export_span(node_t *p, void *ctx) {
+    export_ctx *c = (export_ctx *)ctx;
+    c->start[c->count] = p->key;
+    c->end[c->count++] = p->end;
+    return 0;
+}
+
+static int count_span(node_t *p, void *ctx) {
+    (void)p;
+    (*(size_t *)ctx)++;
+    return 0;
+}
+
+static int run_case(const size_t n, const size_t *widths, const size_t n_widths, const size_t len,
+                    const size_t queries, const uint64_t seed) {
+    key_t *start = malloc(n * sizeof(key_t)), *end = malloc(n * sizeof(key_t));
+    key_t *probe = malloc(queries * sizeof(key_t));
+    rbtree *t = new_rbtree_with_pool(n);
+    if (start == NULL || end == NULL || probe == NULL || t == NULL) {
+        fprintf(stderr, "bench-interval: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < n; i++) {
+        start[i] = (key_t)(bench_rand(&state) % (16 * n));
+        end[i] = start[i] + (key_t)(bench_rand(&state) % len);
+    }
+    uint64_t begin = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+        if (rbtree_insert_interval(t, start[i], end[i]) == NULL) {
+            fprintf(stderr, "bench-interval: out of memory (n=%zu)\n", n);
+            return -1;
+        }
+    }
+    bench_report("interval", "insert", "random", n, 1, n, bench_now_ns() - begin);
+
+    export_ctx ex = {.start = start, .end = end, .count = 0}; // 선형 탐색용 배열 (시작점 오름차순)
+    rbtree_range(t, INT_MIN, INT_MAX, export_span, &ex);
+
+    const size_t scans = queries / 100 > 0 ? queries / 100 : 1;
+    for (size_t w = 0; w < n_widths; w++) {
+        char pattern[32];
+        snprintf(pattern, sizeof(pattern), "width_%zu", widths[w]);
+        for (size_t i = 0; i < queries; i++) {
+            probe[i] = (key_t)(bench_rand(&state) % (16 * n));
+        }
+        const key_t width = (key_t)widths[w];
+
+        size_t hits = 0, hits_scanned = 0; // hits_scanned : scan도 수행하는 앞쪽 질의들의 결과만
+        begin = bench_now_ns();
+        for (size_t i = 0; i < queries; i++) {
+            rbtree_overlap(t, probe[i], probe[i] + width, count_span, &hits);
+            if (i + 1 == scans) {
+                hits_scanned = hits;
+            }
+        }
+        bench_report("interval", "overlap", pattern, n, 1, queries, bench_now_ns() - begin);
+
+        size_t found = 0;
+        begin = bench_now_ns();
+        for (size_t i = 0; i < scans; i++) {
+            const key_t lo = probe[i], hi = probe[i] + width;
+            for (size_t j = 0; j < n && start[j] <= hi; j++) {
+                found += end[j] >= lo;
+            }
+        }
+        bench_report("interval", "scan", pattern, n, 1, scans, bench_now_ns() - begin);
+        if (found != hits_scanned) {
+            fprintf(stderr, "bench-interval: results differ (%zu, %zu)\n", hits_scanned, found);
+            return -1;
+        }
+    }
+    delete_rbtree(t);
+    free(probe);
+    free(end);
+    free(start);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-w widths] [-l length] [-q queries] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated interval counts (default 1000000)\n");
+    fprintf(stderr, "  -w  comma separated query widths (default 0,1000,100000)\n");
+    fprintf(stderr, "  -l  intervals are [start, start + x) with x random below this (default 1000)\n");
+    fprintf(stderr, "  -q  overlap queries per width, the linear scan runs 1/100 of them (default 100000)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+// 쉼표로 구분한 정수 목록을 읽음. 형식이 틀리거나 limit을 넘으면 -1 (zero가 0이면 0도 거절)
+static int parse_list(char *arg, size_t *out, size_t *count, const size_t limit, const int zero) {
+    *count = 0;
+    for (char *tok = strtok(arg, ","); tok != NULL && *count < 16; tok = strtok(NULL, ",")) {
+        out[*count] = strtoull(tok, NULL, 10);
+        if ((out[*count] == 0 && !zero) || out[*count] > limit) {
+            return -1;
+        }
+        (*count)++;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000000}, widths[16] = {0, 1000, 100000};
+    size_t n_sizes = 1, n_widths = 3, len = 1000, queries = 100000;
+    bool header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:l:q:s:Hh")) != -1) {
+        int bad = 0;
+        size_t one;
+        switch (opt) {
+        case 'n':
+            bad = parse_list(optarg, sizes, &n_sizes, 100000000, 0); // 끝점 16n + l + w가 int에 들어가야 함
+            break;
+        case 'w':
+            bad = parse_list(optarg, widths, &n_widths, 100000000, 1);
+            break;
+        case 'l':
+            bad = parse_list(optarg, &len, &one, 100000000, 0);
+            break;
+        case 'q':
+            queries = strtoull(optarg, NULL, 10);
+            bad = queries == 0;
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (bad) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        // 크기마다 자식 프로세스에서 측정해서 peak_rss_kb가 그 크기만의 최대 메모리가 되게 함
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(run_case(sizes[s], widths, n_widths, len, queries, seed) == 0 ? 0 : 1);
+        }
+        int status;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "bench-interval: case n=%zu failed\n", sizes[s]);
+            return 1;
+        }
+    }
+    return 0;
+}
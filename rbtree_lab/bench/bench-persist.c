@@ -0,0 +1,177 @@
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 저장/재시작 벤치마크
+// 키 n개가 든 트리를 파일로 저장했다가 다시 트리로 만드는 시간을 두 가지 방식으로 비교
+//   save / load         : rbtree_save(차이를 가변 길이 정수로) / rbtree_load(mmap + O(n) 균형 트리 구성)
+//   save_raw / reinsert : 지금 방식. rbtree_to_array 결과를 그대로 쓰고, 읽어서 rbtree_insert를 n번
+// 파일은 방금 쓴 것이라 페이지 캐시에 있으므로 load 시간은 디스크가 아니라 해석과 트리 구성 비용
+// 파일 크기는 CSV 열에 없으므로 stderr에 따로 출력
+// 키는 0..n-1의 무작위 순열에 INT_MAX / n을 곱해 32비트 범위에 고르게 퍼뜨림 (-d면 곱하지 않은 촘촘한 키)
+//
+// 사용법 : ./bench-persist [-n 1000000,10000000] [-d] [-s seed] [-H]
+
+// 크기를 알 수 없는 임시 파일을 만들고 바로 지움 (fd가 닫히면 사라짐)
+static int temp_fd(void) {
+    char path[] = "/tmp/bench-persist-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    return fd;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w <= 0) {
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t r = read(fd, p, len);
+        if (r <= 0) {
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+static int run_case(const size_t n, const bool dense, const uint64_t seed) {
+    key_t *keys = bench_make_keys(PATTERN_RANDOM, n, seed);
+    key_t *arr = malloc(n * sizeof(key_t));
+    rbtree *t = new_rbtree();
+    const int fd = temp_fd(), raw_fd = temp_fd();
+    if (keys == NULL || arr == NULL || t == NULL || fd < 0 || raw_fd < 0) {
+        fprintf(stderr, "bench-persist: setup failed (n=%zu)\n", n);
+        return -1;
+    }
+    const key_t stride = dense ? 1 : (key_t)(2147483647 / n);
+    for (size_t i = 0; i < n; i++) {
+        rbtree_insert(t, keys[i] * stride);
+    }
+
+    uint64_t start = bench_now_ns();
+    if (rbtree_save(t, fd) != 0) {
+        fprintf(stderr, "bench-persist: rbtree_save failed\n");
+        return -1;
+    }
+    bench_report("persist", "save", "random", n, 1, n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    rbtree *u = rbtree_load(fd);
+    uint64_t ns = bench_now_ns() - start;
+    if (u == NULL) {
+        fprintf(stderr, "bench-persist: rbtree_load failed\n");
+        return -1;
+    }
+    bench_report("persist", "load", "random", n, 1, n, ns);
+    delete_rbtree(u);
+
+    start = bench_now_ns();
+    rbtree_to_array(t, arr, n);
+    if (write_full(raw_fd, arr, n * sizeof(key_t)) != 0) {
+        fprintf(stderr, "bench-persist: write failed\n");
+        return -1;
+    }
+    bench_report("persist", "save_raw", "random", n, 1, n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    if (lseek(raw_fd, 0, SEEK_SET) != 0 || read_full(raw_fd, arr, n * sizeof(key_t)) != 0) {
+        fprintf(stderr, "bench-persist: read failed\n");
+        return -1;
+    }
+    u = new_rbtree();
+    for (size_t i = 0; i < n; i++) {
+        rbtree_insert(u, arr[i]);
+    }
+    bench_report("persist", "reinsert", "random", n, 1, n, bench_now_ns() - start);
+    delete_rbtree(u);
+
+    const double saved = (double)lseek(fd, 0, SEEK_END), raw = (double)lseek(raw_fd, 0, SEEK_END);
+    fprintf(stderr, "bench-persist: n=%zu %s keys: rbtree_save %.1f MB (%.2f B/key), raw %.1f MB (%.2f B/key)\n", n,
+            dense ? "dense" : "spread", saved / 1e6, saved / n, raw / 1e6, raw / n);
+
+    close(raw_fd);
+    close(fd);
+    delete_rbtree(t);
+    free(arr);
+    free(keys);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-d] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts (default 1000000,10000000)\n");
+    fprintf(stderr, "  -d  dense keys 0..n-1 instead of keys spread over the 32-bit range\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000000, 10000000};
+    size_t n_sizes = 2;
+    bool dense = false, header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:ds:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n_sizes = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_sizes < 16; tok = strtok(NULL, ",")) {
+                sizes[n_sizes] = strtoull(tok, NULL, 10);
+                if (sizes[n_sizes] == 0 || sizes[n_sizes] > 2147483647) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+            }
+            break;
+        case 'd':
+            dense = true;
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        // 크기마다 자식 프로세스에서 측정해서 peak_rss_kb가 그 크기만의 최대 메모리가 되게 함
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(run_case(sizes[s], dense, seed) == 0 ? 0 : 1);
+        }
+        int status;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "bench-persist: case n=%zu failed\n", sizes[s]);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,360 @@
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 기본 연산 벤치마크 (_par 작업만 스레드 풀을 쓰고 나머지는 단일 스레드)
+// 크기(n) x 키 패턴마다 아래 작업을 순서대로 측정하고 CSV로 출력
+//   insert   : 빈 트리에 키 n개 삽입
+//   insert_hint : 빈 트리에 같은 키 n개를 직전에 넣은 노드를 힌트로 삽입 (rbtree_insert_hint)
+//   find     : 같은 키 n개를 같은 순서로 탐색 (모두 존재)
+//   minmax   : rbtree_min / rbtree_max를 번갈아 n번
+//   lower_bound : 키 n개 각각에 1을 더한 값으로 rbtree_lower_bound (대부분 트리에 없는 값 -> 가장 가까운 다음 키)
+//   to_array : 전체를 배열로 (원소 하나를 연산 하나로 셈)
+//   to_array_par : 같은 일을 rbtree_to_array_par로 (threads = 스레드 풀 크기)
+//   erase    : 같은 키 n개를 찾아서 삭제 (rbtree_find + rbtree_erase)
+//   erase_key : 같은 키 n개를 rbtree_erase_key로 삭제 (한 번만 내려감)
+//   erase_scan : 최솟값부터 훑으며 두 노드 중 하나꼴로 지움 (rbtree_erase_next, 남기는 노드는 rbtree_next)
+//   erase_range : 키 n개가 든 트리를 키 범위 16등분씩 rbtree_erase_range로 비움 (지운 키 하나를 연산 하나로 셈)
+//   mixed    : 키 n개가 든 트리에서 find 50%, insert 25%, erase 25%를 섞어 n번
+//   delete / delete_par : 키 n개가 든 트리를 delete_rbtree / delete_rbtree_par로 해제 (노드 하나를 연산 하나로 셈)
+// (크기, 패턴) 한 경우를 fork한 자식 프로세스에서 돌려서 peak_rss_kb가 그 경우만의 최대 메모리가 되게 함
+//
+// 사용법 : ./bench-rbtree [-n 1000,1000000] [-p random,zipf] [-w insert,find] [-s seed] [-H]
+// 인자를 생략하면 1K, 1M, 10M 키에 대해 모든 패턴과 작업을 측정
+
+// n이 작으면 한 번의 측정이 너무 짧아 시계 오차가 커지므로, 연산 수가 이만큼 될 때까지 같은 경우를 반복
+#define BENCH_MIN_OPS (1u << 20)
+
+typedef enum {
+    W_INSERT,
+    W_INSERT_HINT,
+    W_FIND,
+    W_MINMAX,
+    W_LOWER_BOUND,
+    W_TO_ARRAY,
+    W_TO_ARRAY_PAR,
+    W_ERASE,
+    W_ERASE_KEY,
+    W_ERASE_SCAN,
+    W_ERASE_RANGE,
+    W_MIXED,
+    W_DELETE,
+    W_DELETE_PAR,
+    W_COUNT
+} workload_t;
+
+static const char *const workload_names[W_COUNT] = {
+    "insert",    "insert_hint", "find",       "minmax",      "lower_bound", "to_array", "to_array_par",
+    "erase",     "erase_key",   "erase_scan", "erase_range", "mixed",       "delete",   "delete_par"};
+
+// 작업별 누적 연산 수와 시간
+typedef struct {
+    size_t ops;
+    uint64_t ns;
+} acc_t;
+
+// 결과를 쓰지 않는 탐색이 컴파일러 최적화로 사라지지 않도록 여기에 모아둠
+static volatile size_t sink;
+
+// 스레드 풀의 스레드 수 (rbtree.c와 같이 RBTREE_THREADS가 있으면 그 값, 없으면 CPU 수)
+static int pool_threads(void) {
+    const char *env = getenv("RBTREE_THREADS");
+    return env != NULL && atoi(env) > 0 ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void run_case(const bench_pattern_t pattern, const size_t n, const uint64_t seed, const bool *enabled) {
+    key_t *keys = bench_make_keys(pattern, n, seed);
+    key_t *arr = malloc(n * sizeof(key_t));
+    unsigned char *ops = malloc(n); // mixed 작업의 연산 순서는 미리 만들어 두어 난수 생성 시간을 빼고 잼
+    if (keys == NULL || arr == NULL || ops == NULL) {
+        fprintf(stderr, "bench-rbtree: out of memory (n=%zu)\n", n);
+        exit(1);
+    }
+    uint64_t state = seed ^ 0x5bd1e995u;
+    for (size_t i = 0; i < n; i++) {
+        ops[i] = bench_rand(&state) & 3; // 0, 1 : find / 2 : insert / 3 : erase
+    }
+
+    acc_t acc[W_COUNT] = {{0}};
+    const size_t rounds = n >= BENCH_MIN_OPS ? 1 : BENCH_MIN_OPS / n;
+    for (size_t r = 0; r < rounds; r++) {
+        // insert는 다른 작업의 트리를 만드는 단계이기도 하므로 항상 실행
+        rbtree *t = new_rbtree();
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < n; i++) {
+            rbtree_insert(t, keys[i]);
+        }
+        acc[W_INSERT].ns += bench_now_ns() - start;
+        acc[W_INSERT].ops += n;
+        // erase_key용 트리도 여기서 만듦 -> 해제했던 메모리를 다시 받아 만든 트리는 노드가 흩어져 erase와 비교가 안 됨
+        rbtree *u = new_rbtree();
+        for (size_t i = 0; i < n && enabled[W_ERASE_KEY]; i++) {
+            rbtree_insert(u, keys[i]);
+        }
+
+        if (enabled[W_INSERT_HINT]) {
+            rbtree *v = new_rbtree();
+            node_t *hint = NULL;
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                hint = rbtree_insert_hint(v, hint, keys[i]); // 정렬된 키는 탐색 없이, 무작위 키는 루트부터
+            }
+            acc[W_INSERT_HINT].ns += bench_now_ns() - start;
+            acc[W_INSERT_HINT].ops += n;
+            delete_rbtree(v);
+        }
+
+        if (enabled[W_FIND]) {
+            size_t found = 0;
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                found += rbtree_find(t, keys[i]) != NULL;
+            }
+            acc[W_FIND].ns += bench_now_ns() - start;
+            acc[W_FIND].ops += n;
+            sink += found;
+        }
+
+        if (enabled[W_MINMAX]) {
+            key_t sum = 0;
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                sum += (i & 1 ? rbtree_max(t) : rbtree_min(t))->key;
+            }
+            acc[W_MINMAX].ns += bench_now_ns() - start;
+            acc[W_MINMAX].ops += n;
+            sink += sum;
+        }
+
+        if (enabled[W_LOWER_BOUND]) {
+            size_t found = 0;
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                found += rbtree_lower_bound(t, keys[i] + 1) != NULL;
+            }
+            acc[W_LOWER_BOUND].ns += bench_now_ns() - start;
+            acc[W_LOWER_BOUND].ops += n;
+            sink += found;
+        }
+
+        if (enabled[W_TO_ARRAY]) {
+            start = bench_now_ns();
+            rbtree_to_array(t, arr, n);
+            acc[W_TO_ARRAY].ns += bench_now_ns() - start;
+            acc[W_TO_ARRAY].ops += n;
+            sink += arr[n / 2];
+        }
+
+        if (enabled[W_TO_ARRAY_PAR]) {
+            start = bench_now_ns();
+            rbtree_to_array_par(t, arr, n);
+            acc[W_TO_ARRAY_PAR].ns += bench_now_ns() - start;
+            acc[W_TO_ARRAY_PAR].ops += n;
+            sink += arr[n / 2];
+        }
+
+        if (enabled[W_ERASE]) {
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                rbtree_erase(t, rbtree_find(t, keys[i])); // 넣은 키를 그대로 지우므로 항상 찾아짐
+            }
+            acc[W_ERASE].ns += bench_now_ns() - start;
+            acc[W_ERASE].ops += n;
+        }
+        delete_rbtree(t);
+
+        if (enabled[W_ERASE_KEY]) {
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                rbtree_erase_key(u, keys[i]);
+            }
+            acc[W_ERASE_KEY].ns += bench_now_ns() - start;
+            acc[W_ERASE_KEY].ops += n;
+        }
+        delete_rbtree(u);
+
+        if (enabled[W_ERASE_SCAN]) {
+            t = new_rbtree();
+            for (size_t i = 0; i < n; i++) {
+                rbtree_insert(t, keys[i]);
+            }
+            size_t visited = 0;
+            start = bench_now_ns();
+            for (node_t *p = rbtree_min(t); p != NULL; visited++) {
+                p = ops[visited] & 1 ? rbtree_erase_next(t, p) : rbtree_next(t, p);
+            }
+            acc[W_ERASE_SCAN].ns += bench_now_ns() - start;
+            acc[W_ERASE_SCAN].ops += visited;
+            delete_rbtree(t);
+        }
+
+        if (enabled[W_ERASE_RANGE]) {
+            t = new_rbtree();
+            key_t lo = keys[0], hi = keys[0];
+            for (size_t i = 0; i < n; i++) {
+                rbtree_insert(t, keys[i]);
+                lo = keys[i] < lo ? keys[i] : lo;
+                hi = keys[i] > hi ? keys[i] : hi;
+            }
+            const int64_t width = ((int64_t)hi - lo) / 16 + 1;
+            size_t erased = 0;
+            start = bench_now_ns();
+            for (int64_t from = lo; from <= hi; from += width) {
+                const int64_t to = from + width - 1 < hi ? from + width - 1 : hi;
+                erased += rbtree_erase_range(t, (key_t)from, (key_t)to);
+            }
+            acc[W_ERASE_RANGE].ns += bench_now_ns() - start;
+            acc[W_ERASE_RANGE].ops += erased;
+            delete_rbtree(t);
+        }
+
+        if (enabled[W_MIXED]) {
+            t = new_rbtree();
+            for (size_t i = 0; i < n; i++) {
+                rbtree_insert(t, keys[i]);
+            }
+            size_t found = 0;
+            start = bench_now_ns();
+            for (size_t i = 0; i < n; i++) {
+                const key_t key = keys[n - 1 - i]; // 삽입 순서와 다른 순서로 접근
+                if (ops[i] < 2) {
+                    found += rbtree_find(t, key) != NULL;
+                } else if (ops[i] == 2) {
+                    rbtree_insert(t, key);
+                } else {
+                    node_t *p = rbtree_find(t, key);
+                    if (p != NULL) {
+                        rbtree_erase(t, p);
+                    }
+                }
+            }
+            acc[W_MIXED].ns += bench_now_ns() - start;
+            acc[W_MIXED].ops += n;
+            sink += found;
+            delete_rbtree(t);
+        }
+
+        for (int w = W_DELETE; w <= W_DELETE_PAR; w++) {
+            if (!enabled[w]) {
+                continue;
+            }
+            t = new_rbtree();
+            for (size_t i = 0; i < n; i++) {
+                rbtree_insert(t, keys[i]);
+            }
+            start = bench_now_ns();
+            (w == W_DELETE ? delete_rbtree : delete_rbtree_par)(t);
+            acc[w].ns += bench_now_ns() - start;
+            acc[w].ops += n;
+        }
+    }
+
+    for (int w = 0; w < W_COUNT; w++) {
+        if (enabled[w]) {
+            const int threads = w == W_TO_ARRAY_PAR || w == W_DELETE_PAR ? pool_threads() : 1;
+            bench_report("rbtree", workload_names[w], bench_pattern_names[pattern], n, threads, acc[w].ops, acc[w].ns);
+        }
+    }
+    free(ops);
+    free(arr);
+    free(keys);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-p patterns] [-w workloads] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts (default 1000,1000000,10000000)\n");
+    fprintf(stderr, "  -p  sequential,reverse,random,zipf (default all)\n");
+    fprintf(stderr, "  -w  insert,insert_hint,find,minmax,lower_bound,to_array,to_array_par,erase,erase_key,\n");
+    fprintf(stderr, "      erase_scan,erase_range,mixed,delete,delete_par (default all)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000, 1000000, 10000000};
+    size_t n_sizes = 3;
+    bool patterns[PATTERN_COUNT] = {true, true, true, true};
+    bool enabled[W_COUNT];
+    for (int w = 0; w < W_COUNT; w++) {
+        enabled[w] = true;
+    }
+    uint64_t seed = 17;
+    bool header = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:w:s:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n_sizes = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_sizes < 16; tok = strtok(NULL, ",")) {
+                sizes[n_sizes] = strtoull(tok, NULL, 10);
+                if (sizes[n_sizes] == 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+            }
+            break;
+        case 'p':
+            memset(patterns, 0, sizeof(patterns));
+            for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                int p = bench_pattern_parse(tok);
+                if (p < 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                patterns[p] = true;
+            }
+            break;
+        case 'w':
+            memset(enabled, 0, sizeof(enabled));
+            for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                int w = 0;
+                while (w < W_COUNT && strcmp(tok, workload_names[w]) != 0) {
+                    w++;
+                }
+                if (w == W_COUNT) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                enabled[w] = true;
+            }
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        for (int p = 0; p < PATTERN_COUNT; p++) {
+            if (!patterns[p]) {
+                continue;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                run_case(p, sizes[s], seed, enabled);
+                exit(0);
+            }
+            int status;
+            if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                fprintf(stderr, "bench-rbtree: case n=%zu pattern=%s failed\n", sizes[s], bench_pattern_names[p]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
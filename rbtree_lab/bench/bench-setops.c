@@ -0,0 +1,193 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 집합 연산(rbtree_union / rbtree_intersect / rbtree_difference) 벤치마크
+// 키 n개짜리 트리 a와 m개짜리 트리 b : i번째 키를 2i 또는 2i + 1 중 무작위로 골라 두 트리의 키가 약 절반 겹침
+// 같은 결과를 두 가지 방법으로 만들어 비교
+//   union / intersect / difference : join 기반 분할 정복 (두 재귀를 스레드 풀에서 동시에)
+//   *_merge : rbtree_to_array 두 번 + 배열 병합 + rbtree_from_sorted (O(n + m), 한 스레드)
+// 트리는 rbtree_from_sorted로 만들고 만드는 시간은 재지 않음. ops = n + m
+// 스레드 수마다 자식 프로세스에서 RBTREE_THREADS를 정해 측정 (스레드 풀은 처음 쓸 때 한 번만 만들어짐)
+// 배열 병합은 한 스레드로만 돌므로 첫 번째 스레드 수에서 한 번만 잼
+// b가 작을수록(-r) 분할 정복은 O(m log(n / m))으로 줄지만 배열 병합은 O(n)으로 그대로
+//
+// 사용법 : ./bench-setops [-n 1000000,10000000] [-r 1,100] [-t 1,2,4,8] [-s seed] [-H]
+
+static const char *const op_names[3] = {"union", "intersect", "difference"};
+static const char *const merge_names[3] = {"union_merge", "intersect_merge", "difference_merge"};
+
+// 정렬된 두 배열(중복 없음)을 op에 따라 병합해 out에 쓰고 개수를 반환
+static size_t merge_sorted(const key_t *a, const size_t n, const key_t *b, const size_t m, const int op, key_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < n && j < m) {
+        if (a[i] < b[j]) {
+            out[k] = a[i++];
+            k += op != 1;
+        } else if (b[j] < a[i]) {
+            out[k] = b[j++];
+            k += op == 0;
+        } else {
+            out[k] = a[i++];
+            j++;
+            k += op != 2;
+        }
+    }
+    for (; i < n && op != 1; i++) {
+        out[k++] = a[i];
+    }
+    for (; j < m && op == 0; j++) {
+        out[k++] = b[j];
+    }
+    return k;
+}
+
+static int count_node(node_t *p, void *ctx) {
+    (void)p;
+    (*(size_t *)ctx)++;
+    return 0;
+}
+
+static int run_case(const size_t n, const size_t m, const int threads, const bool with_merge, const uint64_t seed) {
+    key_t *a = malloc(n * sizeof(key_t)), *b = malloc(m * sizeof(key_t));
+    key_t *ra = malloc(n * sizeof(key_t)), *rb = malloc(m * sizeof(key_t)), *out = malloc((n + m) * sizeof(key_t));
+    if (a == NULL || b == NULL || ra == NULL || rb == NULL || out == NULL) {
+        fprintf(stderr, "bench-setops: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < n; i++) {
+        a[i] = (key_t)(2 * i + (bench_rand(&state) & 1));
+    }
+    const size_t stride = n / m; // b는 a와 같은 키 범위에 고르게 퍼지게 함
+    for (size_t i = 0; i < m; i++) {
+        b[i] = (key_t)(2 * i * stride + (bench_rand(&state) & 1));
+    }
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "ratio_%zu", n / m);
+
+    for (int op = 0; op < 3; op++) {
+        const size_t expect = merge_sorted(a, n, b, m, op, out);
+        for (int merge = 0; merge < 1 + with_merge; merge++) {
+            rbtree *t1 = rbtree_from_sorted(a, n), *t2 = rbtree_from_sorted(b, m);
+            if (t1 == NULL || t2 == NULL) {
+                fprintf(stderr, "bench-setops: out of memory (n=%zu)\n", n);
+                return -1;
+            }
+            const uint64_t start = bench_now_ns();
+            if (merge) {
+                rbtree_to_array(t1, ra, n);
+                rbtree_to_array(t2, rb, m);
+                const size_t k = merge_sorted(ra, n, rb, m, op, out);
+                delete_rbtree(t1);
+                delete_rbtree(t2);
+                t1 = rbtree_from_sorted(out, k);
+            } else if ((op == 0 ? rbtree_union : op == 1 ? rbtree_intersect : rbtree_difference)(t1, t2) != 0) {
+                t1 = NULL;
+            }
+            const uint64_t ns = bench_now_ns() - start;
+            size_t count = 0; // 두 방법이 같은 개수의 키를 남겼는지 확인 (재지 않는 구간)
+            if (t1 == NULL || (rbtree_range(t1, INT_MIN, INT_MAX, count_node, &count), count != expect)) {
+                fprintf(stderr, "bench-setops: %s failed (n=%zu)\n", merge ? merge_names[op] : op_names[op], n);
+                return -1;
+            }
+            bench_report("setops", merge ? merge_names[op] : op_names[op], pattern, n, merge ? 1 : threads, n + m, ns);
+            delete_rbtree(t1);
+        }
+    }
+    free(out);
+    free(rb);
+    free(ra);
+    free(b);
+    free(a);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-r ratios] [-t threads] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts of the larger tree (default 1000000,10000000)\n");
+    fprintf(stderr, "  -r  comma separated size ratios n / m of the two trees (default 1,100)\n");
+    fprintf(stderr, "  -t  comma separated thread counts for the tree operations (default 1,2,4,8)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+// 쉼표로 구분한 양의 정수 목록을 읽음. 형식이 틀리거나 limit을 넘으면 -1
+static int parse_list(char *arg, size_t *out, size_t *count, const size_t limit) {
+    *count = 0;
+    for (char *tok = strtok(arg, ","); tok != NULL && *count < 16; tok = strtok(NULL, ",")) {
+        out[*count] = strtoull(tok, NULL, 10);
+        if (out[*count] == 0 || out[*count] > limit) {
+            return -1;
+        }
+        (*count)++;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000000, 10000000}, ratios[16] = {1, 100}, threads[16] = {1, 2, 4, 8};
+    size_t n_sizes = 2, n_ratios = 2, n_threads = 4;
+    bool header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:t:s:Hh")) != -1) {
+        int bad = 0;
+        switch (opt) {
+        case 'n':
+            bad = parse_list(optarg, sizes, &n_sizes, 1000000000); // 키 2n이 int에 들어가야 함
+            break;
+        case 'r':
+            bad = parse_list(optarg, ratios, &n_ratios, 1000000);
+            break;
+        case 't':
+            bad = parse_list(optarg, threads, &n_threads, 64);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (bad) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        for (size_t r = 0; r < n_ratios; r++) {
+            for (size_t k = 0; k < n_threads; k++) {
+                if (ratios[r] > sizes[s]) {
+                    continue;
+                }
+                // 스레드 수마다 자식 프로세스에서 측정 : 스레드 풀은 프로세스에서 처음 쓸 때 RBTREE_THREADS를 읽음
+                pid_t pid = fork();
+                if (pid == 0) {
+                    char env[16];
+                    snprintf(env, sizeof(env), "%zu", threads[k]);
+                    setenv("RBTREE_THREADS", env, 1);
+                    exit(run_case(sizes[s], sizes[s] / ratios[r], (int)threads[k], k == 0, seed) == 0 ? 0 : 1);
+                }
+                int status;
+                if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    fprintf(stderr, "bench-setops: case n=%zu failed\n", sizes[s]);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
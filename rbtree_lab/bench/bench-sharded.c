@@ -0,0 +1,166 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "sharded_rbtree.h"
+
+// sharded_rbtree 다중 스레드 삽입/삭제 처리량 벤치마크
+// 키 n개(0..n-1을 -p 패턴 순서로 나열)를 스레드 T개가 나눠서 동시에 삽입한 뒤, 같은 키를 다시 나눠서 동시에 삭제
+// sequential이면 스레드마다 연속된 키 구간을 맡으므로, 구간 sharding에서 스레드가 서로 다른 shard에 몰리는 경우가 됨
+// shard 1개는 트리 전체를 락 하나로 감싼 것과 같으므로 그것과 비교해 shard를 늘렸을 때 얼마나 늘어나는지 봄
+// 출력 workload : insert_<hash|range><shard 수>, erase_<hash|range><shard 수>
+//
+// 사용법 : ./bench-sharded [-n keys] [-t 1,2,4,8,16,32] [-S 1,64] [-m hash,range] [-p random] [-s seed] [-H]
+
+#define MAX_THREADS 64
+
+typedef struct {
+    sharded_rbtree *st;
+    const key_t *keys;
+    size_t count;
+    int erase; // 0 : 삽입, 1 : 삭제
+    int *start;
+} worker_t;
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    while (!__atomic_load_n(w->start, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    for (size_t i = 0; i < w->count; i++) {
+        if (w->erase) {
+            sharded_rbtree_erase(w->st, w->keys[i]);
+        } else {
+            sharded_rbtree_insert(w->st, w->keys[i]);
+        }
+    }
+    return NULL;
+}
+
+// 스레드 threads개가 keys를 나눠서 한 단계(삽입 또는 삭제)를 수행하고 걸린 시간(ns)을 반환
+static uint64_t run_phase(sharded_rbtree *st, const key_t *keys, const size_t n, const int threads, const int erase) {
+    pthread_t th[MAX_THREADS];
+    worker_t w[MAX_THREADS];
+    int start = 0;
+    const size_t chunk = n / threads;
+    for (int i = 0; i < threads; i++) {
+        w[i] = (worker_t){st, keys + i * chunk, i == threads - 1 ? n - i * chunk : chunk, erase, &start};
+        if (pthread_create(&th[i], NULL, worker_main, &w[i]) != 0) {
+            fprintf(stderr, "bench-sharded: pthread_create failed\n");
+            exit(1);
+        }
+    }
+    uint64_t begin = bench_now_ns();
+    __atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < threads; i++) {
+        pthread_join(th[i], NULL);
+    }
+    return bench_now_ns() - begin;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n keys] [-t threads] [-S shards] [-m modes] [-p pattern] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  keys inserted and erased per case (default 1000000)\n");
+    fprintf(stderr, "  -t  comma separated thread counts (default 1,2,4,8,16,32)\n");
+    fprintf(stderr, "  -S  comma separated shard counts (default 1,64)\n");
+    fprintf(stderr, "  -m  hash,range (default both)\n");
+    fprintf(stderr, "  -p  key order: sequential, reverse or random (default random)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+// "1,2,4" 형식의 목록을 읽음. 범위를 벗어난 값이 있으면 -1
+static int parse_list(char *arg, int *out, const int max_count, const int max_value) {
+    int count = 0;
+    for (char *tok = strtok(arg, ","); tok != NULL && count < max_count; tok = strtok(NULL, ",")) {
+        out[count] = atoi(tok);
+        if (out[count] < 1 || out[count] > max_value) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = 1000000;
+    int threads[16] = {1, 2, 4, 8, 16, 32}, shards[16] = {1, 64};
+    int n_threads = 6, n_shards = 2;
+    int pattern = PATTERN_RANDOM;
+    bool hash = true, range = true, header = true;
+    uint64_t seed = 17;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:S:m:p:s:Hh")) != -1) {
+        switch (opt) {
+        case 'n':
+            n = strtoull(optarg, NULL, 10);
+            break;
+        case 't':
+            n_threads = parse_list(optarg, threads, 16, MAX_THREADS);
+            break;
+        case 'S':
+            n_shards = parse_list(optarg, shards, 16, 4096);
+            break;
+        case 'm':
+            hash = strstr(optarg, "hash") != NULL;
+            range = strstr(optarg, "range") != NULL;
+            break;
+        case 'p':
+            pattern = bench_pattern_parse(optarg);
+            if (pattern < 0 || pattern == PATTERN_ZIPF) { // zipf는 중복 키가 많아 삭제 단계의 키 수가 달라짐
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (n < MAX_THREADS || n_threads < 1 || n_shards < 1 || (!hash && !range)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    key_t *keys = bench_make_keys(pattern, n, seed);
+    if (keys == NULL) {
+        fprintf(stderr, "bench-sharded: out of memory (n=%zu)\n", n);
+        return 1;
+    }
+    if (header) {
+        bench_report_header();
+    }
+    for (int by_range = 0; by_range < 2; by_range++) {
+        if (by_range ? !range : !hash) {
+            continue;
+        }
+        for (int s = 0; s < n_shards; s++) {
+            char insert_name[32], erase_name[32];
+            snprintf(insert_name, sizeof(insert_name), "insert_%s%d", by_range ? "range" : "hash", shards[s]);
+            snprintf(erase_name, sizeof(erase_name), "erase_%s%d", by_range ? "range" : "hash", shards[s]);
+            for (int i = 0; i < n_threads; i++) {
+                sharded_rbtree *st = by_range ? new_sharded_rbtree_range(shards[s], 0, (key_t)n - 1)
+                                              : new_sharded_rbtree_hash(shards[s]);
+                if (st == NULL) {
+                    fprintf(stderr, "bench-sharded: out of memory\n");
+                    return 1;
+                }
+                uint64_t ns = run_phase(st, keys, n, threads[i], 0);
+                bench_report("sharded", insert_name, bench_pattern_names[pattern], n, threads[i], n, ns);
+                ns = run_phase(st, keys, n, threads[i], 1);
+                bench_report("sharded", erase_name, bench_pattern_names[pattern], n, threads[i], n, ns);
+                delete_sharded_rbtree(st);
+            }
+        }
+    }
+    free(keys);
+    return 0;
+}
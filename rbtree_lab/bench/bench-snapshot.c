@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 스냅샷 비용 벤치마크 (-DRBTREE_COW로 빌드)
+// 키 n개가 든 트리에서 "스냅샷 하나를 찍고 -> 쓰기 u번 -> 스냅샷을 버림"을 r번 반복
+// 같은 부하를 두 가지 스냅샷 방식으로 측정해서 비교
+//   copy : rbtree_to_array로 키 n개를 새 배열에 복사 (지금 서비스에서 쓰는 방식, 락을 잡은 채 O(n))
+//   cow  : rbtree_snapshot / rbtree_snapshot_release (O(1) + 쓰기 때마다 바뀐 경로만 복사)
+// 출력 workload
+//   snapshot_<방식> : 스냅샷 하나를 만들고 버리는 데 드는 시간 (ops = 스냅샷 수)
+//   update_<방식>   : 스냅샷이 살아 있는 동안의 쓰기 (키 하나를 지우고 다시 넣는 것을 연산 하나로 셈)
+// 두 줄을 더하면 스냅샷 주기 한 번의 전체 비용이 되고, update_cow - update_copy가 경로 복사의 추가 비용
+//
+// 사용법 : ./bench-snapshot [-n 1000,1000000] [-u updates] [-r snapshots] [-s seed] [-H]
+
+typedef enum { SNAP_COPY, SNAP_COW, SNAP_COUNT } snap_t;
+
+static const char *const snapshot_names[SNAP_COUNT] = {"snapshot_copy", "snapshot_cow"};
+static const char *const update_names[SNAP_COUNT] = {"update_copy", "update_cow"};
+
+// 결과를 쓰지 않는 복사가 컴파일러 최적화로 사라지지 않도록 여기에 모아둠
+static volatile size_t sink;
+
+static int run_case(const size_t n, const size_t updates, const size_t rounds, const uint64_t seed) {
+    key_t *keys = bench_make_keys(PATTERN_RANDOM, n, seed);
+    rbtree *t = new_rbtree();
+    if (keys == NULL || t == NULL) {
+        fprintf(stderr, "bench-snapshot: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        rbtree_insert(t, keys[i]);
+    }
+
+    uint64_t state = seed ^ 0x5bd1e995u;
+    for (int m = 0; m < SNAP_COUNT; m++) {
+        uint64_t snap_ns = 0, update_ns = 0;
+        for (size_t r = 0; r < rounds; r++) {
+            uint64_t start = bench_now_ns();
+            key_t *copy = NULL;
+            const rbtree *snap = NULL;
+            if (m == SNAP_COPY) {
+                copy = malloc(n * sizeof(key_t));
+                if (copy == NULL) {
+                    fprintf(stderr, "bench-snapshot: out of memory (n=%zu)\n", n);
+                    return -1;
+                }
+                rbtree_to_array(t, copy, n);
+            } else {
+                snap = rbtree_snapshot(t);
+            }
+            snap_ns += bench_now_ns() - start;
+
+            // 트리 크기를 유지하도록 있는 키를 하나 지우고 다시 넣음
+            start = bench_now_ns();
+            for (size_t i = 0; i < updates; i++) {
+                const key_t key = keys[bench_rand(&state) % n];
+                rbtree_erase(t, rbtree_find(t, key));
+                rbtree_insert(t, key);
+            }
+            update_ns += bench_now_ns() - start;
+
+            start = bench_now_ns();
+            if (m == SNAP_COPY) {
+                sink += copy[r % n];
+                free(copy);
+            } else {
+                sink += rbtree_min(snap)->key;
+                rbtree_snapshot_release(snap); // 그 사이 쓰기로 스냅샷에만 남은 옛 경로가 여기서 해제됨
+            }
+            snap_ns += bench_now_ns() - start;
+        }
+        bench_report("snapshot", snapshot_names[m], "random", n, 1, rounds, snap_ns);
+        bench_report("snapshot", update_names[m], "random", n, 1, rounds * updates, update_ns);
+    }
+    delete_rbtree(t);
+    free(keys);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-u updates] [-r snapshots] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts (default 1000,1000000)\n");
+    fprintf(stderr, "  -u  updates while each snapshot is alive (default 1000)\n");
+    fprintf(stderr, "  -r  snapshots taken per case (default 100)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000, 1000000};
+    size_t n_sizes = 2, updates = 1000, rounds = 100;
+    uint64_t seed = 17;
+    bool header = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:u:r:s:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n_sizes = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_sizes < 16; tok = strtok(NULL, ",")) {
+                sizes[n_sizes] = strtoull(tok, NULL, 10);
+                if (sizes[n_sizes] == 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+            }
+            break;
+        case 'u':
+            updates = strtoull(optarg, NULL, 10);
+            break;
+        case 'r':
+            rounds = strtoull(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (rounds == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    for (size_t s = 0; s < n_sizes; s++) {
+        if (run_case(sizes[s], updates, rounds, seed) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 템플릿(rbtree_tmpl.h)으로 생성한 트리의 기본 연산 벤치마크
+// 같은 키 패턴으로 네 가지 트리를 만들어 비교
+//   rbtree   : rbtree.c의 int 키 트리 (기준)
+//   tmpl_i32 : 템플릿의 int 키 트리 (같은 키에서 rbtree.c와의 차이 = 값 필드와 트리별 nil 등 템플릿 구현 차이)
+//   tmpl_u64 : uint64_t 키 트리 (int 키 k를 (k << 32) | k로 바꿔서 같은 순서를 유지)
+//   tmpl_str : 문자열 키 트리 (k를 폭을 맞춘 십진수 문자열로, strcmp 비교 -> 비교마다 포인터를 따라감)
+// 트리마다 아래 작업을 순서대로 측정
+//   insert    : 빈 트리에 키 n개 삽입
+//   find      : 같은 키 n개를 같은 순서로 탐색 (모두 존재)
+//   erase_key : 같은 키 n개를 erase_key로 삭제
+// 키 변환(문자열 만들기 포함)은 측정 전에 끝내고 시간에 넣지 않음
+// (크기, 패턴) 한 경우를 fork한 자식 프로세스에서 돌림
+// 네 트리를 한 프로세스에서 차례로 재므로 peak_rss_kb는 앞선 트리까지 포함한 최대값
+//
+// 사용법 : ./bench-tmpl [-n 1000000] [-p random,zipf] [-s seed] [-H]
+
+#define RBT_NAME tmpl_i32
+#define RBT_KEY int
+#include "rbtree_tmpl.h"
+
+#define RBT_NAME tmpl_u64
+#define RBT_KEY uint64_t
+#include "rbtree_tmpl.h"
+
+typedef const char *str_key;
+
+#define RBT_NAME tmpl_str
+#define RBT_KEY str_key
+#define RBT_CMP(a, b) strcmp((a), (b))
+#include "rbtree_tmpl.h"
+
+// 결과를 쓰지 않는 탐색이 컴파일러 최적화로 사라지지 않도록 여기에 모아둠
+static volatile size_t sink;
+
+// 같은 모양의 측정 함수를 트리마다 생성 : NAME##_run(keys, n, pattern). 실패하면 -1
+#define DEFINE_RUN(NAME, KEY)                                                                                          \
+    static int NAME##_run(const KEY *keys, const size_t n, const char *pattern) {                                      \
+        NAME *t = NAME##_new();                                                                                        \
+        if (t == NULL) {                                                                                               \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+        uint64_t begin = bench_now_ns();                                                                               \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            if (NAME##_insert(t, keys[i], NULL) == NULL) {                                                             \
+                return -1;                                                                                             \
+            }                                                                                                          \
+        }                                                                                                              \
+        bench_report(#NAME, "insert", pattern, n, 1, n, bench_now_ns() - begin);                                       \
+                                                                                                                       \
+        size_t found = 0;                                                                                              \
+        begin = bench_now_ns();                                                                                        \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            found += NAME##_find(t, keys[i]) != NULL;                                                                  \
+        }                                                                                                              \
+        bench_report(#NAME, "find", pattern, n, 1, n, bench_now_ns() - begin);                                         \
+        sink += found;                                                                                                 \
+                                                                                                                       \
+        int failed = 0;                                                                                                \
+        begin = bench_now_ns();                                                                                        \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            failed |= NAME##_erase_key(t, keys[i]);                                                                    \
+        }                                                                                                              \
+        bench_report(#NAME, "erase_key", pattern, n, 1, n, bench_now_ns() - begin);                                    \
+        NAME##_delete(t);                                                                                              \
+        return found == n && failed == 0 ? 0 : -1;                                                                     \
+    }
+
+DEFINE_RUN(tmpl_i32, int)
+DEFINE_RUN(tmpl_u64, uint64_t)
+DEFINE_RUN(tmpl_str, str_key)
+
+static int rbtree_run(const key_t *keys, const size_t n, const char *pattern) {
+    rbtree *t = new_rbtree();
+    if (t == NULL) {
+        return -1;
+    }
+    uint64_t begin = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+        if (rbtree_insert(t, keys[i]) == NULL) {
+            return -1;
+        }
+    }
+    bench_report("rbtree", "insert", pattern, n, 1, n, bench_now_ns() - begin);
+
+    size_t found = 0;
+    begin = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+        found += rbtree_find(t, keys[i]) != NULL;
+    }
+    bench_report("rbtree", "find", pattern, n, 1, n, bench_now_ns() - begin);
+    sink += found;
+
+    int failed = 0;
+    begin = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+        failed |= rbtree_erase_key(t, keys[i]);
+    }
+    bench_report("rbtree", "erase_key", pattern, n, 1, n, bench_now_ns() - begin);
+    delete_rbtree(t);
+    return found == n && failed == 0 ? 0 : -1;
+}
+
+static int run_case(const bench_pattern_t pattern, const size_t n, const uint64_t seed) {
+    const char *name = bench_pattern_names[pattern];
+    key_t *keys = bench_make_keys(pattern, n, seed); // 0 ~ n-1 (zipf는 중복 포함)
+    uint64_t *wide = malloc(n * sizeof(uint64_t));
+    str_key *strs = malloc(n * sizeof(str_key));
+    char *text = malloc(n * 12); // 키 하나에 "%010d" + '\0' = 11바이트, 12바이트씩
+    if (keys == NULL || wide == NULL || strs == NULL || text == NULL) {
+        fprintf(stderr, "bench-tmpl: out of memory (n=%zu)\n", n);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        wide[i] = ((uint64_t)(uint32_t)keys[i] << 32) | (uint32_t)keys[i];
+        snprintf(text + 12 * i, 12, "%010d", keys[i]);
+        strs[i] = text + 12 * i;
+    }
+
+    int res = rbtree_run(keys, n, name);
+    res |= tmpl_i32_run(keys, n, name);
+    res |= tmpl_u64_run(wide, n, name);
+    res |= tmpl_str_run(strs, n, name);
+    if (res != 0) {
+        fprintf(stderr, "bench-tmpl: out of memory or lost keys (n=%zu)\n", n);
+    }
+    free(text);
+    free(strs);
+    free(wide);
+    free(keys);
+    return res;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n sizes] [-p patterns] [-s seed] [-H]\n", prog);
+    fprintf(stderr, "  -n  comma separated key counts (default 1000000)\n");
+    fprintf(stderr, "  -p  comma separated patterns: sequential,reverse,random,zipf (default all)\n");
+    fprintf(stderr, "  -s  random seed (default 17)\n");
+    fprintf(stderr, "  -H  omit the CSV header line\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[16] = {1000000};
+    size_t n_sizes = 1;
+    bool patterns[PATTERN_COUNT] = {true, true, true, true};
+    uint64_t seed = 17;
+    bool header = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:s:Hh")) != -1) {
+        char *tok;
+        switch (opt) {
+        case 'n':
+            n_sizes = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && n_sizes < 16; tok = strtok(NULL, ",")) {
+                sizes[n_sizes] = strtoull(tok, NULL, 10);
+                if (sizes[n_sizes] == 0 || sizes[n_sizes] > 1000000000) { // "%010d"로 쓰는 키가 10자리를 넘지 않게
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+            }
+            break;
+        case 'p':
+            memset(patterns, 0, sizeof(patterns));
+            for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                int p = bench_pattern_parse(tok);
+                if (p < 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                patterns[p] = true;
+            }
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'H':
+            header = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (header) {
+        bench_report_header();
+    }
+    fflush(stdout); // 버퍼에 남은 내용을 fork 전에 비워야 자식 프로세스가 같은 줄을 다시 출력하지 않음
+    for (size_t s = 0; s < n_sizes; s++) {
+        for (int p = 0; p < PATTERN_COUNT; p++) {
+            if (!patterns[p]) {
+                continue;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                exit(run_case(p, sizes[s], seed) == 0 ? 0 : 1);
+            }
+            int status;
+            if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                fprintf(stderr, "bench-tmpl: case n=%zu pattern=%s failed\n", sizes[s], bench_pattern_names[p]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+// 벤치마크 공용 도우미 (시간 측정, 최대 RSS, 키 패턴 생성, 결과 출력)
+// 벤치마크 프로그램마다 include해서 쓰는 헤더 전용 모듈. 함수는 모두 static이라 실행 파일마다 따로 들어감
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "rbtree.h"
+
+// 단조 증가 시계 (ns). 벽시계(CLOCK_REALTIME)는 NTP 보정으로 거꾸로 갈 수 있어 측정에 쓰지 않음
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 이 프로세스가 지금까지 사용한 최대 상주 메모리 (KB, 리눅스 기준)
+// 프로세스 전체의 최고치라 줄어들지 않음 -> 경우마다 정확히 재려면 fork한 자식 프로세스에서 측정
+static inline long bench_peak_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// splitmix64 : 시드만 같으면 어느 libc에서도 같은 수열이 나오고 rand()보다 빠르고 범위도 64비트
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// [0, 1) 구간의 실수
+static inline double bench_rand_unit(uint64_t *state) {
+    return (bench_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 키 패턴 : 삽입/탐색/삭제에 쓸 키를 어떤 순서로 만들지
+typedef enum {
+    PATTERN_SEQUENTIAL, // 0, 1, 2, ... 오름차순 -> 항상 가장 오른쪽에 붙는 최악의 회전 패턴
+    PATTERN_REVERSE,    // n-1, ..., 0 내림차순 -> 가장 왼쪽에 붙음
+    PATTERN_RANDOM,     // 0..n-1을 무작위로 섞은 순열 -> 캐시 미스가 가장 많음
+    PATTERN_ZIPF,       // Zipf(0.99) 분포로 뽑은 키 -> 일부 키에 접근이 몰리는 실제 서비스 부하 (중복 포함)
+    PATTERN_COUNT
+} bench_pattern_t;
+
+static const char *const bench_pattern_names[PATTERN_COUNT] = {"sequential", "reverse", "random", "zipf"};
+
+// Zipf 분포 표본 추출 (Gray et al. "Quickly Generating Billion-Record Synthetic Databases", YCSB와 같은 방식)
+// zeta(n) 계산만 O(n)이고, 표본 하나는 O(1)
+typedef struct {
+    size_t n;
+    double theta, alpha, zetan, eta;
+} bench_zipf_t;
+
+static void bench_zipf_init(bench_zipf_t *z, const size_t n, const double theta) {
+    double zetan = 0, zeta2 = 1.0 + pow(0.5, theta);
+    for (size_t i = 1; i <= n; i++) {
+        zetan += pow((double)i, -theta);
+    }
+    z->n = n;
+    z->theta = theta;
+    z->alpha = 1.0 / (1.0 - theta);
+    z->zetan = zetan;
+    z->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+}
+
+// 0이 가장 자주 나오는 순위 [0, n)
+static size_t bench_zipf_next(const bench_zipf_t *z, uint64_t *state) {
+    double u = bench_rand_unit(state);
+    double uz = u * z->zetan;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + pow(0.5, z->theta)) {
+        return 1;
+    }
+    size_t rank = (size_t)(z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+    return rank < z->n ? rank : z->n - 1;
+}
+
+// 패턴에 맞는 키 n개를 새로 할당해서 반환 (호출한 쪽에서 free). 실패 시 NULL
+// Zipf는 순위를 무작위 순열에 통과시켜, 자주 쓰이는 키가 작은 값에 몰리지 않고 트리 전체에 흩어지게 함
+static inline key_t *bench_make_keys(const bench_pattern_t pattern, const size_t n, const uint64_t seed) {
+    key_t *keys = malloc(n * sizeof(key_t));
+    if (keys == NULL) {
+        return NULL;
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = (key_t)(pattern == PATTERN_REVERSE ? n - 1 - i : i);
+    }
+    if (pattern == PATTERN_RANDOM || pattern == PATTERN_ZIPF) {
+        for (size_t i = n - 1; i > 0; i--) { // Fisher-Yates 셔플
+            size_t j = bench_rand(&state) % (i + 1);
+            key_t tmp = keys[i];
+            keys[i] = keys[j];
+            keys[j] = tmp;
+        }
+    }
+    if (pattern == PATTERN_ZIPF) {
+        key_t *perm = keys;
+        keys = malloc(n * sizeof(key_t));
+        if (keys != NULL) {
+            bench_zipf_t z;
+            bench_zipf_init(&z, n, 0.99);
+            for (size_t i = 0; i < n; i++) {
+                keys[i] = perm[bench_zipf_next(&z, &state)];
+            }
+        }
+        free(perm);
+    }
+    return keys;
+}
+
+// 이름으로 패턴을 찾음. 없으면 -1
+static inline int bench_pattern_parse(const char *name) {
+    for (int p = 0; p < PATTERN_COUNT; p++) {
+        if (strcmp(name, bench_pattern_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+// 결과는 CSV 한 줄씩 stdout으로 출력 -> 그대로 파일로 저장해 릴리스 전후를 비교할 수 있게 함
+// threads : 측정한 작업을 수행한 스레드 수
+// ns_per_op : 벽시계 시간 / 연산 수 (여러 스레드면 전체 처리량 기준), mops : 초당 처리한 연산 수(백만 단위)
+// peak_rss_kb : 측정 시점까지의 최대 RSS
+// 벤치마크 프로그램 여러 개의 출력을 이어 붙일 수 있도록, 헤더는 프로그램마다 -H 옵션으로 생략 가능
+static void bench_report_header(void) {
+    printf("bench,workload,pattern,n,threads,ops,ns_per_op,mops,peak_rss_kb\n");
+}
+
+static void bench_report(const char *bench, const char *workload, const char *pattern, const size_t n,
+                         const int threads, const size_t ops, const uint64_t ns) {
+    double ns_per_op = ops ? (double)ns / ops : 0;
+    double mops = ns ? ops * 1e3 / ns : 0;
+    printf("%s,%s,%s,%zu,%d,%zu,%.2f,%.3f,%ld\n", bench, workload, pattern, n, threads, ops, ns_per_op, mops,
+           bench_peak_rss_kb());
+    fflush(stdout);
+}
+
+#endif // _BENCH_H_
@@ -0,0 +1,561 @@
+#include "arena_rbtree.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARENA_MAGIC "RBTA"
+#define ARENA_VERSION 1
+#define ARENA_HEADER_SIZE 64         // 노드 배열이 캐시 라인 경계에서 시작하도록 헤더를 64바이트로 채움
+#define ARENA_MAX_NODES 0x7fffffffu  // 부모 필드에 색 1비트를 함께 넣으므로 노드 번호는 31비트
+#define ARENA_MIN_CAPACITY 64        // nil 포함
+#define ARENA_MAX_HEIGHT 64          // 노드가 2^31개 미만인 RB tree의 높이 상한 2 * 31에 여유를 둠
+#define ARENA_OPEN_TRIES (1u << 20)  // 읽기 전용 open이 진행 중인 쓰기가 끝나기를 기다리는 횟수 (죽은 arena면 NULL)
+
+enum { ARENA_RED = 0, ARENA_BLACK = 1 };
+
+// 노드 번호 0은 nil. left/right가 0이면 자식이 없음
+typedef struct {
+    key_t key;
+    uint32_t parent_color; // 부모 번호 << 1 | 색 (최하위 비트, 0 = RED, 1 = BLACK)
+    uint32_t left, right;
+} arena_node;
+
+typedef struct {
+    char magic[4];      // "RBTA"
+    uint16_t version;   // ARENA_VERSION
+    uint16_t key_size;  // sizeof(key_t)
+    uint32_t seq;       // 홀수면 쓰기 중
+    uint32_t capacity;  // 노드 슬롯 수 (nil 포함). 파일 크기 = ARENA_HEADER_SIZE + capacity * 16
+    uint32_t used;      // 한 번이라도 나눠준 슬롯 수 (nil 포함). 그 뒤의 슬롯은 아직 쓴 적이 없음
+    uint32_t free_head; // 지운 노드 목록 (right로 연결), 0이면 비어 있음
+    uint32_t root;
+    uint32_t count;     // 키 개수
+} arena_header;
+
+_Static_assert(sizeof(arena_header) <= ARENA_HEADER_SIZE, "arena_header가 헤더 영역보다 큼");
+_Static_assert(sizeof(arena_node) == 16, "arena_node는 16바이트여야 함 (파일 형식)");
+
+// 프로세스마다 하나씩 갖는 핸들. arena 안에는 이 구조체의 어떤 값도 저장하지 않음
+struct arena_rbtree {
+    int fd;
+    int writable;
+    arena_header *hdr; // 매핑한 arena의 시작 주소
+    arena_node *nodes; // hdr + ARENA_HEADER_SIZE, 0번 = nil
+    uint32_t capacity; // 이 프로세스가 매핑한 노드 슬롯 수 (다른 프로세스가 늘렸으면 hdr->capacity보다 작음)
+    size_t mapped;     // 매핑한 바이트 수
+};
+
+// 읽기 쪽이 읽는 연결. 쓰는 쪽은 새 노드를 채운 뒤에 연결하므로 acquire로 읽으면 채운 내용이 보임
+#define READ_IDX(i) __atomic_load_n(&(i), __ATOMIC_ACQUIRE)
+// 쓰는 쪽이 바꾸는 연결(left/right/root). 읽기 쪽이 쓰는 도중에도 읽으므로 READ_IDX와 짝을 이루는 원자적 저장
+#define SET_IDX(i, v) __atomic_store_n(&(i), (v), __ATOMIC_RELEASE)
+// 키는 지운 슬롯을 다시 쓸 때 바뀌고, 재시도할 읽기가 그 슬롯을 보는 중일 수 있으므로 원자적으로 읽고 씀
+#define READ_KEY(k) __atomic_load_n(&(k), __ATOMIC_RELAXED)
+#define SET_KEY(k, v) __atomic_store_n(&(k), (v), __ATOMIC_RELAXED)
+
+static inline size_t arena_bytes(const uint32_t capacity) {
+    return ARENA_HEADER_SIZE + (size_t)capacity * sizeof(arena_node);
+}
+
+static inline uint32_t parent_of(const arena_node *nd, const uint32_t x) {
+    return nd[x].parent_color >> 1;
+}
+
+static inline int color_of(const arena_node *nd, const uint32_t x) {
+    return (int)(nd[x].parent_color & 1);
+}
+
+static inline void set_parent(arena_node *nd, const uint32_t x, const uint32_t p) {
+    nd[x].parent_color = p << 1 | (nd[x].parent_color & 1);
+}
+
+static inline void set_color(arena_node *nd, const uint32_t x, const int color) {
+    nd[x].parent_color = (nd[x].parent_color & ~1u) | (uint32_t)color;
+}
+
+// 다른 프로세스를 기다리며 도는 동안 CPU에 힌트를 주고, 오래 걸리면 CPU를 양보
+static inline void spin_wait(const unsigned tries) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    if (tries % 64 == 63) {
+        sched_yield();
+    }
+}
+
+// 쓰기 구간 : rbtree.c의 RBTREE_CONCURRENT와 같은 seqlock. 헤더가 공유 메모리에 있으므로 프로세스 사이에서도 동작
+static inline void write_begin(arena_rbtree *a) {
+    __atomic_store_n(&a->hdr->seq, a->hdr->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_end(arena_rbtree *a) {
+    __atomic_store_n(&a->hdr->seq, a->hdr->seq + 1, __ATOMIC_RELEASE);
+}
+
+// arena 앞부분 capacity개 슬롯만큼을 새로 매핑하고 이전 매핑을 해제. 실패하면 이전 매핑을 그대로 둠
+static int map_arena(arena_rbtree *a, const uint32_t capacity) {
+    const size_t bytes = arena_bytes(capacity);
+    void *p = mmap(NULL, bytes, a->writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, a->fd, 0);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    if (a->hdr != NULL) {
+        munmap(a->hdr, a->mapped);
+    }
+    a->hdr = (arena_header *)p;
+    a->nodes = (arena_node *)((char *)p + ARENA_HEADER_SIZE);
+    a->capacity = capacity;
+    a->mapped = bytes;
+    return 0;
+}
+
+// 다른 프로세스가 arena를 늘렸으면 새 크기로 다시 매핑
+// 쓰는 쪽은 파일을 늘린 뒤에 capacity를 바꾸므로, 여기서 본 크기만큼은 항상 매핑할 수 있음
+static int remap_if_grown(arena_rbtree *a) {
+    const uint32_t capacity = __atomic_load_n(&a->hdr->capacity, __ATOMIC_ACQUIRE);
+    return capacity > a->capacity ? map_arena(a, capacity) : 0;
+}
+
+// 빈 슬롯 하나를 꺼냄. 지운 노드 목록 -> 쓴 적 없는 슬롯 -> arena를 두 배로 늘림 순서. 실패 시 0
+// 헤더의 capacity/used/free_head를 바꾸므로 쓰기 구간 안에서 부름
+static uint32_t node_alloc(arena_rbtree *a) {
+    arena_header *h = a->hdr;
+    if (h->free_head != 0) {
+        const uint32_t x = h->free_head;
+        h->free_head = a->nodes[x].right;
+        return x;
+    }
+    if (h->used == h->capacity) {
+        if (h->capacity >= ARENA_MAX_NODES) {
+            return 0;
+        }
+        const uint32_t capacity = h->capacity > ARENA_MAX_NODES / 2 ? ARENA_MAX_NODES : h->capacity * 2;
+        if (ftruncate(a->fd, (off_t)arena_bytes(capacity)) != 0 || map_arena(a, capacity) != 0) {
+            return 0;
+        }
+        h = a->hdr;
+        __atomic_store_n(&h->capacity, capacity, __ATOMIC_RELEASE);
+    }
+    return h->used++;
+}
+
+static void node_free(arena_rbtree *a, const uint32_t x) {
+    SET_IDX(a->nodes[x].right, a->hdr->free_head);
+    a->hdr->free_head = x;
+}
+
+arena_rbtree *arena_rbtree_create(int fd, const size_t capacity_hint) {
+    struct stat st;
+    // 이미 내용이 있는 파일은 덮어쓰지 않음 (기존 arena는 arena_rbtree_open으로 엶)
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != 0 || capacity_hint >= ARENA_MAX_NODES) {
+        return NULL;
+    }
+    const uint32_t capacity = capacity_hint + 1 < ARENA_MIN_CAPACITY ? ARENA_MIN_CAPACITY : (uint32_t)capacity_hint + 1;
+    arena_rbtree *a = (arena_rbtree *)calloc(1, sizeof(arena_rbtree));
+    if (a == NULL) {
+        return NULL;
+    }
+    a->fd = fd;
+    a->writable = 1;
+    if (ftruncate(fd, (off_t)arena_bytes(capacity)) != 0 || map_arena(a, capacity) != 0) {
+        free(a);
+        return NULL;
+    }
+    // ftruncate로 늘린 부분은 0으로 채워져 있으므로 root, free_head, count, seq는 이미 0
+    arena_header *h = a->hdr;
+    h->version = ARENA_VERSION;
+    h->key_size = sizeof(key_t);
+    h->capacity = capacity;
+    h->used = 1; // 0번 슬롯 = nil
+    a->nodes[0].parent_color = ARENA_BLACK;
+    memcpy(h->magic, ARENA_MAGIC, sizeof(h->magic)); // 마지막에 써서, 만들다 만 arena는 open이 거부
+    return a;
+}
+
+arena_rbtree *arena_rbtree_open(int fd, const int writable) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size < arena_bytes(1)) {
+        return NULL;
+    }
+    arena_rbtree *a = (arena_rbtree *)calloc(1, sizeof(arena_rbtree));
+    if (a == NULL) {
+        return NULL;
+    }
+    a->fd = fd;
+    a->writable = writable != 0;
+    if (map_arena(a, 1) != 0) { // 헤더와 nil만 먼저 매핑해 형식과 크기를 확인
+        free(a);
+        return NULL;
+    }
+    // 헤더를 시퀀스로 검증하며 한꺼번에 읽음 (다른 프로세스가 쓰는 중이면 값들이 서로 맞지 않을 수 있음)
+    // 시퀀스가 홀수 : 읽기 전용이면 다른 프로세스가 쓰는 중일 수 있으므로 잠시 기다림
+    // 쓰는 핸들은 하나뿐이므로 쓰는 핸들로 열 때 홀수라면 이전에 쓰던 프로세스가 도중에 죽은 것
+    const arena_header *h = a->hdr;
+    arena_header copy;
+    uint32_t seq = 1;
+    for (unsigned tries = 0; tries < ARENA_OPEN_TRIES; tries++) {
+        seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+        if (!(seq & 1)) {
+            memcpy(&copy, h, sizeof(copy));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&h->seq, __ATOMIC_RELAXED) == seq) {
+                break;
+            }
+            seq = 1;
+        }
+        if (a->writable) {
+            break;
+        }
+        spin_wait(tries);
+    }
+    // 기다리는 동안 쓰는 쪽이 arena를 늘렸을 수 있으므로 파일 크기도 다시 읽음
+    if ((seq & 1) || fstat(fd, &st) != 0 || memcmp(copy.magic, ARENA_MAGIC, sizeof(copy.magic)) != 0 ||
+        copy.version != ARENA_VERSION || copy.key_size != sizeof(key_t) || copy.capacity == 0 ||
+        copy.capacity > ARENA_MAX_NODES || arena_bytes(copy.capacity) > (size_t)st.st_size || copy.used == 0 ||
+        copy.used > copy.capacity || copy.root >= copy.capacity || copy.free_head >= copy.capacity ||
+        map_arena(a, copy.capacity) != 0) {
+        arena_rbtree_close(a);
+        return NULL;
+    }
+    return a;
+}
+
+void arena_rbtree_close(arena_rbtree *a) {
+    if (a == NULL) {
+        return;
+    }
+    if (a->hdr != NULL) {
+        munmap(a->hdr, a->mapped);
+    }
+    free(a);
+}
+
+int arena_rbtree_sync(arena_rbtree *a) {
+    if (a == NULL || !a->writable) {
+        return -1;
+    }
+    return msync(a->hdr, a->mapped, MS_SYNC) == 0 ? 0 : -1;
+}
+
+size_t arena_rbtree_size(const arena_rbtree *a) {
+    return a == NULL ? 0 : __atomic_load_n(&a->hdr->count, __ATOMIC_ACQUIRE);
+}
+
+// rbtree.c의 left_rotate / right_rotate와 같은 회전을 노드 번호로
+static void left_rotate(arena_rbtree *a, const uint32_t x) {
+    arena_node *nd = a->nodes;
+    const uint32_t y = nd[x].right, p = parent_of(nd, x);
+    SET_IDX(nd[x].right, nd[y].left);
+    if (nd[y].left != 0) {
+        set_parent(nd, nd[y].left, x);
+    }
+    set_parent(nd, y, p);
+    if (p == 0) {
+        SET_IDX(a->hdr->root, y);
+    } else if (x == nd[p].left) {
+        SET_IDX(nd[p].left, y);
+    } else {
+        SET_IDX(nd[p].right, y);
+    }
+    SET_IDX(nd[y].left, x);
+    set_parent(nd, x, y);
+}
+
+static void right_rotate(arena_rbtree *a, const uint32_t y) {
+    arena_node *nd = a->nodes;
+    const uint32_t x = nd[y].left, p = parent_of(nd, y);
+    SET_IDX(nd[y].left, nd[x].right);
+    if (nd[x].right != 0) {
+        set_parent(nd, nd[x].right, y);
+    }
+    set_parent(nd, x, p);
+    if (p == 0) {
+        SET_IDX(a->hdr->root, x);
+    } else if (y == nd[p].left) {
+        SET_IDX(nd[p].left, x);
+    } else {
+        SET_IDX(nd[p].right, x);
+    }
+    SET_IDX(nd[x].right, y);
+    set_parent(nd, y, x);
+}
+
+// rbtree_fixup과 같은 삽입 복구 (좌우 대칭 케이스를 dir로 합침)
+static void insert_fixup(arena_rbtree *a, uint32_t z) {
+    arena_node *nd = a->nodes;
+    while (color_of(nd, parent_of(nd, z)) == ARENA_RED) {
+        const uint32_t p = parent_of(nd, z), g = parent_of(nd, p);
+        const int left = p == nd[g].left; // 부모가 조부모의 왼쪽 자식인가
+        const uint32_t uncle = left ? nd[g].right : nd[g].left;
+        if (color_of(nd, uncle) == ARENA_RED) { // Case 1 : 부모와 삼촌을 BLACK, 조부모를 RED로 칠하고 위로
+            set_color(nd, p, ARENA_BLACK);
+            set_color(nd, uncle, ARENA_BLACK);
+            set_color(nd, g, ARENA_RED);
+            z = g;
+            continue;
+        }
+        if (z == (left ? nd[p].right : nd[p].left)) { // Case 2 : 꺾인 모양을 회전으로 펴서 Case 3으로
+            z = p;
+            if (left) {
+                left_rotate(a, z);
+            } else {
+                right_rotate(a, z);
+            }
+        }
+        // Case 3 : 부모를 BLACK, 조부모를 RED로 칠하고 조부모를 회전
+        set_color(nd, parent_of(nd, z), ARENA_BLACK);
+        set_color(nd, g, ARENA_RED);
+        if (left) {
+            right_rotate(a, g);
+        } else {
+            left_rotate(a, g);
+        }
+    }
+    set_color(nd, a->hdr->root, ARENA_BLACK);
+}
+
+int arena_rbtree_insert(arena_rbtree *a, const key_t key) {
+    if (a == NULL || !a->writable) {
+        return -1;
+    }
+    write_begin(a);
+    const uint32_t z = node_alloc(a); // arena를 늘리면 다시 매핑되므로 nodes는 이 뒤에 읽음
+    if (z == 0) {
+        write_end(a);
+        return -1;
+    }
+    arena_node *nd = a->nodes;
+    uint32_t y = 0, x = a->hdr->root;
+    while (x != 0) {
+        y = x;
+        x = key < nd[x].key ? nd[x].left : nd[x].right;
+    }
+    // 지운 노드의 슬롯이면 이전 읽기가 아직 보고 있을 수 있으므로 필드마다 원자적으로 채움
+    SET_KEY(nd[z].key, key);
+    nd[z].parent_color = y << 1 | ARENA_RED;
+    SET_IDX(nd[z].left, 0);
+    SET_IDX(nd[z].right, 0);
+    if (y == 0) {
+        SET_IDX(a->hdr->root, z);
+    } else if (key < nd[y].key) {
+        SET_IDX(nd[y].left, z);
+    } else {
+        SET_IDX(nd[y].right, z);
+    }
+    insert_fixup(a, z);
+    __atomic_store_n(&a->hdr->count, a->hdr->count + 1, __ATOMIC_RELEASE); // arena_rbtree_size가 락 없이 읽음
+    write_end(a);
+    return 0;
+}
+
+int arena_rbtree_find(arena_rbtree *a, const key_t key) {
+    if (a == NULL) {
+        return 0;
+    }
+    const arena_header *h = a->hdr;
+    // rbtree.c의 read_walk와 같은 락 없는 읽기
+    // 쓰는 도중의 어긋난 번호를 따라가도 매핑 안의 슬롯만 읽고 높이 상한에서 멈추며, 시퀀스 검사에서 재시도됨
+    for (unsigned tries = 0;; tries++) {
+        const uint32_t seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            spin_wait(tries);
+            continue;
+        }
+        if (remap_if_grown(a) != 0) {
+            return 0;
+        }
+        h = a->hdr;
+        const arena_node *nd = a->nodes;
+        int found = 0;
+        uint32_t x = READ_IDX(h->root);
+        for (int depth = 0; x != 0 && x < a->capacity && depth < ARENA_MAX_HEIGHT; depth++) {
+            const key_t k = READ_KEY(nd[x].key);
+            if (k == key) {
+                found = 1;
+                break;
+            }
+            x = key < k ? READ_IDX(nd[x].left) : READ_IDX(nd[x].right);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); // 위의 읽기가 아래 시퀀스 재확인보다 늦어지지 않게 함
+        if (__atomic_load_n(&h->seq, __ATOMIC_RELAXED) == seq) {
+            return found;
+        }
+        spin_wait(tries);
+    }
+}
+
+// u의 자리에 v를 이식 (v가 nil이어도 부모를 기록해 delete_fixup이 쓸 수 있게 함)
+static void transplant(arena_rbtree *a, const uint32_t u, const uint32_t v) {
+    arena_node *nd = a->nodes;
+    const uint32_t p = parent_of(nd, u);
+    if (p == 0) {
+        SET_IDX(a->hdr->root, v);
+    } else if (u == nd[p].left) {
+        SET_IDX(nd[p].left, v);
+    } else {
+        SET_IDX(nd[p].right, v);
+    }
+    set_parent(nd, v, p);
+}
+
+// rbtree.c의 delete_fixup과 같은 삭제 복구 (좌우 대칭 케이스를 left로 합침)
+static void delete_fixup(arena_rbtree *a, uint32_t x) {
+    arena_node *nd = a->nodes;
+    while (x != a->hdr->root && color_of(nd, x) == ARENA_BLACK) {
+        uint32_t p = parent_of(nd, x);
+        const int left = x == nd[p].left;
+        uint32_t w = left ? nd[p].right : nd[p].left;
+        if (color_of(nd, w) == ARENA_RED) { // Case 1 : 형제가 RED -> 부모를 회전해 형제를 BLACK으로
+            set_color(nd, w, ARENA_BLACK);
+            set_color(nd, p, ARENA_RED);
+            if (left) {
+                left_rotate(a, p);
+            } else {
+                right_rotate(a, p);
+            }
+            w = left ? nd[p].right : nd[p].left;
+        }
+        uint32_t near = left ? nd[w].left : nd[w].right, far = left ? nd[w].right : nd[w].left;
+        if (color_of(nd, near) == ARENA_BLACK && color_of(nd, far) == ARENA_BLACK) { // Case 2 : 부모로 올려보냄
+            set_color(nd, w, ARENA_RED);
+            x = p;
+            continue;
+        }
+        if (color_of(nd, far) == ARENA_BLACK) { // Case 3 : 가까운 조카만 RED -> 형제를 회전해 Case 4로
+            set_color(nd, near, ARENA_BLACK);
+            set_color(nd, w, ARENA_RED);
+            if (left) {
+                right_rotate(a, w);
+            } else {
+                left_rotate(a, w);
+            }
+            w = left ? nd[p].right : nd[p].left;
+            far = left ? nd[w].right : nd[w].left;
+        }
+        // Case 4 : 먼 조카가 RED -> 부모를 회전하고 끝
+        set_color(nd, w, color_of(nd, p));
+        set_color(nd, p, ARENA_BLACK);
+        set_color(nd, far, ARENA_BLACK);
+        if (left) {
+            left_rotate(a, p);
+        } else {
+            right_rotate(a, p);
+        }
+        x = a->hdr->root;
+    }
+    set_color(nd, x, ARENA_BLACK);
+}
+
+int arena_rbtree_erase(arena_rbtree *a, const key_t key) {
+    if (a == NULL || !a->writable) {
+        return -1;
+    }
+    arena_node *nd = a->nodes;
+    uint32_t z = a->hdr->root;
+    while (z != 0 && nd[z].key != key) {
+        z = key < nd[z].key ? nd[z].left : nd[z].right;
+    }
+    if (z == 0) {
+        return -1;
+    }
+    write_begin(a);
+    uint32_t y = z, x;
+    int y_origin_color = color_of(nd, y);
+    if (nd[z].left == 0) {
+        x = nd[z].right;
+        transplant(a, z, x);
+    } else if (nd[z].right == 0) {
+        x = nd[z].left;
+        transplant(a, z, x);
+    } else {
+        for (y = nd[z].right; nd[y].left != 0; y = nd[y].left) { // 후계자
+        }
+        y_origin_color = color_of(nd, y);
+        x = nd[y].right;
+        if (parent_of(nd, y) == z) {
+            set_parent(nd, x, y);
+        } else {
+            transplant(a, y, x);
+            SET_IDX(nd[y].right, nd[z].right);
+            set_parent(nd, nd[y].right, y);
+        }
+        transplant(a, z, y);
+        SET_IDX(nd[y].left, nd[z].left);
+        set_parent(nd, nd[y].left, y);
+        set_color(nd, y, color_of(nd, z));
+    }
+    node_free(a, z);
+    if (y_origin_color == ARENA_BLACK) {
+        delete_fixup(a, x);
+    }
+    __atomic_store_n(&a->hdr->count, a->hdr->count - 1, __ATOMIC_RELEASE);
+    write_end(a);
+    return 0;
+}
+
+int arena_rbtree_to_array(arena_rbtree *a, key_t *arr, const size_t n) {
+    if (a == NULL || arr == NULL || remap_if_grown(a) != 0) {
+        return -1;
+    }
+    // rbtree_to_array와 같은 고정 크기 스택 중위 순회
+    const arena_node *nd = a->nodes;
+    uint32_t stack[ARENA_MAX_HEIGHT];
+    size_t top = 0, index = 0;
+    uint32_t x = a->hdr->root;
+    while (index < n) {
+        for (; x != 0; x = nd[x].left) {
+            if (top == ARENA_MAX_HEIGHT || x >= a->capacity) { // 손상된 arena
+                return -1;
+            }
+            stack[top++] = x;
+        }
+        if (top == 0) {
+            break;
+        }
+        x = stack[--top];
+        arr[index++] = nd[x].key;
+        x = nd[x].right;
+    }
+    return 0;
+}
+
+int arena_rbtree_range(arena_rbtree *a, const key_t lo, const key_t hi, arena_visit_fn visit, void *ctx) {
+    if (a == NULL || visit == NULL || remap_if_grown(a) != 0) {
+        return -1;
+    }
+    // rbtree_range와 같이 key >= lo 인 첫 노드까지 내려가며 후보를 쌓은 뒤 중위 순회를 이어감
+    const arena_node *nd = a->nodes;
+    uint32_t stack[ARENA_MAX_HEIGHT];
+    size_t top = 0;
+    uint32_t x = a->hdr->root;
+    while (x != 0) {
+        if (top == ARENA_MAX_HEIGHT || x >= a->capacity) {
+            return -1;
+        }
+        if (nd[x].key >= lo) {
+            stack[top++] = x;
+            x = nd[x].left;
+        } else {
+            x = nd[x].right;
+        }
+    }
+    while (top > 0) {
+        x = stack[--top];
+        if (nd[x].key > hi || visit(nd[x].key, ctx) != 0) {
+            break;
+        }
+        for (x = nd[x].right; x != 0; x = nd[x].left) {
+            if (top == ARENA_MAX_HEIGHT || x >= a->capacity) {
+                return -1;
+            }
+            stack[top++] = x;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef _ARENA_RBTREE_H_
+#define _ARENA_RBTREE_H_
+
+#include "rbtree.h"
+
+/**
+ * arena_rbtree : 노드가 포인터 대신 32비트 번호로 서로를 가리켜 파일/공유 메모리 하나(arena)에 통째로 들어가는 RB tree
+ * rbtree의 노드는 parent/left/right에 이 프로세스의 주소를 담고 nil도 이 프로세스의 정적 변수이므로,
+ * 다른 프로세스와 나눠 쓰거나 파일에서 바로 매핑해 쓸 수 없음
+ * 여기서는 헤더, nil, 노드가 모두 arena 안에 있고 arena 안의 번호로만 연결됨
+ * -> 어느 주소에 매핑해도 그대로 동작하므로 여러 프로세스가 같은 arena를 복사 없이 열 수 있고,
+ *    재시작한 뒤에도 파일을 다시 매핑하는 것만으로 트리가 돌아옴 (rbtree_load와 달리 변환 과정이 없음)
+ *
+ * arena 레이아웃
+ *   [헤더 64바이트][노드 0 = nil][노드 1] ... [노드 capacity - 1]
+ *   노드는 16바이트 (key, 부모 번호 | 색, left, right). 부모 필드에 색 1비트를 함께 넣으므로 노드는 최대 2^31 - 1개
+ *   노드가 모자라면 쓰는 쪽이 파일을 두 배로 늘려 다시 매핑하고, 다른 프로세스는 다음 읽기 때 새 크기로 다시 매핑
+ *   값은 이 머신의 바이트 순서로 저장하므로 같은 종류의 머신끼리만 arena를 나눠 쓸 수 있음
+ *
+ * 동시성
+ * - 쓰는 핸들(arena_rbtree_create, arena_rbtree_open(fd, 1))은 arena 하나에 하나만 있어야 함
+ *   (여러 프로세스가 쓸 수 있다면 호출자가 flock 등으로 보장)
+ * - arena_rbtree_find는 RBTREE_CONCURRENT처럼 헤더의 시퀀스 카운터로 검증하므로,
+ *   다른 프로세스가 쓰는 도중에도 락 없이 부를 수 있음
+ * - arena_rbtree_to_array / arena_rbtree_range는 그동안 쓰기가 없어야 함
+ * - 핸들 하나를 여러 스레드가 함께 쓰면 안 됨. 다른 쪽이 arena를 늘렸으면 읽기 함수도 다시 매핑하면서
+ *   이전 매핑을 바로 해제하고 핸들의 필드를 바꿈 -> 같은 프로세스의 스레드끼리도 스레드마다 arena_rbtree_open으로 엶
+ * - 쓰는 도중 프로세스가 죽으면 시퀀스가 홀수로 남으므로 arena_rbtree_open이 NULL을 반환 (arena를 다시 만들어야 함)
+ *
+ * 핸들은 fd를 빌려 쓰기만 함. 다시 매핑할 때 필요하므로 arena_rbtree_close 전에 fd를 닫으면 안 되고,
+ * 닫는 것은 호출자 몫
+ */
+typedef struct arena_rbtree arena_rbtree;
+
+// 비어 있는 일반 파일이나 memfd_create로 만든 fd에 노드 capacity_hint개를 담을 빈 arena를 만들고 쓰는 핸들을 반환
+// 실패 시 NULL
+arena_rbtree *arena_rbtree_create(int fd, const size_t capacity_hint);
+
+// 이미 arena가 있는 fd를 엶. writable이 0이면 읽기 전용으로 매핑. 형식이 다르거나, 잘렸거나, 쓰다 만 arena이면 NULL
+arena_rbtree *arena_rbtree_open(int fd, const int writable);
+
+// 매핑을 풀고 핸들을 해제 (arena의 내용은 fd 쪽에 그대로 남음)
+void arena_rbtree_close(arena_rbtree *);
+
+// 지금까지 바꾼 내용을 파일에 기록 (msync). 성공 0, 실패 -1
+int arena_rbtree_sync(arena_rbtree *);
+
+// key 추가 (multiset이므로 중복 허용). 성공 0, 읽기 전용 핸들이거나 arena를 늘리지 못하면 -1
+int arena_rbtree_insert(arena_rbtree *, const key_t);
+
+// key가 있으면 1, 없으면 0
+int arena_rbtree_find(arena_rbtree *, const key_t);
+
+// key를 가진 노드 하나를 삭제. 성공 0, 없거나 읽기 전용 핸들이면 -1
+int arena_rbtree_erase(arena_rbtree *, const key_t);
+
+// 키 개수
+size_t arena_rbtree_size(const arena_rbtree *);
+
+// 키를 오름차순으로 최대 n개 arr에 채움
+int arena_rbtree_to_array(arena_rbtree *, key_t *, const size_t);
+
+// 노드가 arena 밖에서는 의미가 없으므로 rbtree_visit_fn과 달리 키를 넘김. 0이 아닌 값을 반환하면 순회를 멈춤
+typedef int (*arena_visit_fn)(key_t, void *);
+
+// lo <= key <= hi 인 키를 오름차순으로 visit에 넘김 - O(log n + k)
+int arena_rbtree_range(arena_rbtree *, const key_t lo, const key_t hi, arena_visit_fn visit, void *ctx);
+
+#endif // _ARENA_RBTREE_H_
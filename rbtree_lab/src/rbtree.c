@@ -1,6 +1,135 @@
 #include "rbtree.h"
 
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // rbtree_freeze 탐색의 SIMD 비교
+#endif
+#include <pthread.h> // 병렬 연산의 스레드 풀
+#include <sched.h>
+
+// 부모/색 쓰기 접근자. 읽기는 rbtree.h의 rbtree_parent / rbtree_color
+// 압축 레이아웃에서는 한 워드를 나눠 쓰므로 한쪽을 바꿀 때 다른 쪽 비트를 보존해야 함
+static inline void set_parent(node_t *x, node_t *p) {
+#ifdef RBTREE_COMPACT
+    x->parent_color = (uintptr_t)p | (x->parent_color & 1);
+#else
+    x->parent = p;
+#endif
+}
+
+static inline void set_color(node_t *x, const color_t c) {
+#ifdef RBTREE_COMPACT
+    x->parent_color = (x->parent_color & ~(uintptr_t)1) | (uintptr_t)c;
+#else
+    x->color = c;
+#endif
+}
+
+// 통계 카운터 갱신 (RBTREE_STATS 모드에서만)
+// 모드가 꺼져 있으면 n을 평가만 하고 버리므로, 카운트용 지역 변수도 함께 최적화로 사라짐
+#ifdef RBTREE_STATS
+#define STAT_ADD(t, field, n) ((t)->stats->field += (n))
+#else
+#define STAT_ADD(t, field, n) ((void)(n))
+#endif
+
+#define RBTREE_CACHE_LINE 64
+
+// 다른 스레드를 기다리며 도는 동안 CPU에 힌트를 주고, 오래 걸리면 CPU를 양보
+static inline void spin_wait(const unsigned tries) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    if (tries % 64 == 63) {
+        sched_yield();
+    }
+}
+
+#ifdef RBTREE_CONCURRENT
+// 읽기 스레드 카운터 묶음 수. 스레드마다 번호를 돌려가며 배정하므로 이보다 많은 스레드는 묶음을 나눠 씀
+#define RBTREE_READER_SLOTS 64
+// 지운 노드가 이만큼 모이면 읽기가 끝나기를 기다렸다가 한꺼번에 해제
+#define RBTREE_RECLAIM_BATCH 256
+
+/**
+ * 읽기 스레드 카운터 (epoch 두 개를 번갈아 씀)
+ * 읽기 스레드는 현재 epoch의 카운터를 늘리고 탐색이 끝나면 줄임
+ * 쓰기 스레드는 epoch를 바꾼 뒤 이전 epoch 카운터가 모두 0이 되기를 기다림
+ * -> 그 뒤에는 바꾸기 전에 시작한 읽기가 하나도 남지 않으므로, 그 전에 트리에서 떼어낸 노드를 해제해도 안전
+ * 새 읽기는 새 epoch 카운터를 쓰므로 읽기가 계속 들어와도 기다림이 끝없이 길어지지 않음
+ * 카운터를 슬롯별 캐시 라인에 나눠두어 슬롯 수(64) 이하의 읽기 스레드끼리는 같은 캐시 라인을 두고 다투지 않음
+ * (그보다 많으면 번호를 나눈 나머지가 같은 스레드끼리 한 슬롯의 카운터를 원자적으로 함께 바꿈)
+ */
+typedef struct {
+    _Alignas(RBTREE_CACHE_LINE) unsigned long count[2];
+} reader_slot;
+
+struct rbtree_sync {
+    _Alignas(RBTREE_CACHE_LINE) unsigned long seq; // 홀수면 쓰기 중
+    unsigned epoch;                                // 새로 시작하는 읽기가 쓸 카운터 (0 또는 1)
+    _Alignas(RBTREE_CACHE_LINE) node_t *retired;   // 지웠지만 아직 해제하지 않은 노드 (parent 필드로 연결)
+    size_t n_retired;
+    reader_slot readers[RBTREE_READER_SLOTS];
+};
+
+static unsigned next_reader_slot;                        // 다음 스레드에 배정할 카운터 번호
+static _Thread_local unsigned my_reader_slot = UINT_MAX; // 이 스레드의 카운터 번호 (모든 트리에서 공용)
+
+// 쓰기 구간 : 시퀀스를 홀수로 만든 뒤의 쓰기가 그보다 먼저 보이지 않도록 release fence
+static inline void write_begin(rbtree *t) {
+    struct rbtree_sync *s = t->sync;
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_end(rbtree *t) {
+    struct rbtree_sync *s = t->sync;
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+// 읽기 스레드가 읽는 포인터. 새 노드는 초기화를 마친 뒤 연결되므로 acquire로 읽으면 초기화된 내용이 보임
+#define READ_PTR(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+// 쓰기 스레드가 바꾸는 자식 포인터(left/right)와 루트. READ_PTR와 짝을 이루도록 원자적으로, release로 씀
+#define SET_LINK(p, field, v) __atomic_store_n(&(p)->field, (v), __ATOMIC_RELEASE)
+#else
+#define SET_LINK(p, field, v) ((p)->field = (v))
+
+static inline void write_begin(rbtree *t) {
+    (void)t;
+}
+
+static inline void write_end(rbtree *t) {
+    (void)t;
+}
+#endif
+
+#ifdef SENTINEL
+/**
+ * 모든 트리가 함께 쓰는 센티넬
+ * 트리마다 따로 할당하면 자식 포인터가 nil을 가리키는 노드를 다른 트리로 옮길 때 그 포인터를 모두 고쳐야 함
+ * 하나를 함께 쓰면 노드를 그대로 넘길 수 있으므로 rbtree_join / rbtree_split이 O(log n)에 끝남
+ * 여러 트리가 동시에 읽으므로 아무도 nil에 쓰지 않음 -> const로 읽기 전용 영역에 두어 실수로 쓰면 바로 멈추게 함
+ * 부모는 읽지 않으므로 NULL (삭제 fixup은 x의 부모를 따로 들고 다님)
+ */
+static const node_t rbtree_nil = {
+#ifdef RBTREE_COMPACT
+    .parent_color = RBTREE_BLACK,
+#else
+    .color = RBTREE_BLACK,
+#endif
+    .left = (node_t *)&rbtree_nil,
+    .right = (node_t *)&rbtree_nil,
+#ifdef RBTREE_INTERVAL
+    .max_end = INT_MIN, // 빈 서브트리는 어떤 구간과도 겹치지 않음
+#endif
+};
+#endif
 
 rbtree *new_rbtree(void) {
     // rbtree 구조체 1개 크기만큼 메모리를 0으로 초기화하여 할당 - calloc 사용
@@ -8,24 +137,28 @@ rbtree *new_rbtree(void) {
     if (p == NULL) { // 메모리 부족 등으로 실패했을 경우
         return NULL;
     }
-#ifdef SENTINEL
-    // 모든 빈 자리를 없음을 가리키는 공용 노드 nil를 가리키게 함
-    node_t *nil = (node_t *)calloc(1, sizeof(node_t));
-    if (nil == NULL) { // nil 생성 실패 시
+#ifdef RBTREE_STATS
+    p->stats = (rbtree_stats *)calloc(1, sizeof(rbtree_stats));
+    if (p->stats == NULL) {
         free(p);
         return NULL;
     }
-
-    // rbtree에서 모든 nil은 모두 BLACK
-    nil->color = RBTREE_BLACK;
-
-    // NIL의 좌/우/부모를 자기 자신
-    nil->left = nil;
-    nil->right = nil;
-    nil->parent = nil;
-
-    p->nil = nil;  // tree의 공용 nil 포인터
-    p->root = nil; // 루트 또한 nil
+#endif
+#ifdef RBTREE_CONCURRENT
+    // 카운터들이 다른 데이터와 캐시 라인을 나눠 쓰지 않도록 캐시 라인 경계에 맞춰 할당
+    p->sync = (struct rbtree_sync *)aligned_alloc(RBTREE_CACHE_LINE, sizeof(struct rbtree_sync));
+    if (p->sync == NULL) {
+#ifdef RBTREE_STATS
+        free(p->stats);
+#endif
+        free(p);
+        return NULL;
+    }
+    memset(p->sync, 0, sizeof(struct rbtree_sync));
+#endif
+#ifdef SENTINEL
+    p->nil = (node_t *)&rbtree_nil; // 모든 트리의 공용 nil 포인터
+    p->root = p->nil;               // 루트 또한 nil
 #else
     // SENTINEL 방식이 아닐 경우
     p->root = NULL;
@@ -33,361 +166,2069 @@ rbtree *new_rbtree(void) {
     return p;
 }
 
-static void free_subtree(rbtree *t, node_t *x) {
-    if (x == t->nil) {
-        return;
+// rbtree 높이의 상한. 높이는 2 * log2(n + 1) 이하이고 n < 2^64 이므로 128이면 충분
+#define RBTREE_MAX_HEIGHT 128
+
+/**
+ * 노드 부가 정보(augmentation) 유지
+ * RBTREE_ORDER_STAT 모드에서는 각 노드가 자기 서브트리의 노드 수(size)를 가짐 (RBTREE_MULTISET이면 count의 합)
+ * RBTREE_INTERVAL 모드에서는 각 노드가 자기 서브트리의 가장 큰 구간 끝(max_end)을 가짐
+ * 자식이 바뀌는 모든 곳(회전, 삽입/삭제 경로)에서 augment_update로 자식 값으로부터 다시 계산
+ * 모드가 꺼져 있으면 빈 함수가 되어 컴파일러가 호출 자체를 지워버림
+ */
+#if defined(RBTREE_ORDER_STAT) || defined(RBTREE_INTERVAL)
+#define RBTREE_AUGMENTED
+#endif
+
+static inline void augment_update(node_t *x) {
+#ifdef RBTREE_ORDER_STAT
+    x->size = x->left->size + x->right->size + rbtree_key_count(x); // nil의 size는 0
+#endif
+#ifdef RBTREE_INTERVAL
+    key_t m = x->left->max_end > x->end ? x->left->max_end : x->end; // nil의 max_end는 INT_MIN
+    x->max_end = x->right->max_end > m ? x->right->max_end : m;
+#endif
+}
+
+// x부터 루트까지 올라가며 부가 정보를 다시 계산 -> 트리 높이만큼 O(log n)
+static inline void augment_path(const rbtree *t, node_t *x) {
+#ifdef RBTREE_AUGMENTED
+    while (x != t->nil) {
+        augment_update(x);
+        x = rbtree_parent(x);
     }
-    // 후위 순회를 통해 모든 자식 노드까지 메모리 해제
-    // -> 왜 후위순회여야 하는가?
-    // 부모를 먼저 해제한다면 자식 노드를 참조할 수 없게 되기때문에 자식을 해제하지 못함
-    free_subtree(t, x->left);
-    free_subtree(t, x->right);
-    free(x);
+#endif
 }
 
-void delete_rbtree(rbtree *t) {
-    if (t == NULL)
-        return;
-    free_subtree(t, t->root);
-    free(t->nil); // 센티넬 해제
-    free(t);      // 트리 자체를 해제
+// 새 노드 z를 y의 자식으로 붙인 뒤(fixup 전) y부터 루트까지 z 몫의 부가 정보를 더함 -> O(log n)
+// 내려가면서 미리 더하지 못한 경우(이웃 옆에 바로 붙이거나 같은 키가 있는지 보고 나서 붙일 때)에 씀
+static inline void augment_add(const rbtree *t, node_t *y, const node_t *z) {
+#ifdef RBTREE_AUGMENTED
+    for (; y != t->nil; y = rbtree_parent(y)) {
+#ifdef RBTREE_ORDER_STAT
+        y->size++;
+#endif
+#ifdef RBTREE_INTERVAL
+        y->max_end = z->end > y->max_end ? z->end : y->max_end;
+#endif
+    }
+#else
+    (void)t, (void)y, (void)z;
+#endif
 }
 
-/**
- * sentinel 방식만을 사용하는 구현
- * 상황 가정
- * x의 부모가 p
- * x의 right(오른쪽 자식)이 y, left가 A
- * y의 왼쪽 자식이 B, 오른쪽 자식이 C
- * x의 오른쪽 자식 y를 x 자리로 끌어올리고, x를 y의 왼쪽 자식으로 보내는 좌회전
- */
-static void left_rotate(rbtree *t, node_t *x) {
-    node_t *y = x->right;    // 1. y는 x의 오른쪽 자식
-    x->right = y->left;      // 2. x의 오른쪽 자식을 y가 아닌 y의 왼쪽 자식인 B로 변경
-    if (y->left != t->nil) { // 3. 만약 y의 왼쪽 자식 B가 존재한다면 (nil이 아니라면)
-        y->left->parent = x; // 4. y 왼쪽 자식 B의 부모는 x가 됨
+// 풀에 capacity_hint가 주어지지 않았을 때 첫 slab의 노드 수
+#define POOL_DEFAULT_CAPACITY 64
+
+// slab : 노드 여러 개를 한 번에 담는 연속된 메모리 블록
+// rbtree_split / rbtree_join으로 노드가 다른 트리로 옮겨 가면 한 slab의 노드가 여러 트리에 흩어지므로
+// slab은 그 노드를 가진 풀들이 참조 수로 함께 소유하고, 마지막 풀이 놓을 때 해제됨
+typedef struct node_slab {
+    size_t refs;     // 이 slab을 가진 풀의 수. 다른 스레드의 트리와 함께 가질 수 있으므로 원자적으로 바꿈
+    size_t capacity; // 이 slab이 담을 수 있는 노드 수
+    node_t nodes[];  // 유연 배열 멤버(flexible array member) - 구조체 뒤에 노드들이 바로 이어짐
+} node_slab;
+
+struct node_pool {
+    node_slab **slabs; // 이 풀이 가진 slab들 (해제할 때 참조 수를 줄임)
+    size_t n_slabs, max_slabs;
+    node_slab *current; // 새 노드를 잘라 주는 slab. 다른 풀에서 넘겨받은 slab에서는 자르지 않으므로 NULL일 수 있음
+    size_t used;        // current에서 이미 나눠준 노드 수
+    node_t *free_list;  // erase로 반납된 노드들. left 필드를 다음 노드 링크로 재활용
+};
+
+// slab 배열에 extra개가 더 들어갈 자리를 확보
+static int pool_reserve(struct node_pool *pool, const size_t extra) {
+    if (pool->n_slabs + extra <= pool->max_slabs) {
+        return 0;
+    }
+    size_t max = pool->max_slabs * 2 > pool->n_slabs + extra ? pool->max_slabs * 2 : pool->n_slabs + extra;
+    node_slab **slabs = (node_slab **)realloc(pool->slabs, max * sizeof(node_slab *));
+    if (slabs == NULL) {
+        return -1;
+    }
+    pool->slabs = slabs;
+    pool->max_slabs = max;
+    return 0;
+}
+
+// capacity개의 노드를 담는 slab을 새로 만들어 노드를 잘라 줄 slab으로 삼음
+static int pool_grow(struct node_pool *pool, const size_t capacity) {
+    if (pool_reserve(pool, 1) != 0) {
+        return -1;
+    }
+    node_slab *s = (node_slab *)malloc(sizeof(node_slab) + capacity * sizeof(node_t));
+    if (s == NULL) {
+        return -1;
     }
+    s->refs = 1;
+    s->capacity = capacity;
+    pool->slabs[pool->n_slabs++] = s;
+    pool->current = s;
+    pool->used = 0;
+    return 0;
+}
 
-    y->parent = x->parent;             // 5. y의 부모를 x의 부모로 변경
-    if (x->parent == t->nil) {         // 6. 만약 x 자신이 트리의 루트라면 ()
-        t->root = y;                   // 7. 트리의 루트는 y가 됨
-    } else if (x == x->parent->left) { // 8. 만약 x의 부모의 left가 x라면 (x가 왼쪽 자식이라면)
-        x->parent->left = y;           // 9. 기존 x 부모의 왼쪽 자식을 y로 변경
-    } else {                           // 10. x가 부모의 오른쪽 자식이었다면
-        x->parent->right = y;          // 11. x 부모 오른쪽이 y가 됨
+// 풀이 가진 slab을 전부 놓음 -> 노드 개수와 상관없이 slab 개수만큼만 free (다른 풀도 가진 slab은 남김)
+static void pool_destroy(struct node_pool *pool) {
+    for (size_t i = 0; i < pool->n_slabs; i++) {
+        if (__atomic_sub_fetch(&pool->slabs[i]->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+            free(pool->slabs[i]);
+        }
     }
+    free(pool->slabs);
+    free(pool);
+}
 
-    y->left = x;   // 12. y의 왼쪽 자식을 x로 변경
-    x->parent = y; // 13. x의 부모를 y로 변경
+// pool의 slab을 모두 함께 가지는 빈 풀 (rbtree_split으로 떼어낸 쪽). 새 노드는 자기 slab을 만들어 자름
+static struct node_pool *pool_share(struct node_pool *pool) {
+    struct node_pool *p = (struct node_pool *)calloc(1, sizeof(struct node_pool));
+    if (p == NULL || pool_reserve(p, pool->n_slabs) != 0) {
+        free(p);
+        return NULL;
+    }
+    for (size_t i = 0; i < pool->n_slabs; i++) {
+        __atomic_add_fetch(&pool->slabs[i]->refs, 1, __ATOMIC_RELAXED);
+        p->slabs[p->n_slabs++] = pool->slabs[i];
+    }
+    return p;
 }
 
 /**
- * sentinel 방식만을 사용하는 구현 (우회전)
- * 상황 가정
- * y의 부모가 p
- * y의 left(왼쪽 자식)이 x, right가 C
- * x의 왼쪽 자식이 A, 오른쪽 자식이 B
- * y의 왼쪽 자식 x를 y 자리로 끌어올리고, y를 x의 오른쪽 자식으로 보내는 우회전
+ * src의 slab과 free list를 dst로 옮기고 src를 해제 (rbtree_join으로 합쳐지는 쪽)
+ * dst가 이미 가진 slab은 참조 하나를 놓기만 함 -> 나눴다 합치기를 반복해도 slab 배열이 자라지 않음
+ * slab 수만큼의 비교와 src free list 길이만큼의 이동이 듦. 실패 시 -1 (두 풀 모두 그대로)
  */
-static void right_rotate(rbtree *t, node_t *y) {
-    node_t *x = y->left;      // 1. x는 y의 왼쪽 자식
-    y->left = x->right;       // 2. y의 왼쪽 자식을 x의 오른쪽 자식 B로 변경
-    if (x->right != t->nil)   // 3. 만약 x의 오른쪽 자식 B가 존재한다면 (nil이 아니라면)
-        x->right->parent = y; // 4. B의 부모는 y가 됨
-
-    x->parent = y->parent;             // 5. x의 부모를 y의 부모로 변경 (x가 y의 자리로 승격)
-    if (y->parent == t->nil) {         // 6. y 자신이 트리의 루트라면
-        t->root = x;                   // 7. 트리의 루트는 x가 됨
-    } else if (y == y->parent->left) { // 8. y가 부모의 왼쪽 자식이었다면
-        y->parent->left = x;           // 9. 부모의 왼쪽 자식을 x로 변경
-    } else {                           // 10. y가 부모의 오른쪽 자식이었다면
-        y->parent->right = x;          // 11. 부모의 오른쪽 자식을 x로 변경
-    }
-
-    x->right = y;  // 12. x의 오른쪽 자식을 y로 변경
-    y->parent = x; // 13. y의 부모를 x로 변경
-}
-
-// 삽입 이후 rbtree가 규칙을 위반하지 않도록 복구
-static void rbtree_fixup(rbtree *t, node_t *z) {
-    // 삽입된 노드의 부모가 RED인 경우만 반복. 부모가 BLACK이어야 규칙 4를 위반x
-    while (z->parent->color == RBTREE_RED) {
-        if (z->parent == z->parent->parent->left) { // z의 부모가 z의 조부모의 왼쪽 자식이라면
-            node_t *y = z->parent->parent->right;   // 삼촌을 확인해야 함
-            // Case 1 : z 삼촌의 색이 RED라면 -> 부모, 삼촌 둘 다 RED
-            if (y->color == RBTREE_RED) {
-                // z 조부모와 그 자식들의 색을 바꾼 후 문제를 위로 올림
-                z->parent->color = RBTREE_BLACK;       // 1. z 부모의 색 BLACK
-                y->color = RBTREE_BLACK;               // 2. z 삼촌의 색 BLACK
-                z->parent->parent->color = RBTREE_RED; // 3. z 조부모의 색 RED
-                z = z->parent->parent;                 // 4. 조부모부터 다시 검사
-            } else {                                   // z 삼촌의 색이 BLACK
-                // Case 2 : z가 zp의 오른쪽 자식일 경우
-                if (z == z->parent->right) {
-                    z = z->parent; // 회전 축을 z에서 z의 부모로 변경
-                    // 윗줄이 잘 이해가 안갔음. left rotate시 z의 부모가 원래 z가 있어야 할 자리로 가기 때문에
-                    // z를 z->parent로 변경해주어야 올바른 case 3으로 시작할 수 있게 되는 거였다.
-                    left_rotate(t, z); // 좌회전하여 case 3으로 만들기
-                }
-                // Case 3 : z가 z 부모의 왼쪽 자식
-                z->parent->color = RBTREE_BLACK;       // 1. z의 부모를 black
-                z->parent->parent->color = RBTREE_RED; // 2. z의 조부모를 red
-                right_rotate(t, z->parent->parent);    // 3. z의 조부모를 기준으로 right rotate
-                // -> RED-RED 인접이 해소되고 Black-height가 유지됨
-            }
-        } else {                                 // 대칭 케이스 : 부모가 조부모의 오른쪽 자식
-            node_t *y = z->parent->parent->left; // 삼촌은 조부모의 왼쪽
-            // Case 1
-            if (y->color == RBTREE_RED) {
-                z->parent->color = RBTREE_BLACK;
-                y->color = RBTREE_BLACK;
-                z->parent->parent->color = RBTREE_RED;
-                z = z->parent->parent;
-            } else {
-                // Case 2
-                if (z == z->parent->left) {
-                    z = z->parent;
-                    right_rotate(t, z);
-                }
-                // Case 3
-                z->parent->color = RBTREE_BLACK;
-                z->parent->parent->color = RBTREE_RED;
-                left_rotate(t, z->parent->parent);
-            }
+static int pool_adopt(struct node_pool *dst, struct node_pool *src) {
+    if (pool_reserve(dst, src->n_slabs) != 0) {
+        return -1;
+    }
+    const size_t n = dst->n_slabs;
+    for (size_t i = 0; i < src->n_slabs; i++) {
+        size_t j = 0;
+        while (j < n && dst->slabs[j] != src->slabs[i]) {
+            j++;
         }
+        if (j == n) {
+            dst->slabs[dst->n_slabs++] = src->slabs[i];
+        } else {
+            __atomic_sub_fetch(&src->slabs[i]->refs, 1, __ATOMIC_RELAXED); // dst가 쥐고 있으므로 0이 되지 않음
+        }
+    }
+    if (src->free_list != NULL) {
+        node_t *last = src->free_list;
+        while (last->left != NULL) {
+            last = last->left;
+        }
+        last->left = dst->free_list;
+        dst->free_list = src->free_list;
     }
-    t->root->color = RBTREE_BLACK; // 루트의 색은 항상 BLACK
+    src->n_slabs = 0;
+    pool_destroy(src);
+    return 0;
 }
 
-node_t *rbtree_insert(rbtree *t, const key_t key) {
-    node_t *z = (node_t *)malloc(sizeof(node_t)); // key를 넣을 새 노드 z 동적 할당
-    if (z == NULL) {                              // z 메모리 할당 실패
+rbtree *new_rbtree_with_pool(const size_t capacity_hint) {
+    rbtree *t = new_rbtree();
+    if (t == NULL) {
         return NULL;
     }
-    // z 노드 초기화
-    z->key = key;
-    z->color = RBTREE_RED;
-    z->parent = z->left = z->right = t->nil;
+    struct node_pool *pool = (struct node_pool *)calloc(1, sizeof(struct node_pool));
+    if (pool == NULL || pool_grow(pool, capacity_hint > 0 ? capacity_hint : POOL_DEFAULT_CAPACITY) != 0) {
+        free(pool);
+        delete_rbtree(t);
+        return NULL;
+    }
+    t->pool = pool;
+    STAT_ADD(t, mallocs, 1);
+    return t;
+}
 
-    node_t *x = t->root; // x가 루트부터 내려갈 노드
-    node_t *y = t->nil;  // z의 부모 후보
-    // z의 올바른 삽입 위치 찾기
-    while (x != t->nil) {
-        y = x;
-        if (key < x->key) {
-            x = x->left;
+// 정렬된 arr[lo, hi) 구간으로 균형 잡힌 서브트리를 만들고 그 루트를 반환
+// 가운데 원소를 루트로 삼고 양쪽 절반을 재귀로 만듦. 재귀 깊이는 log n
+// arr[i]는 nodes[i]에 들어가므로 노드들이 메모리에서도 키 순서대로 놓임
+// arr이 NULL이면 nodes[i].key에 키가 이미 채워져 있는 것으로 보고 연결만 함 (rbtree_load)
+static node_t *build_sorted(rbtree *t, node_t *nodes, const key_t *arr, size_t lo, size_t hi, node_t *parent,
+                            int depth, int red_depth) {
+    if (lo >= hi) {
+        return t->nil;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    node_t *x = &nodes[mid];
+    if (arr != NULL) {
+        x->key = arr[mid];
+#ifdef RBTREE_MULTISET
+        x->count = 1;
+#endif
+    }
+#ifdef RBTREE_INTERVAL
+    x->end = x->key; // 키만 받으므로 점 구간
+#endif
+    set_parent(x, parent);
+    // 가장 깊은 레벨이 꽉 차지 않았다면 그 레벨만 RED, 나머지는 BLACK
+    // -> 모든 경로의 BLACK 개수가 같고, RED 노드의 부모는 항상 BLACK이라 회전이 필요 없음
+    set_color(x, depth == red_depth ? RBTREE_RED : RBTREE_BLACK);
+#ifdef RBTREE_COW
+    x->refs = 1;
+#endif
+    x->left = build_sorted(t, nodes, arr, lo, mid, x, depth + 1, red_depth);
+    x->right = build_sorted(t, nodes, arr, mid + 1, hi, x, depth + 1, red_depth);
+    augment_update(x);
+    return x;
+}
+
+// new_rbtree_with_pool(n)으로 만든 빈 트리의 첫 slab 앞쪽 노드 n개를 균형 잡힌 트리로 연결
+static void link_sorted(rbtree *t, const key_t *arr, const size_t n) {
+    // 가운데를 루트로 나누면 양쪽 크기 차이가 최대 1이므로 빈 자리는 모두 가장 깊은 레벨에만 생김
+    // 꽉 찬 레벨의 수 = floor(log2(n + 1)) 이고, 그 바로 다음 레벨(0부터 센 깊이)이 부분적으로 채워진 레벨
+    int red_depth = 0;
+    while (((size_t)2 << red_depth) - 1 <= n) {
+        red_depth++;
+    }
+    t->root = build_sorted(t, t->pool->current->nodes, arr, 0, n, t->nil, 0, red_depth);
+    t->pool->used = n;
+    STAT_ADD(t, node_allocs, n);
+}
+
+#ifdef RBTREE_MULTISET
+// 정렬된 키 n개(arr, NULL이면 nodes[i].key)에서 연속된 같은 키를 노드 하나의 count로 모아 nodes 앞쪽에 채움
+// 남은 노드 수를 반환. 앞에서부터 읽은 뒤에 쓰고 쓰는 칸은 읽는 칸보다 앞이므로 제자리에서 모아도 됨
+static size_t pack_counts(node_t *nodes, const key_t *arr, const size_t n) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        const key_t key = arr != NULL ? arr[i] : nodes[i].key;
+        if (m > 0 && nodes[m - 1].key == key) {
+            nodes[m - 1].count++;
         } else {
-            x = x->right;
+            nodes[m].key = key;
+            nodes[m++].count = 1;
         }
     }
+    return m;
+}
+#endif
 
-    // z와 부모 자식 연결
-    z->parent = y;
-    if (y == t->nil) {
-        t->root = z;
-    } else if (key < y->key) {
-        y->left = z;
+rbtree *rbtree_from_sorted(const key_t *arr, const size_t n) {
+    if (arr == NULL && n > 0) {
+        return NULL;
+    }
+    // 노드 n개를 한 slab(한 번의 malloc)에 담는 풀 트리로 생성
+    // 이후 insert는 다음 slab에서, erase된 노드는 free list로 재사용됨
+    rbtree *t = new_rbtree_with_pool(n);
+    if (t == NULL || n == 0) {
+        return t;
+    }
+#ifdef RBTREE_MULTISET
+    link_sorted(t, NULL, pack_counts(t->pool->current->nodes, arr, n)); // 중복 키가 있으면 slab 뒤쪽이 남음
+#else
+    link_sorted(t, arr, n);
+#endif
+    return t;
+}
+
+// 새 노드 하나를 할당
+// 풀이 없으면 malloc, 있으면 free list -> 현재 slab의 남은 칸 -> 새 slab 순서로 꺼내옴
+static node_t *node_alloc(rbtree *t) {
+    struct node_pool *pool = t->pool;
+    node_t *z;
+    if (pool == NULL) {
+        z = (node_t *)malloc(sizeof(node_t));
+        if (z == NULL) {
+            return NULL;
+        }
+        STAT_ADD(t, mallocs, 1);
+    } else if (pool->free_list != NULL) { // 반납된 노드가 있다면 가장 먼저 재사용
+        z = pool->free_list;
+        pool->free_list = z->left;
     } else {
-        y->right = z;
+        // 현재 slab이 가득 찼다면 두 배 크기의 slab 추가 (넘겨받은 slab만 있는 풀은 기본 크기부터)
+        if (pool->current == NULL || pool->used == pool->current->capacity) {
+            if (pool_grow(pool, pool->current != NULL ? pool->current->capacity * 2 : POOL_DEFAULT_CAPACITY) != 0) {
+                return NULL;
+            }
+            STAT_ADD(t, mallocs, 1);
+        }
+        z = &pool->current->nodes[pool->used++];
     }
+    STAT_ADD(t, node_allocs, 1);
+#ifdef RBTREE_COW
+    z->refs = 1;
+#endif
+    return z;
+}
 
-    // rb트리의 조건을 모두 만족하도록 복구
-    rbtree_fixup(t, z);
+// 노드 하나를 반납. 풀 모드에서는 실제로 해제하지 않고 free list에 올려둠
+static void node_free(rbtree *t, node_t *z) {
+    struct node_pool *pool = t->pool;
+    STAT_ADD(t, node_frees, 1);
+    if (pool == NULL) {
+        free(z);
+        return;
+    }
+    z->left = pool->free_list;
+    pool->free_list = z;
+}
 
-    return z; // 삽입된 노드의 포인터 반환
+#ifdef RBTREE_COW
+// fixup 한 번에 필요한 복사 수의 여유분. 경로 길이에 더해 delete_fixup의 종료 케이스(형제, 조카)와 x 자신의 몫
+#define RBTREE_COW_FIXUP_SPARE 8
+
+/**
+ * x를 복사해서 원본 트리에서 x의 자리를 대신하게 함
+ * x의 부모는 이미 이 트리만 쓰는 노드여야 함 (그래야 부모의 자식 포인터를 고쳐도 스냅샷이 영향을 받지 않음)
+ * x는 스냅샷에만 남으므로 x의 자식들은 스냅샷 쪽 부모가 하나 늘어남
+ * 자식들의 부모 포인터는 복사본을 가리키게 바꿈 (스냅샷은 부모 포인터를 읽지 않음)
+ */
+static node_t *cow_clone(rbtree *t, node_t *x) {
+    node_t *n;
+    if (t->spare != NULL) { // fixup 도중에는 미리 할당해 둔 노드를 쓰므로 실패하지 않음
+        n = t->spare;
+        t->spare = n->left;
+        t->n_spare--;
+    } else if ((n = node_alloc(t)) == NULL) {
+        return NULL;
+    }
+    *n = *x;
+    n->refs = 1;
+    x->refs--; // 스냅샷에서만 보이므로 0이 되지 않음
+    if (x->left != t->nil) {
+        x->left->refs++;
+        set_parent(x->left, n);
+    }
+    if (x->right != t->nil) {
+        x->right->refs++;
+        set_parent(x->right, n);
+    }
+    node_t *p = rbtree_parent(x);
+    if (p == t->nil) {
+        SET_LINK(t, root, n);
+    } else if (p->left == x) {
+        SET_LINK(p, left, n);
+    } else {
+        SET_LINK(p, right, n);
+    }
+    return n;
 }
 
-node_t *rbtree_find(const rbtree *t, const key_t key) {
-    node_t *x = t->root;
+/**
+ * x를 이 트리만 쓰는 노드로 만들어 반환 (이미 그렇다면 x 그대로, 공유 중이면 복사본)
+ * 루트에서 아래로 내려가는 순서로 불러야 함 -> 부모가 이 트리 전용일 때 refs == 1이면 다른 경로로 x를 볼 수 없음
+ * 할당 실패 시 NULL. 복사는 트리의 내용을 바꾸지 않으므로 도중에 실패해도 트리는 올바름
+ */
+static inline node_t *cow_own(rbtree *t, node_t *x) {
+    if (t->snapshots == 0 || x == t->nil || x->refs == 1) {
+        return x;
+    }
+    return cow_clone(t, x);
+}
 
-    while (x != t->nil) {
-        if (x->key == key) {
-            return x;
+// fixup 도중의 복사가 실패하지 않도록 노드 n개를 미리 할당해 둠
+static int cow_reserve(rbtree *t, const size_t n) {
+    while (t->n_spare < n) {
+        node_t *x = node_alloc(t);
+        if (x == NULL) {
+            return -1;
         }
-        if (key < x->key) {
-            x = x->left;
-        } else {
-            x = x->right;
+        x->left = t->spare;
+        t->spare = x;
+        t->n_spare++;
+    }
+    return 0;
+}
+
+// 삽입 전 준비 : key가 들어갈 경로의 노드를 모두 이 트리 전용으로 만들고 fixup에 쓸 노드를 확보
+// leaf에는 새 노드의 부모가 될 노드를 기록 (빈 트리면 nil). 실패 시 -1 (트리는 그대로)
+static int cow_prepare_insert(rbtree *t, const key_t key, node_t **leaf) {
+    size_t depth = 0;
+    *leaf = t->nil;
+    for (node_t *x = t->root; x != t->nil; depth++) {
+        if ((x = cow_own(t, x)) == NULL) {
+            return -1;
         }
+        *leaf = x;
+        x = key < x->key ? x->left : x->right;
     }
+    return cow_reserve(t, depth + RBTREE_COW_FIXUP_SPARE);
+}
 
-    return NULL;
+// 루트에서 z까지의 경로를 이 트리 전용으로 만들고 이 트리 전용이 된 z를 반환. 실패 시 NULL (트리는 그대로)
+static node_t *cow_own_path(rbtree *t, node_t *z) {
+    node_t *path[RBTREE_MAX_HEIGHT];
+    size_t depth = 0;
+    for (node_t *x = z; x != t->nil; x = rbtree_parent(x)) {
+        path[depth++] = x;
+    }
+    while (depth > 0) { // 루트부터 내려오며 복사. 부모를 복사해도 자식 노드 자체는 그대로이므로 path[]는 유효
+        z = cow_own(t, path[--depth]);
+        if (z == NULL) {
+            return NULL;
+        }
+    }
+    return z;
 }
 
-// 트리에서의 최솟값 반환
-node_t *rbtree_min(const rbtree *t) {
-    node_t *x = t->root;
-    if (x == NULL) {
+// 삭제 전 준비 : 루트에서 z까지, 그리고 z의 successor까지의 경로를 이 트리 전용으로 만듦
+// z가 복사되었을 수 있으므로 이 트리 전용이 된 z를 반환. 실패 시 NULL (트리는 그대로)
+static node_t *cow_prepare_erase(rbtree *t, node_t *z) {
+    if ((z = cow_own_path(t, z)) == NULL) {
         return NULL;
     }
-    while (x->left != t->nil) {
-        x = x->left;
+    size_t depth = 0;
+    if (z->left != t->nil && z->right != t->nil) {
+        for (node_t *y = z->right; y != t->nil; y = y->left, depth++) {
+            if ((y = cow_own(t, y)) == NULL) {
+                return NULL;
+            }
+        }
     }
-    return x;
+    for (node_t *x = z; x != t->nil; x = rbtree_parent(x)) {
+        depth++;
+    }
+    return cow_reserve(t, depth + RBTREE_COW_FIXUP_SPARE) == 0 ? z : NULL;
 }
 
-// 트리의 최댓값 반환
-node_t *rbtree_max(const rbtree *t) {
-    node_t *x = t->root;
-    if (x == NULL) {
+// 남은 예비 노드를 모두 반납 (마지막 스냅샷이 해제될 때)
+static void cow_drop_spare(rbtree *t) {
+    while (t->spare != NULL) {
+        node_t *x = t->spare;
+        t->spare = x->left;
+        node_free(t, x);
+    }
+    t->n_spare = 0;
+}
+
+const rbtree *rbtree_snapshot(rbtree *t) {
+    if (t == NULL || t->origin != NULL) { // 스냅샷의 스냅샷은 만들지 않음
         return NULL;
     }
-    while (x->right != t->nil) {
-        x = x->right;
+    rbtree *s = (rbtree *)malloc(sizeof(rbtree));
+    if (s == NULL) {
+        return NULL;
     }
-    return x;
+    *s = *t; // root, nil, pool(과 통계)을 함께 씀
+    s->origin = t;
+    s->snapshots = 0;
+    s->spare = NULL;
+    s->n_spare = 0;
+    if (t->root != t->nil) {
+        t->root->refs++;
+    }
+    t->snapshots++;
+    return s;
 }
 
-// 서브트리에서 successor 찾기 (오른쪽 서브트리 중 가장 작은 값)
-static node_t *subtree_min(rbtree *t, node_t *x) {
-    while (x->left != t->nil) { // 왼쪽 끝까지 내려가며 최소 찾기
-        x = x->left;
+void rbtree_snapshot_release(const rbtree *snapshot) {
+    if (snapshot == NULL) {
+        return;
     }
+    rbtree *t = snapshot->origin;
+    // 참조 수를 줄여 0이 된 노드만 해제하고 그 자식으로 내려감
+    // 원본 트리나 다른 스냅샷도 보는 노드에서 멈추므로 이 스냅샷만 보던 옛 경로의 노드만 방문
+    // 한 노드를 꺼낼 때마다 자식 둘을 쌓으므로 스택 깊이는 트리 높이 + 1 이하
+    node_t *stack[RBTREE_MAX_HEIGHT + 1];
+    size_t top = 0;
+    if (snapshot->root != t->nil) {
+        stack[top++] = snapshot->root;
+    }
+    while (top > 0) {
+        node_t *x = stack[--top];
+        if (--x->refs > 0) {
+            continue;
+        }
+        if (x->left != t->nil) {
+            stack[top++] = x->left;
+        }
+        if (x->right != t->nil) {
+            stack[top++] = x->right;
+        }
+        node_free(t, x);
+    }
+    if (--t->snapshots == 0) {
+        cow_drop_spare(t);
+    }
+    free((void *)snapshot);
+}
+#else
+static inline node_t *cow_own(rbtree *t, node_t *x) {
+    (void)t;
     return x;
 }
+#endif
 
-// u의 자리에 v를 이식
-static void transplant(rbtree *t, node_t *u, node_t *v) {
-    if (u->parent == t->nil) { // u가 루트였다면
-        t->root = v;
-    } else if (u == u->parent->left) { // u가 왼쪽 자식이었다면
-        u->parent->left = v;
-    } else { // u가 오른쪽 자식이었다면
-        u->parent->right = v;
-    }
-    v->parent = u->parent; // 부모 갱신
-}
-
-// 삭제 후 doubly black을 해소
-// x는 검정 높이를 보전해야하는 자리
-static void delete_fixup(rbtree *t, node_t *x) {
-    // x가 루트가 아니고, x가 검정일 때만 반복
-    while (x != t->root && x->color == RBTREE_BLACK) {
-        if (x == x->parent->left) {       // x가 왼쪽 자식일 경우
-            node_t *w = x->parent->right; // x의 형제 w
-            // Case 1 : 형제가 RED
-            if (w->color == RBTREE_RED) {
-                w->color = RBTREE_BLACK;       // 형제를 BLACK
-                x->parent->color = RBTREE_RED; // 부모를 RED
-                left_rotate(t, x->parent);     // 부모 기준 좌회전으로 검정 형제의 상황 만들기
-                w = x->parent->right;          // 새로운 형제 갱신
-            }
+#ifdef RBTREE_CONCURRENT
+unsigned rbtree_read_lock(const rbtree *t) {
+    struct rbtree_sync *s = t->sync;
+    if (my_reader_slot == UINT_MAX) {
+        my_reader_slot = __atomic_fetch_add(&next_reader_slot, 1, __ATOMIC_RELAXED) % RBTREE_READER_SLOTS;
+    }
+    unsigned e = __atomic_load_n(&s->epoch, __ATOMIC_SEQ_CST);
+    // seq_cst : 카운터를 늘린 것이 이후 트리를 읽는 것보다 먼저 쓰기 스레드에게 보여야 함
+    __atomic_fetch_add(&s->readers[my_reader_slot].count[e], 1, __ATOMIC_SEQ_CST);
+    return my_reader_slot * 2 + e;
+}
 
-            // 여기부터는 형제가 BLACK
-            // Case 2 : 형제의 두 자식 모두 BLACK -> 형제를 RED로 칠하고 부모로 extra-black을 올려보냄
-            if (w->left->color == RBTREE_BLACK && w->right->color == RBTREE_BLACK) {
-                w->color = RBTREE_RED;
-                x = x->parent;
-            } else {
-                if (w->right->color == RBTREE_BLACK) {
-                    // Case 3 : 형제의 오른쪽 자식이 BLACK, 왼쪽 자식이 RED
-                    w->left->color = RBTREE_BLACK; // 왼쪽 자식을 BLACK
-                    w->color = RBTREE_RED;         // 형제는 RED
-                    right_rotate(t, w);            // 형제 기준 우회전으로 Case 4를 만들고 Case 4로 해결
-                    w = x->parent->right;          // 형제 갱신
-                }
-                // Case 4 : 형제의 오른쪽 자식이 RED
-                w->color = x->parent->color;     // 형제는 부모의 색을 물려받음
-                x->parent->color = RBTREE_BLACK; // 부모는 BLACK
-                w->right->color = RBTREE_BLACK;  // 형제의 오른쪽 자식을 BLACK
-                left_rotate(t, x->parent);       // 부모 기준 좌회전
-                x = t->root; // 이거 왜하냐 -> while문 종료의 break의 역할임. Case 4가 해결되면 무조건 해결됨
-            }
-        } else { // 대칭 : x가 오른쪽 자식인 경우
-            node_t *w = x->parent->left;
-            // Case 1
-            if (w->color == RBTREE_RED) {
-                w->color = RBTREE_BLACK;
-                x->parent->color = RBTREE_RED;
-                right_rotate(t, x->parent);
-                w = x->parent->left;
-            }
-            // Case 2
-            if (w->right->color == RBTREE_BLACK && w->left->color == RBTREE_BLACK) {
-                w->color = RBTREE_RED;
-                x = x->parent;
-            } else {
-                // Case 3
-                if (w->left->color == RBTREE_BLACK) {
-                    w->right->color = RBTREE_BLACK;
-                    w->color = RBTREE_RED;
-                    left_rotate(t, w);
-                    w = x->parent->left;
-                }
-                // Case 4
-                w->color = x->parent->color;
-                x->parent->color = RBTREE_BLACK;
-                w->left->color = RBTREE_BLACK;
-                right_rotate(t, x->parent);
-                x = t->root;
-            }
+void rbtree_read_unlock(const rbtree *t, unsigned ticket) {
+    __atomic_fetch_sub(&t->sync->readers[ticket / 2].count[ticket % 2], 1, __ATOMIC_RELEASE);
+}
+
+// 쓰기 스레드 : epoch를 바꾸고, 바꾸기 전에 시작한 읽기가 모두 끝날 때까지 기다림
+static void wait_for_readers(struct rbtree_sync *s) {
+    unsigned old = s->epoch;
+    __atomic_store_n(&s->epoch, old ^ 1, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < RBTREE_READER_SLOTS; i++) {
+        for (unsigned tries = 0; __atomic_load_n(&s->readers[i].count[old], __ATOMIC_SEQ_CST) != 0; tries++) {
+            spin_wait(tries);
         }
     }
-    x->color = RBTREE_BLACK; // x는 삭제 노드를 대체하게된 노드. 이것을 BLACK으로 설정하여 규칙 2, 4를 해결
 }
 
-int rbtree_erase(rbtree *t, node_t *z) {
-    if (t == NULL || z == NULL || z == t->nil) {
-        return -1;
+// 지운 노드는 읽기 스레드가 아직 지나가는 중일 수 있으므로 해제 대기 목록에 올려둠
+// 읽기 스레드는 left/right만 따라가므로 parent 필드를 목록 링크로 씀
+static void node_retire(rbtree *t, node_t *z) {
+    struct rbtree_sync *s = t->sync;
+    set_parent(z, s->retired);
+    s->retired = z;
+    s->n_retired++;
+}
+
+void rbtree_synchronize(rbtree *t) {
+    struct rbtree_sync *s = t->sync;
+    node_t *x = s->retired;
+    s->retired = NULL;
+    s->n_retired = 0;
+    wait_for_readers(s);
+    while (x != NULL) { // 이제 이 노드들을 볼 수 있는 읽기는 없음 -> 풀 또는 free로 반납
+        node_t *next = rbtree_parent(x);
+        node_free(t, x);
+        x = next;
     }
+}
 
-    node_t *y = z;                     // 트리에서 제거될 노드
-    color_t y_origin_color = y->color; // 제거되는 노드의 원래 색
-    node_t *x;                         // y를 치환하고 남는 자리
-
-    if (z->left == t->nil) {         // 왼쪽 자식이 없는 경우
-        x = z->right;                // z 자리를 z->right로 매움
-        transplant(t, z, z->right);  // z 위치에 z의 오른쪽 자식을 이식
-    } else if (z->right == t->nil) { // 오른쪽 자식이 없는 경우
-        x = z->left;
-        transplant(t, z, z->left);
-    } else {                          // 자식이 둘 다 있는 경우
-        y = subtree_min(t, z->right); // 후계자 찾기
-        y_origin_color = y->color;    // 기존 색깔 저장
-        x = y->right;                 // x가 삭제된 노드의 대체가 되기때문에 y->right로하면 nil이나
-        if (y->parent == z) {         // y의 부모가 z라면 -> 바로 오른쪽 자식이 최소
-            x->parent = y;
-        } else {
-            transplant(t, y, y->right);
-            y->right = z->right;
-            y->right->parent = y;
+/**
+ * 락 없는 읽기 (find/min/max 공용)
+ * dir == 0 : key를 가진 노드, dir < 0 : 가장 왼쪽 노드, dir > 0 : 가장 오른쪽 노드
+ * 시퀀스가 홀수(쓰기 중)이거나 탐색하는 동안 바뀌었다면 처음부터 다시 탐색
+ * 쓰기 도중의 어긋난 포인터를 따라가더라도 트리 높이의 상한을 넘으면 멈추고, 시퀀스 검사에서 재시도됨
+ */
+static node_t *read_walk(const rbtree *t, const key_t key, const int dir) {
+    const struct rbtree_sync *s = t->sync;
+    unsigned ticket = rbtree_read_lock(t);
+    node_t *found;
+    size_t compares;
+    for (unsigned tries = 0;; tries++) {
+        unsigned long seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            spin_wait(tries);
+            continue;
+        }
+        found = NULL;
+        compares = 0;
+        node_t *x = READ_PTR(t->root);
+        for (int depth = 0; x != t->nil && depth < RBTREE_MAX_HEIGHT; depth++) {
+            if (dir == 0) {
+                compares++;
+                if (x->key == key) { // key는 노드가 살아있는 동안 바뀌지 않음
+                    found = x;
+                    break;
+                }
+                x = key < x->key ? READ_PTR(x->left) : READ_PTR(x->right);
+            } else {
+                found = x;
+                x = dir < 0 ? READ_PTR(x->left) : READ_PTR(x->right);
+            }
         }
-        transplant(t, z, y); // y가 대체되었으니 왼쪽 오른쪽을 올바르게 이어주기
-        y->left = z->left;
-        y->left->parent = y;
-        y->color = z->color;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); // 위의 읽기가 아래 시퀀스 재확인보다 늦어지지 않게 함
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+        spin_wait(tries);
     }
-
-    free(z);
-    if (y_origin_color == RBTREE_BLACK) {
-        delete_fixup(t, x);
+    rbtree_read_unlock(t, ticket);
+    if (dir == 0) {
+        STAT_ADD(t, finds, 1);
+        STAT_ADD(t, find_compares, compares);
     }
-
-    return 0;
+    return found;
 }
+#endif
 
-// rbtree를 중위 순회하며 결과 배열에 저장
-// t, x는 읽기만 하므로 const가 적절
-static void inorder_store(const rbtree *t, const node_t *x, key_t *result, size_t *index, const size_t n) {
-    if (x == t->nil) {
-        return;
-    }
-    // 여기서 index의 타입은 이미 size_t * 이다
-    inorder_store(t, x->left, result, index, n);
-    if (*index < n) { // 유효한 범위(n)만큼만 결과 삽입. 테스트에서 필수는 아님
-        result[*index] = x->key;
-        (*index)++;
-    } else {
-        return;
+// 서브트리 x의 모든 노드를 해제
+// 재귀 대신 회전(rotation)으로 트리를 오른쪽으로만 뻗은 한 줄로 펴가며 해제 -> 스택을 전혀 쓰지 않음
+// 1. x에 왼쪽 자식이 없으면 x를 해제하고 오른쪽 자식으로 이동
+// 2. 왼쪽 자식 y가 있으면 x를 기준으로 우회전하여 y를 위로 올림 (y의 오른쪽 서브트리는 x의 왼쪽으로)
+// 각 노드는 한 번 회전되고 한 번 해제되므로 O(n). 곧 해제할 노드라 parent와 색은 갱신하지 않음
+// 노드는 release로 반납하고(node_free 또는 node_retire) 반납한 키 개수를 반환 (RBTREE_MULTISET이면 count의 합)
+static size_t free_subtree(rbtree *t, node_t *x, void (*release)(rbtree *, node_t *)) {
+    size_t count = 0;
+    while (x != t->nil) {
+        if (x->left == t->nil) {
+            node_t *next = x->right;
+            count += rbtree_key_count(x);
+            release(t, x);
+            x = next;
+        } else {
+            node_t *y = x->left;
+            SET_LINK(x, left, y->right); // 지운 서브트리도 읽기 스레드가 아직 지나는 중일 수 있음
+            SET_LINK(y, right, x);
+            x = y;
+        }
     }
-    inorder_store(t, x->right, result, index, n);
+    return count;
+}
+
+void delete_rbtree(rbtree *t) {
+    if (t == NULL)
+        return;
+#ifdef RBTREE_CONCURRENT
+    // 트리를 지울 때는 읽기 스레드가 없어야 하므로 기다리지 않고 해제 대기 중인 노드도 함께 해제
+    if (t->pool == NULL) {
+        for (node_t *x = t->sync->retired; x != NULL;) {
+            node_t *next = rbtree_parent(x);
+            free(x);
+            x = next;
+        }
+    }
+    free(t->sync);
+#endif
+#ifdef RBTREE_COW
+    cow_drop_spare(t);
+#endif
+    if (t->pool != NULL) {
+        pool_destroy(t->pool); // 풀 모드 : 모든 노드가 slab 안에 있으므로 slab만 해제하면 끝
+    } else {
+        free_subtree(t, t->root, node_free);
+    }
+#ifdef RBTREE_STATS
+    free(t->stats);
+#endif
+    free(t); // 트리 자체를 해제 (센티넬은 모든 트리가 함께 쓰므로 해제하지 않음)
+}
+
+// 회전, fixup, 이식, 삭제와 이웃 노드 찾기는 키를 보지 않으므로 rbtree_tmpl.h의 트리와 같은 본문(rbtree_core.h)을 씀
+// 여기서는 모드별 레이아웃 접근자와 부가 정보 / 스냅샷 복사 / 통계 갱신을 끼워 넣음
+#define RBC_TREE rbtree
+#define RBC_NODE node_t
+#define RBC_FN(name) name
+#define RBC_PARENT(x) rbtree_parent(x)
+#define RBC_SET_PARENT(x, p) set_parent((x), (p))
+#define RBC_COLOR(x) rbtree_color(x)
+#define RBC_SET_COLOR(x, c) set_color((x), (color_t)(c))
+#define RBC_AUGMENT(x) augment_update(x)
+#define RBC_AUGMENT_PATH(t, x) augment_path((t), (x))
+#define RBC_OWN(t, x) cow_own((t), (x))
+#define RBC_STAT(t, field) STAT_ADD(t, field, 1)
+#define RBC_SET_LINK(p, field, v) SET_LINK(p, field, v)
+#include "rbtree_core.h"
+
+// key를 가진 RED 노드 하나를 할당해 초기화 (아직 트리에 연결하지 않음). 실패 시 NULL
+static node_t *node_new(rbtree *t, const key_t key) {
+    node_t *z = node_alloc(t); // malloc 또는 노드 풀
+    if (z == NULL) {
+        return NULL;
+    }
+    z->key = key;
+    set_color(z, RBTREE_RED);
+    z->left = z->right = t->nil;
+    set_parent(z, t->nil);
+#ifdef RBTREE_ORDER_STAT
+    z->size = 1;
+#endif
+#ifdef RBTREE_INTERVAL
+    z->end = z->max_end = key; // 점 구간. rbtree_insert_interval은 받은 뒤 바꿈
+#endif
+#ifdef RBTREE_MULTISET
+    z->count = 1;
+#endif
+    return z;
+}
+
+/**
+ * finger 모드 : 마지막 삽입 위치 기억
+ * 기억한 세 노드(finger와 그 앞뒤)는 다른 노드를 넣거나 지워도 중위 순서에서 계속 이웃이므로,
+ * 회전이 트리 모양을 바꿔도 그 노드들 중 하나를 지우기 전까지는 그대로 쓸 수 있음
+ * 스냅샷(RBTREE_COW)이 있으면 쓰기마다 경로의 노드가 복사되어 기억한 포인터가 옛 노드를 가리킬 수 있으므로 잊음
+ */
+static inline void finger_set(rbtree *t, node_t *z, node_t *prev, node_t *next) {
+#ifdef RBTREE_FINGER
+#ifdef RBTREE_COW
+    if (t->snapshots > 0) {
+        z = NULL;
+    }
+#endif
+    t->finger = z;
+    t->finger_prev = prev;
+    t->finger_next = next;
+#else
+    (void)t, (void)z, (void)prev, (void)next;
+#endif
+}
+
+// z를 지우기 전에 호출. z가 기억한 노드 중 하나이면 잊음
+static inline void finger_drop(rbtree *t, const node_t *z) {
+#ifdef RBTREE_FINGER
+#ifdef RBTREE_COW
+    if (t->snapshots > 0) {
+        t->finger = NULL;
+    }
+#endif
+    if (z == t->finger || z == t->finger_prev || z == t->finger_next) {
+        t->finger = NULL;
+    }
+#else
+    (void)t, (void)z;
+#endif
+}
+
+// key가 기억한 위치에 들어가면 1을 반환하고 *prev, *next에 key가 들어갈 자리의 앞뒤 노드를 채움
+static inline int finger_fits(rbtree *t, const key_t key, node_t **prev, node_t **next) {
+#ifdef RBTREE_FINGER
+    node_t *f = t->finger;
+#ifdef RBTREE_COW
+    if (t->snapshots > 0) {
+        f = t->finger = NULL;
+    }
+#endif
+    if (f == NULL) {
+        return 0;
+    }
+    if (key < f->key) { // finger 앞 : finger_prev->key <= key < finger->key
+        if (t->finger_prev != NULL && key < t->finger_prev->key) {
+            return 0;
+        }
+        *prev = t->finger_prev;
+        *next = f;
+    } else { // finger 뒤 : finger->key <= key < finger_next->key (같으면 같은 키들의 맨 뒤가 아니므로 내려감)
+        if (t->finger_next != NULL && !(key < t->finger_next->key)) {
+            return 0;
+        }
+        *prev = f;
+        *next = t->finger_next;
+    }
+    return 1;
+#else
+    (void)t, (void)key, (void)prev, (void)next;
+    return 0;
+#endif
+}
+
+// 중위 순서로 바로 이웃한 prev와 next 사이에 z를 붙이고 균형을 복구 (NULL은 z가 처음/끝이라는 뜻)
+static void insert_between(rbtree *t, node_t *z, node_t *prev, node_t *next) {
+    write_begin(t);
+    node_t *y = link_between(t, z, prev, next);
+    augment_add(t, y, z); // 내려오며 늘리지 않았으므로 올라가며 늘림
+    insert_fixup(t, z);
+    write_end(t);
+}
+
+#ifdef RBTREE_MULTISET
+/**
+ * 멀티셋 모드 : 이미 있는 노드 z의 count를 delta(+1 또는 -1)만큼 바꿈. 트리 모양은 바뀌지 않음
+ * RBTREE_ORDER_STAT이면 z부터 루트까지의 size도 같이 바꿈 (size는 count의 합)
+ * 스냅샷이 있으면 스냅샷이 보는 count / size를 바꾸지 않도록 루트에서 z까지를 먼저 복사하므로 z가 바뀔 수 있음
+ * 이 트리 전용이 된 z를 반환. 할당 실패 시 NULL (트리는 그대로)
+ */
+static node_t *count_add(rbtree *t, node_t *z, const int delta) {
+#ifdef RBTREE_COW
+    if (t->snapshots > 0 && (z = cow_own_path(t, z)) == NULL) {
+        return NULL;
+    }
+#endif
+    write_begin(t);
+    z->count += delta;
+#ifdef RBTREE_ORDER_STAT
+    for (node_t *p = z; p != t->nil; p = rbtree_parent(p)) {
+        p->size += delta;
+    }
+#endif
+    write_end(t);
+    return z;
+}
+#endif
+
+#ifndef RBTREE_MULTISET // 멀티셋 모드의 rbtree_insert는 rbtree_insert_unique로 넣으므로 쓰지 않음
+// 새 노드 z를 루트부터 내려가 찾은 자리(같은 키면 그 뒤)에 넣음. 스냅샷 복사에 실패하면 z를 반납하고 NULL
+static node_t *insert_node(rbtree *t, node_t *z) {
+    const key_t key = z->key;
+#ifdef RBTREE_COW
+    node_t *leaf;
+    if (t->snapshots > 0 && cow_prepare_insert(t, key, &leaf) != 0) { // 스냅샷과 공유 중인 경로를 먼저 복사
+        node_free(t, z);
+        return NULL;
+    }
+#endif
+    node_t *prev = NULL, *next = NULL; // z의 중위 순서 앞/뒤 노드 (finger 모드에서 기억)
+    if (finger_fits(t, key, &prev, &next)) {
+        STAT_ADD(t, inserts, 1);
+        STAT_ADD(t, insert_compares, 2);
+        insert_between(t, z, prev, next);
+        finger_set(t, z, prev, next);
+        return z;
+    }
+
+    write_begin(t);      // 동시 읽기 모드 : 여기서부터 fixup의 회전까지 읽기 스레드는 재시도
+    node_t *x = t->root; // x가 루트부터 내려갈 노드
+    node_t *y = t->nil;  // z의 부모 후보
+    size_t compares = 0; // 통계용 비교 횟수 (RBTREE_STATS가 아니면 사라짐)
+    // z의 올바른 삽입 위치 찾기
+    while (x != t->nil) {
+        y = x;
+        compares++;
+#ifdef RBTREE_ORDER_STAT
+        x->size++; // z는 지나가는 모든 노드의 서브트리에 들어가므로 내려가면서 바로 1씩 늘림
+#endif
+#ifdef RBTREE_INTERVAL
+        x->max_end = z->end > x->max_end ? z->end : x->max_end; // max_end도 같은 이유로 내려가면서 갱신
+#endif
+        if (key < x->key) {
+            next = x; // 왼쪽으로 내려간 마지막 노드가 z의 바로 뒤
+            x = x->left;
+        } else {
+            prev = x; // 오른쪽으로 내려간 마지막 노드가 z의 바로 앞
+            x = x->right;
+        }
+    }
+
+    // z와 부모 자식 연결
+    set_parent(z, y);
+    if (y == t->nil) {
+        SET_LINK(t, root, z);
+    } else if (key < y->key) {
+        SET_LINK(y, left, z);
+    } else {
+        SET_LINK(y, right, z);
+    }
+
+    STAT_ADD(t, inserts, 1);
+    STAT_ADD(t, insert_compares, compares);
+
+    // rb트리의 조건을 모두 만족하도록 복구
+    insert_fixup(t, z);
+    write_end(t);
+    finger_set(t, z, prev, next);
+
+    return z; // 삽입된 노드의 포인터 반환
+}
+#endif
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+#ifdef RBTREE_MULTISET
+    // 같은 키를 찾으며 내려가는 rbtree_insert_unique를 그대로 쓰고, 있던 키면 새 노드 대신 그 노드의 count를 늘림
+    int existed;
+    node_t *found = rbtree_insert_unique(t, key, &existed);
+    return found != NULL && existed ? count_add(t, found, 1) : found;
+#else
+    node_t *z = node_new(t, key); // key를 넣을 새 노드 z 할당
+    if (z == NULL) {              // z 메모리 할당 실패
+        return NULL;
+    }
+    return insert_node(t, z);
+#endif
+}
+
+#ifdef RBTREE_INTERVAL
+node_t *rbtree_insert_interval(rbtree *t, const key_t start, const key_t end) {
+    if (end < start) {
+        return NULL;
+    }
+    node_t *z = node_new(t, start);
+    if (z == NULL) {
+        return NULL;
+    }
+    z->end = z->max_end = end;
+    return insert_node(t, z);
+}
+#endif
+
+node_t *rbtree_insert_unique(rbtree *t, const key_t key, int *existed) {
+    node_t *prev = NULL, *next = NULL; // 새 노드의 중위 순서 앞/뒤 노드
+    node_t *found = NULL;              // 이미 있는 같은 키의 노드
+    size_t compares = 0;
+    node_t *y = t->nil; // 새 노드의 부모 후보
+    const int near = finger_fits(t, key, &prev, &next);
+    if (near) {
+        // prev->key <= key < next->key 이므로 같은 키가 있다면 prev
+        compares = 2;
+        if (prev != NULL && prev->key == key) {
+            found = prev;
+        }
+    } else {
+        // 한 번만 내려가면서 같은 키를 만나면 바로 그 노드를 반환 (find + insert 두 번의 탐색을 하나로)
+        node_t *x = t->root;
+        while (x != t->nil) {
+            compares++;
+            if (x->key == key) {
+                found = x;
+                break;
+            }
+            y = x;
+            if (key < x->key) {
+                next = x;
+                x = x->left;
+            } else {
+                prev = x;
+                x = x->right;
+            }
+        }
+    }
+    STAT_ADD(t, inserts, 1);
+    STAT_ADD(t, insert_compares, compares);
+    if (existed != NULL) {
+        *existed = found != NULL;
+    }
+    if (found != NULL) {
+        return found; // 이미 있는 키 -> 할당하지 않음
+    }
+
+    if (near) {
+        node_t *z = node_new(t, key);
+        if (z == NULL) {
+            return NULL;
+        }
+        insert_between(t, z, prev, next);
+        finger_set(t, z, prev, next);
+        return z;
+    }
+
+    // 없는 키 : 탐색이 멈춘 y 아래에 새 노드를 붙임
+#ifdef RBTREE_COW
+    if (t->snapshots > 0 && cow_prepare_insert(t, key, &y) != 0) { // y가 복사되었을 수 있으므로 다시 받음
+        return NULL;
+    }
+#endif
+    node_t *z = node_new(t, key);
+    if (z == NULL) {
+        return NULL;
+    }
+    set_parent(z, y);
+    write_begin(t); // 탐색은 쓰기 스레드 자신만 하므로, 트리를 바꾸기 시작하는 여기부터 쓰기 구간
+    // 내려가는 동안에는 키가 있을지 몰라 size를 건드리지 않았으므로 방금 지나온 경로를 거슬러 올라가며 늘림
+    augment_add(t, y, z);
+    if (y == t->nil) {
+        SET_LINK(t, root, z);
+    } else if (key < y->key) {
+        SET_LINK(y, left, z);
+    } else {
+        SET_LINK(y, right, z);
+    }
+    insert_fixup(t, z);
+    write_end(t);
+    finger_set(t, z, prev, next);
+    return z;
+}
+
+node_t *rbtree_find(const rbtree *t, const key_t key) {
+#ifdef RBTREE_CONCURRENT
+    return read_walk(t, key, 0);
+#else
+    node_t *x = t->root;
+    size_t compares = 0;
+
+    while (x != t->nil) {
+        compares++;
+        if (x->key == key) {
+            STAT_ADD(t, finds, 1);
+            STAT_ADD(t, find_compares, compares);
+            return x;
+        }
+        if (key < x->key) {
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+
+    STAT_ADD(t, finds, 1);
+    STAT_ADD(t, find_compares, compares);
+    return NULL;
+#endif
+}
+
+// 트리에서의 최솟값 반환
+node_t *rbtree_min(const rbtree *t) {
+#ifdef RBTREE_CONCURRENT
+    return read_walk(t, 0, -1);
+#else
+    node_t *x = t->root;
+    if (x == NULL || x == t->nil) { // 빈 트리라면 NULL
+        return NULL;
+    }
+    while (x->left != t->nil) {
+        x = x->left;
+    }
+    return x;
+#endif
+}
+
+// 트리의 최댓값 반환
+node_t *rbtree_max(const rbtree *t) {
+#ifdef RBTREE_CONCURRENT
+    return read_walk(t, 0, 1);
+#else
+    node_t *x = t->root;
+    if (x == NULL || x == t->nil) { // 빈 트리라면 NULL
+        return NULL;
+    }
+    while (x->right != t->nil) {
+        x = x->right;
+    }
+    return x;
+#endif
+}
+
+// cond ? a : b를 분기 없이. 한 루프에 삼항 연산자가 둘이면 gcc가 둘 다 분기로 만들어 버려서 따로 둠
+static inline node_t *pick_node(const int cond, node_t *a, node_t *b) {
+    return (node_t *)((uintptr_t)b ^ (((uintptr_t)a ^ (uintptr_t)b) & -(uintptr_t)cond));
+}
+
+/**
+ * 경계 탐색 (lower_bound / upper_bound / floor / ceiling)
+ * 조건을 만족하는 노드를 만나면 후보로 기억하고 더 가까운 후보를 찾아 안쪽으로, 아니면 바깥쪽으로 내려감
+ * 조건을 만족하는 노드는 중위 순서로 한쪽에 몰려 있으므로 마지막 후보가 그 경계의 노드 -> 한 번 내려가는 O(log n)
+ * 같은 키를 만나도 멈추지 않으므로 중복 키가 있으면 lower_bound / upper_bound는 그중 처음, floor는 마지막 노드
+ * 분기 없이 내려감 : 다음 노드는 rbtree_find처럼 삼항 연산자(cmov), 후보 갱신은 pick_node의 비트 마스크
+ * (if로 쓰면 무작위 키에서 단계마다 예측이 반쯤 빗나가 1M 키에서 find의 네 배 가까이 느려짐)
+ */
+node_t *rbtree_lower_bound(const rbtree *t, const key_t key) {
+    if (t == NULL) {
+        return NULL;
+    }
+    node_t *found = NULL;
+    for (node_t *x = t->root; x != t->nil;) {
+        const int hit = x->key >= key;
+        found = pick_node(hit, x, found);
+        x = hit ? x->left : x->right;
+    }
+    return found;
+}
+
+node_t *rbtree_upper_bound(const rbtree *t, const key_t key) {
+    if (t == NULL) {
+        return NULL;
+    }
+    node_t *found = NULL;
+    for (node_t *x = t->root; x != t->nil;) {
+        const int hit = x->key > key;
+        found = pick_node(hit, x, found);
+        x = hit ? x->left : x->right;
+    }
+    return found;
+}
+
+node_t *rbtree_floor(const rbtree *t, const key_t key) {
+    if (t == NULL) {
+        return NULL;
+    }
+    node_t *found = NULL;
+    for (node_t *x = t->root; x != t->nil;) {
+        const int hit = x->key <= key;
+        found = pick_node(hit, x, found);
+        x = hit ? x->right : x->left;
+    }
+    return found;
+}
+
+node_t *rbtree_ceiling(const rbtree *t, const key_t key) {
+    return rbtree_lower_bound(t, key); // key 이상인 가장 작은 키 = lower_bound
+}
+
+node_t *rbtree_next(const rbtree *t, const node_t *x) {
+    if (t == NULL || x == NULL || x == t->nil) {
+        return NULL;
+    }
+    return successor(t, x);
+}
+
+node_t *rbtree_prev(const rbtree *t, const node_t *x) {
+    if (t == NULL || x == NULL || x == t->nil) {
+        return NULL;
+    }
+    return predecessor(t, x);
+}
+
+node_t *rbtree_insert_hint(rbtree *t, node_t *hint, const key_t key) {
+    if (t == NULL) {
+        return NULL;
+    }
+#ifdef RBTREE_COW
+    if (t->snapshots > 0) { // 루트부터 경로를 복사해야 하므로 힌트를 쓰지 않음
+        hint = NULL;
+    }
+#endif
+#ifdef RBTREE_FINGER
+    if (hint == t->finger) { // 앞뒤 노드를 기억하고 있으므로 rbtree_insert가 부모를 따라 올라가지 않고 확인
+        return rbtree_insert(t, key);
+    }
+#endif
+    if (hint == NULL || hint == t->nil) {
+        return rbtree_insert(t, key);
+    }
+    // hint의 어느 쪽에 들어가는지 본 뒤 그쪽 이웃과 비교. 이웃 사이를 벗어나면 루트부터 내려감
+    node_t *prev, *next;
+    if (key < hint->key) {
+        prev = rbtree_prev(t, hint);
+        next = hint;
+        if (prev != NULL && key < prev->key) {
+            return rbtree_insert(t, key);
+        }
+    } else {
+        prev = hint;
+        next = rbtree_next(t, hint);
+        if (next != NULL && !(key < next->key)) { // 같은 키는 rbtree_insert처럼 기존 키들의 맨 뒤에 넣어야 함
+            return rbtree_insert(t, key);
+        }
+    }
+    STAT_ADD(t, inserts, 1);
+    STAT_ADD(t, insert_compares, 2);
+#ifdef RBTREE_MULTISET
+    // prev->key <= key < next->key 이고 키마다 노드가 하나뿐이므로 같은 키가 있다면 prev
+    if (prev != NULL && prev->key == key) {
+        return count_add(t, prev, 1);
+    }
+#endif
+    node_t *z = node_new(t, key);
+    if (z == NULL) {
+        return NULL;
+    }
+    insert_between(t, z, prev, next);
+    finger_set(t, z, prev, next);
+    return z;
+}
+
+int rbtree_range(const rbtree *t, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx) {
+    if (t == NULL || visit == NULL) {
+        return -1;
+    }
+    // 1. 루트에서 한 번 내려가며 key >= lo 인 첫 노드를 찾음 - O(log n)
+    // 조건을 만족하면 후보로 스택에 쌓고 더 작은 후보를 찾아 왼쪽으로, 아니면 오른쪽으로
+    // -> 중복 키가 있어도 가장 왼쪽(처음) 노드에서 시작하고, 스택 맨 위가 첫 노드
+    // 스택에는 아직 방문하지 않은 조상만 남으므로 rbtree_to_array의 중위 순회 스택과 같은 상태가 됨
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    size_t top = 0;
+    node_t *x = t->root;
+    while (x != t->nil) {
+        if (x->key >= lo) {
+            stack[top++] = x;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    // 2. hi를 넘을 때까지 중위 순회를 이어가며 방문 - O(k), 추가 할당 없음
+    // 부모 포인터를 따라가지 않으므로 스냅샷(RBTREE_COW)에서도 동작
+    while (top > 0) {
+        x = stack[--top];
+        if (x->key > hi || visit(x, ctx) != 0) { // 콜백이 0이 아닌 값을 돌려주면 순회 중단
+            break;
+        }
+        for (x = x->right; x != t->nil; x = x->left) {
+            stack[top++] = x;
+        }
+    }
+    return 0;
+}
+
+#ifdef RBTREE_INTERVAL
+int rbtree_overlap(const rbtree *t, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx) {
+    if (t == NULL || visit == NULL) {
+        return -1;
+    }
+    // rbtree_range와 같은 스택 중위 순회. 왼쪽으로 내려가며 쌓을 때 max_end < lo인 서브트리는 쌓지 않음
+    // -> 그 안의 구간은 모두 lo 전에 끝나므로 겹치는 것이 없음
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    size_t top = 0;
+    node_t *x = t->root;
+    for (;;) {
+        for (; x != t->nil && x->max_end >= lo; x = x->left) {
+            stack[top++] = x;
+        }
+        if (top == 0) {
+            break;
+        }
+        x = stack[--top];
+        if (x->key > hi) { // 중위 순서로 뒤의 노드는 모두 hi 뒤에서 시작
+            break;
+        }
+        if (x->end >= lo && visit(x, ctx) != 0) { // 콜백이 0이 아닌 값을 돌려주면 순회 중단
+            break;
+        }
+        x = x->right;
+    }
+    return 0;
+}
+#endif
+
+#ifdef RBTREE_ORDER_STAT
+node_t *rbtree_select(const rbtree *t, size_t k) {
+    if (t == NULL) {
+        return NULL;
+    }
+    // 왼쪽 서브트리 크기와 k를 비교하며 한 번만 내려감 - O(log n)
+    // 멀티셋 모드에서는 x가 k번째부터 count개의 자리를 차지함
+    node_t *x = t->root;
+    while (x != t->nil) {
+        size_t left_size = x->left->size;
+        if (k < left_size) { // k번째가 왼쪽 서브트리 안에 있음
+            x = x->left;
+        } else if (k < left_size + rbtree_key_count(x)) { // 왼쪽에 k개 이하, x까지 세면 k개 초과 -> x가 k번째
+            return x;
+        } else { // 왼쪽 서브트리와 x를 건너뛰고 오른쪽에서 나머지 순번을 찾음
+            k -= left_size + rbtree_key_count(x);
+            x = x->right;
+        }
+    }
+    return NULL; // k >= 노드 수
+}
+
+size_t rbtree_rank(const rbtree *t, const key_t key) {
+    if (t == NULL) {
+        return 0;
+    }
+    // x->key < key 이면 x와 x의 왼쪽 서브트리 전체가 key보다 작으므로 한꺼번에 더하고 오른쪽으로 - O(log n)
+    size_t rank = 0;
+    node_t *x = t->root;
+    while (x != t->nil) {
+        if (x->key < key) {
+            rank += x->left->size + rbtree_key_count(x);
+            x = x->right;
+        } else {
+            x = x->left;
+        }
+    }
+    return rank;
+}
+#endif
+
+// z를 지우고 노드를 반납. next가 NULL이 아니면 지운 노드의 successor를 *next에 기록 (없으면 NULL)
+static int erase_at(rbtree *t, node_t *z, node_t **next) {
+    finger_drop(t, z);
+#ifdef RBTREE_COW
+    if (t->snapshots > 0 && (z = cow_prepare_erase(t, z)) == NULL) {
+        return -1;
+    }
+#endif
+    if (next != NULL) {
+        // 지우는 동안 다른 노드의 주소는 바뀌지 않으므로 (두 자식이면 z 자리로 옮겨 갈 뿐) 미리 구해둠 - 분할 상환 O(1)
+        *next = rbtree_next(t, z);
+#ifdef RBTREE_COW
+        // 오른쪽 자식 하나뿐이면 successor는 z를 대신할 그 자식. delete_fixup이 복사할 수 있어 먼저 이 트리 전용으로
+        // (다른 경우의 successor는 cow_prepare_erase가 복사한 경로 위에 있음. 예비 노드도 이 몫까지 잡혀 있음)
+        if (*next == z->right) {
+            *next = cow_own(t, z->right);
+        }
+#endif
+    }
+    STAT_ADD(t, erases, 1);
+    write_begin(t);
+    erase_node(t, z);
+#ifdef RBTREE_CONCURRENT
+    node_retire(t, z); // 읽기 스레드가 아직 z를 지나는 중일 수 있으므로 바로 해제하지 않음
+#else
+    node_free(t, z);
+#endif
+    write_end(t);
+#ifdef RBTREE_CONCURRENT
+    if (t->sync->n_retired >= RBTREE_RECLAIM_BATCH) { // 쓰기 구간 밖에서 기다려야 읽기 스레드가 끝날 수 있음
+        rbtree_synchronize(t);
+    }
+#endif
+
+    return 0;
+}
+
+// 키 하나를 지움. 멀티셋 모드에서 같은 키가 더 남아 있으면 노드는 두고 count만 줄임 (next는 erase_at과 같음)
+static int erase_one(rbtree *t, node_t *z, node_t **next) {
+#ifdef RBTREE_MULTISET
+    if (z->count > 1) {
+        if ((z = count_add(t, z, -1)) == NULL) {
+            return -1;
+        }
+        STAT_ADD(t, erases, 1);
+        if (next != NULL) {
+            *next = rbtree_next(t, z);
+        }
+        return 0;
+    }
+#endif
+    return erase_at(t, z, next);
+}
+
+int rbtree_erase(rbtree *t, node_t *z) {
+    if (t == NULL || z == NULL || z == t->nil) {
+        return -1;
+    }
+    return erase_one(t, z, NULL);
+}
+
+int rbtree_erase_key(rbtree *t, const key_t key) {
+    if (t == NULL) {
+        return -1;
+    }
+    // rbtree_find와 같은 탐색으로 찾은 노드를 그대로 지움 (쓰기 스레드이므로 RBTREE_CONCURRENT의 읽기 프로토콜은 안 씀)
+    // 삼항 연산자로 쓰면 조건부 이동이 되어 다음 노드를 미리 읽지 못하므로 rbtree_find처럼 분기로 씀
+    node_t *z = t->root;
+    while (z != t->nil && z->key != key) {
+        if (key < z->key) {
+            z = z->left;
+        } else {
+            z = z->right;
+        }
+    }
+    return z == t->nil ? -1 : erase_one(t, z, NULL);
+}
+
+node_t *rbtree_erase_next(rbtree *t, node_t *z) {
+    node_t *next;
+    if (t == NULL || z == NULL || z == t->nil || erase_one(t, z, &next) != 0) {
+        return NULL;
+    }
+    return next;
+}
+
+/**
+ * join / split : 검정 높이(black height)를 이용한 트리 합치기와 나누기
+ * 검정 높이 h는 서브트리 루트에서 nil까지 지나는 검정 노드 수 (루트 포함, nil 제외. 빈 트리는 0)
+ * 같은 트리(같은 t->nil) 안의 서브트리 루트를 주고받고, 돌려주는 서브트리의 루트는 항상 BLACK이고 부모는 nil
+ * 회전과 fixup은 부모가 nil인 노드를 t->root로 여기므로, 작업하는 동안 t->root는 지금 다루는 서브트리의 루트로 씀
+ */
+
+// x부터 왼쪽으로만 내려가며 검정 노드를 셈 - O(log n)
+static size_t black_height(const rbtree *t, const node_t *x) {
+    size_t h = 0;
+    for (; x != t->nil; x = x->left) {
+        h += rbtree_color(x) == RBTREE_BLACK;
+    }
+    return h;
+}
+
+// 서브트리 x를 독립된 트리로 떼어냄. 부모를 nil로 끊고, RED 루트는 BLACK으로 바꿔 검정 높이 *h를 1 늘림
+static node_t *detach_root(rbtree *t, node_t *x, size_t *h) {
+    if (x != t->nil) {
+        set_parent(x, t->nil);
+        if (rbtree_color(x) == RBTREE_RED) {
+            set_color(x, RBTREE_BLACK);
+            (*h)++;
+        }
+    }
+    return x;
+}
+
+/**
+ * l의 모든 키 <= k->key <= r의 모든 키일 때 l, k, r을 RB 트리 하나로 합치고 루트를 반환 (*h에 검정 높이)
+ * 1. 검정 높이가 같으면 k를 BLACK 루트로 삼고 l, r을 양쪽 자식으로
+ * 2. l이 더 높으면 l의 오른쪽 가장자리를 따라 내려가 검정 높이가 hr인 첫 BLACK 노드 c를 찾고,
+ *    c 자리에 RED인 k를 놓아 c와 r을 k의 자식으로 -> 검정 높이는 맞고 RED-RED만 생길 수 있으므로 삽입 fixup으로 복구
+ * 3. r이 더 높으면 대칭 (r의 왼쪽 가장자리)
+ * 검정 높이가 한 층 줄 때마다 많아야 두 칸 내려가므로 O(|hl - hr| + 1)
+ */
+static node_t *join_nodes(rbtree *t, node_t *l, size_t hl, node_t *k, node_t *r, size_t hr, size_t *h) {
+    l = detach_root(t, l, &hl);
+    r = detach_root(t, r, &hr);
+    if (hl == hr) {
+        SET_LINK(k, left, l);
+        SET_LINK(k, right, r);
+        set_parent(k, t->nil);
+        set_color(k, RBTREE_BLACK);
+        *h = hl + 1;
+    } else {
+        const int left_taller = hl > hr;
+        const size_t target = left_taller ? hr : hl;
+        node_t *c = left_taller ? l : r, *p = t->nil;
+        size_t hc = left_taller ? hl : hr; // c의 검정 높이
+        while (rbtree_color(c) == RBTREE_RED || hc > target) {
+            hc -= rbtree_color(c) == RBTREE_BLACK;
+            p = c;
+            c = left_taller ? c->right : c->left;
+        }
+        if (left_taller) {
+            SET_LINK(k, left, c);
+            SET_LINK(k, right, r);
+            SET_LINK(p, right, k);
+        } else {
+            SET_LINK(k, left, l);
+            SET_LINK(k, right, c);
+            SET_LINK(p, left, k);
+        }
+        set_parent(k, p);
+        set_color(k, RBTREE_RED);
+        SET_LINK(t, root, left_taller ? l : r);
+        *h = left_taller ? hl : hr;
+    }
+    if (k->left != t->nil) {
+        set_parent(k->left, k);
+    }
+    if (k->right != t->nil) {
+        set_parent(k->right, k);
+    }
+    augment_path(t, k); // k와, 2/3이면 k 위의 가장자리 노드들 (hl == hr이면 k 하나)
+    if (rbtree_parent(k) == t->nil) {
+        return k;
+    }
+    *h += insert_fixup(t, k);
+    return t->root;
+}
+
+/**
+ * root(검정 높이 h)를 key 기준으로 둘로 나눠 *lt, *ge에 루트, *hlt, *hge에 검정 높이를 채움
+ * le가 0이면 key 미만 / key 이상, 1이면 key 이하 / key 초과로 나눔
+ * key를 찾아 내려간 경로의 노드를 아래에서부터 꺼내며, 그 노드와 경로 밖 서브트리를 같은 쪽 결과에 join
+ * 한쪽 결과에 붙는 서브트리는 점점 높아지므로 join 비용이 이어서 상쇄되어 전체 O(log n)
+ */
+static void split_nodes(rbtree *t, node_t *root, size_t h, const key_t key, const int le, node_t **lt, size_t *hlt,
+                        node_t **ge, size_t *hge) {
+    node_t *path[RBTREE_MAX_HEIGHT];
+    size_t heights[RBTREE_MAX_HEIGHT]; // path[i]의 검정 높이
+    size_t top = 0;
+    for (node_t *x = root; x != t->nil;) {
+        path[top] = x;
+        heights[top++] = h;
+        h -= rbtree_color(x) == RBTREE_BLACK;
+        x = (le ? key < x->key : key <= x->key) ? x->left : x->right;
+    }
+    node_t *l = t->nil, *r = t->nil;
+    size_t hl = 0, hr = 0;
+    while (top > 0) {
+        node_t *x = path[--top];
+        const size_t hc = heights[top] - (rbtree_color(x) == RBTREE_BLACK); // x 자식들의 검정 높이
+        if (le ? key < x->key : key <= x->key) {                            // x와 오른쪽 서브트리는 ge 쪽
+            r = join_nodes(t, r, hr, x, x->right, hc, &hr);
+        } else { // x와 왼쪽 서브트리는 lt 쪽
+            l = join_nodes(t, x->left, hc, x, l, hl, &hl);
+        }
+    }
+    *lt = l;
+    *hlt = hl;
+    *ge = r;
+    *hge = hr;
+}
+
+// l의 모든 키 <= r의 모든 키일 때 둘을 하나로 이음 (피벗이 없으므로 l의 최댓값을 떼어 피벗으로 씀)
+static node_t *concat_nodes(rbtree *t, node_t *l, size_t hl, node_t *r, size_t hr, size_t *h) {
+    if (r == t->nil || l == t->nil) {
+        *h = r == t->nil ? hl : hr;
+        return r == t->nil ? l : r;
+    }
+    SET_LINK(t, root, l);
+    node_t *pivot = subtree_max(t, l);
+    erase_node(t, pivot);
+    return join_nodes(t, t->root, black_height(t, t->root), pivot, r, hr, h);
+}
+
+#ifdef RBTREE_MULTISET
+// 멀티셋 모드의 rbtree_join : pivot과 같은 키가 t1의 최댓값(lmax)이나 t2의 최솟값(rmin)으로 이미 있을 때
+// 양쪽에 모두 있으면 rmin을 t2에서 떼어 lmax의 count에 더하고, 남은 노드의 count를 pivot 몫으로 1 늘린 뒤 둘을 이음
+static node_t *join_same_key(rbtree *t1, rbtree *t2, node_t *lmax, node_t *rmin, const key_t pivot) {
+    node_t *same = lmax != NULL && lmax->key == pivot ? lmax : rmin;
+    if (same == lmax && rmin != NULL && rmin->key == pivot) {
+        erase_node(t2, rmin);
+        lmax->count += rmin->count;
+        node_free(t1, rmin); // t2의 풀은 이미 t1으로 넘어옴
+    }
+    same->count++;
+    augment_path(t1, same);
+    size_t h;
+    return concat_nodes(t1, t1->root, black_height(t1, t1->root), t2->root, black_height(t2, t2->root), &h);
+}
+#endif
+
+// 지울 노드가 이보다 많으면 하나씩 지우지 않고 split / join으로 구간을 통째로 떼어냄
+#define RBTREE_ERASE_RANGE_SMALL 32
+
+size_t rbtree_erase_range(rbtree *t, const key_t lo, const key_t hi) {
+    if (t == NULL || lo > hi) {
+        return 0;
+    }
+    size_t count = 0;
+#ifdef RBTREE_COW
+    // 스냅샷이 있으면 바뀌는 경로를 복사해야 하므로 하나씩 지움 (지울 때마다 노드가 복사될 수 있어 매번 다시 찾음)
+    if (t->snapshots > 0) {
+        for (node_t *p; (p = rbtree_lower_bound(t, lo)) != NULL && p->key <= hi;) {
+            const size_t keys = rbtree_key_count(p); // 노드를 통째로 지우므로 멀티셋 모드면 count를 모두 셈
+            if (erase_at(t, p, NULL) != 0) {
+                break;
+            }
+            count += keys;
+        }
+        return count;
+    }
+#endif
+    // 구간이 작으면 하나씩 지우는 편이 나누고 합치는 것보다 쌈. 지워도 다른 노드의 주소는 바뀌지 않음
+    node_t *small[RBTREE_ERASE_RANGE_SMALL];
+    node_t *p = rbtree_lower_bound(t, lo);
+    while (p != NULL && p->key <= hi && count < RBTREE_ERASE_RANGE_SMALL) {
+        small[count++] = p;
+        p = rbtree_next(t, p);
+    }
+    if (p == NULL || p->key > hi) {
+        const size_t n = count;
+        count = 0;
+        for (size_t i = 0; i < n; i++) {
+            count += rbtree_key_count(small[i]);
+            erase_at(t, small[i], NULL);
+        }
+        return count;
+    }
+
+    // 1. lo 미만 / lo 이상으로 나누고, 뒤쪽을 다시 hi 이하 / hi 초과로 나눔 - O(log n)
+    // 2. 가운데 트리는 균형을 맞출 필요가 없으므로 fixup 없이 노드만 반납 - O(k)
+    // 3. 남은 두 트리를 앞쪽의 최댓값을 피벗으로 join - O(log n)
+    write_begin(t);
+#ifdef RBTREE_FINGER
+    t->finger = NULL; // 기억한 노드가 지워졌을 수 있음
+#endif
+    node_t *l, *m, *r, *rest;
+    size_t h, hl, hm, hr, hrest;
+    split_nodes(t, t->root, black_height(t, t->root), lo, 0, &l, &hl, &rest, &hrest);
+    split_nodes(t, rest, hrest, hi, 1, &m, &hm, &r, &hr);
+#ifdef RBTREE_CONCURRENT
+    count = free_subtree(t, m, node_retire); // 읽기 스레드가 아직 지나는 중일 수 있음
+#else
+    count = free_subtree(t, m, node_free);
+#endif
+    SET_LINK(t, root, concat_nodes(t, l, hl, r, hr, &h));
+    write_end(t);
+    STAT_ADD(t, erases, count);
+#ifdef RBTREE_CONCURRENT
+    if (t->sync->n_retired >= RBTREE_RECLAIM_BATCH) {
+        rbtree_synchronize(t);
+    }
+#endif
+    return count;
+}
+
+/**
+ * rbtree_join / rbtree_split : 트리 사이에서 서브트리를 통째로 옮김
+ * 센티넬을 모든 트리가 함께 쓰므로 노드를 복사하거나 다시 삽입하지 않고 join_nodes / split_nodes를 그대로 씀
+ * 풀 모드에서는 옮겨 간 노드가 든 slab을 두 트리가 참조 수로 나눠 가짐 (slab은 두 배씩 커지므로 O(log n)개)
+ */
+
+// 스냅샷과 노드를 공유하는 트리, 스냅샷 자신은 노드를 옮길 수 없음
+static int movable(const rbtree *t) {
+#ifdef RBTREE_COW
+    return t->snapshots == 0 && t->origin == NULL;
+#else
+    (void)t;
+    return 1;
+#endif
+}
+
+int rbtree_join(rbtree *t1, const key_t pivot, rbtree *t2) {
+    // 노드마다 malloc한 트리와 slab 트리는 노드를 해제하는 방법이 달라 섞을 수 없음
+    if (t1 == NULL || t2 == NULL || t1 == t2 || !movable(t1) || !movable(t2) ||
+        (t1->pool == NULL) != (t2->pool == NULL)) {
+        return -1;
+    }
+    node_t *lmax = t1->root != t1->nil ? subtree_max(t1, t1->root) : NULL;
+    node_t *rmin = t2->root != t2->nil ? subtree_min(t2, t2->root) : NULL;
+    if ((lmax != NULL && lmax->key > pivot) || (rmin != NULL && rmin->key < pivot)) {
+        return -1;
+    }
+#ifdef RBTREE_CONCURRENT
+    rbtree_synchronize(t2); // 해제를 기다리던 노드를 t2의 풀에 먼저 반납해야 t1로 함께 넘어감
+#endif
+    node_t *k = NULL; // pivot을 담을 새 노드
+#ifdef RBTREE_MULTISET
+    // 키마다 노드가 하나뿐이어야 하므로 pivot과 같은 키가 이미 있으면 새 노드를 만들지 않음
+    const int counted = (lmax != NULL && lmax->key == pivot) || (rmin != NULL && rmin->key == pivot);
+#else
+    const int counted = 0;
+#endif
+    if (!counted && (k = node_alloc(t1)) == NULL) {
+        return -1;
+    }
+    // 실패할 수 있는 일을 모두 끝낸 뒤에 트리를 바꿈
+    if (t1->pool != NULL) {
+        if (pool_adopt(t1->pool, t2->pool) != 0) {
+            if (k != NULL) {
+                node_free(t1, k);
+            }
+            return -1;
+        }
+        t2->pool = NULL;
+    }
+    STAT_ADD(t1, inserts, 1);
+    write_begin(t1);
+#ifdef RBTREE_FINGER
+    t1->finger = NULL;
+#endif
+#ifdef RBTREE_MULTISET
+    if (counted) {
+        SET_LINK(t1, root, join_same_key(t1, t2, lmax, rmin, pivot));
+    }
+#endif
+    if (k != NULL) {
+        k->key = pivot;
+#ifdef RBTREE_INTERVAL
+        k->end = pivot; // pivot은 점 구간. max_end는 join_nodes가 자식과 함께 계산
+#endif
+#ifdef RBTREE_MULTISET
+        k->count = 1;
+#endif
+        size_t h;
+        SET_LINK(t1, root,
+                 join_nodes(t1, t1->root, black_height(t1, t1->root), k, t2->root, black_height(t2, t2->root), &h));
+    }
+    write_end(t1);
+    t2->root = t2->nil; // 노드는 모두 t1으로 넘어갔으므로 구조체만 해제
+    delete_rbtree(t2);
+    return 0;
+}
+
+int rbtree_split(rbtree *t, const key_t key, rbtree **lt, rbtree **ge) {
+    if (t == NULL || lt == NULL || ge == NULL || !movable(t)) {
+        return -1;
+    }
+    rbtree *u = new_rbtree();
+    if (u == NULL) {
+        return -1;
+    }
+    if (t->pool != NULL && (u->pool = pool_share(t->pool)) == NULL) {
+        delete_rbtree(u);
+        return -1;
+    }
+    write_begin(t);
+#ifdef RBTREE_FINGER
+    t->finger = NULL;
+#endif
+    node_t *l, *r;
+    size_t hl, hr;
+    split_nodes(t, t->root, black_height(t, t->root), key, 0, &l, &hl, &r, &hr);
+    SET_LINK(t, root, l);
+    SET_LINK(u, root, r);
+    write_end(t);
+#ifdef RBTREE_CONCURRENT
+    // 나누기 전에 시작한 읽기가 u로 간 노드를 지나는 중일 수 있음 -> u에서 지워 해제하기 전에 끝나기를 기다림
+    rbtree_synchronize(t);
+#endif
+    *lt = t;
+    *ge = u;
+    return 0;
+}
+
+/**
+ * 작업 훔치기(work-stealing) 스레드 풀 : 트리 전체를 다루는 연산의 재귀를 여러 코어에 나눔
+ * - 일꾼 스레드는 처음 병렬 연산을 부를 때 (CPU 수 - 1)개를 만들고 프로세스가 끝날 때까지 둠
+ *   환경 변수 RBTREE_THREADS로 부르는 스레드를 포함한 전체 스레드 수를 정할 수 있음 (1이면 병렬로 돌지 않음)
+ * - 스레드마다 작업 덱(deque)을 가짐. par_fork2는 두 번째 일을 자기 덱 아래쪽에 넣고 첫 번째 일을 바로 실행한 뒤,
+ *   아무도 가져가지 않았으면 직접 꺼내 실행하고, 가져갔으면 끝날 때까지 다른 덱의 일을 훔쳐 도우며 기다림
+ * - 노는 스레드는 다른 덱의 위쪽(가장 먼저 넣은 = 가장 큰 서브트리)을 훔침 -> 큰 조각부터 흩어지므로 훔치는 횟수가 적음
+ * - 병렬 연산을 부른 스레드도 빈 덱 하나를 빌려 일꾼으로 참여하고, 진행 중인 연산이 없으면 일꾼은 조건 변수에서 잠듦
+ * 작업은 서브트리 단위로 충분히 크게 나누므로(RBTREE_PAR_GRAIN) 덱은 뮤텍스로 보호해도 락 비용이 드러나지 않음
+ */
+#define RBTREE_PAR_MAX_THREADS 64
+#define RBTREE_PAR_CALLERS 8 // 병렬 연산을 동시에 부를 수 있는 스레드 수. 자리가 없으면 그 호출은 혼자 실행
+#define RBTREE_PAR_DEQUE 128 // 덱 하나에 쌓이는 작업 수의 상한. fork 깊이는 트리 높이를 넘지 않음 (넘으면 바로 실행)
+
+// 검정 높이가 이보다 낮은(노드가 수십 개 이하인) 서브트리는 더 나누지 않고 한 스레드에서 처리
+#define RBTREE_PAR_GRAIN 6
+
+typedef struct par_task {
+    void (*fn)(void *);
+    void *arg;
+    int done; // 훔쳐 간 스레드가 실행을 마치면 1
+} par_task;
+
+typedef struct {
+    _Alignas(RBTREE_CACHE_LINE) pthread_mutex_t lock;
+    size_t top, bottom; // [top, bottom)에 작업이 있음. 주인은 bottom 쪽에서 넣고 빼고, 도둑은 top 쪽에서 가져감
+    int busy;           // 호출자용 덱을 어떤 스레드가 빌려 쓰는 중이면 1
+    par_task *tasks[RBTREE_PAR_DEQUE];
+} par_deque;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    unsigned long active; // 진행 중인 병렬 연산 수. 0이면 일꾼은 잠듦
+    unsigned n_workers;   // 일꾼 수. 덱 0 .. n_workers - 1은 일꾼, 그 뒤 RBTREE_PAR_CALLERS개는 호출자용
+    par_deque deques[RBTREE_PAR_MAX_THREADS + RBTREE_PAR_CALLERS];
+} par = {.once = PTHREAD_ONCE_INIT, .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
+
+static _Thread_local par_deque *my_deque; // 이 스레드의 덱. 병렬 연산 밖이면 NULL
+
+// 덱 아래쪽에 넣음. 가득 찼으면 0 (호출자가 바로 실행)
+static int par_push(par_deque *d, par_task *task) {
+    pthread_mutex_lock(&d->lock);
+    const size_t bottom = d->bottom;
+    const int ok = bottom < RBTREE_PAR_DEQUE;
+    if (ok) {
+        d->tasks[bottom] = task;
+        __atomic_store_n(&d->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// 맨 아래가 task이면 꺼냄 (아무도 훔쳐 가지 않음). 훔쳐 갔다면 0
+// fork / join이 짝을 이루므로 task 위에 넣은 일은 이미 모두 꺼냈고, 도둑은 위쪽부터 가져가므로 task만 보면 됨
+static int par_pop(par_deque *d, par_task *task) {
+    pthread_mutex_lock(&d->lock);
+    const int ok = d->bottom > d->top && d->tasks[d->bottom - 1] == task;
+    if (ok) {
+        const size_t bottom = d->bottom - 1;
+        __atomic_store_n(&d->bottom, bottom == d->top ? 0 : bottom, __ATOMIC_RELAXED);
+        if (bottom == d->top) { // 비었으면 처음부터 다시 씀
+            __atomic_store_n(&d->top, 0, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// self 다음 덱부터 돌아가며 위쪽 작업 하나를 훔침. 없으면 NULL
+static par_task *par_steal(const par_deque *self) {
+    const unsigned n = par.n_workers + RBTREE_PAR_CALLERS;
+    const unsigned first = (unsigned)(self - par.deques) + 1;
+    for (unsigned i = 0; i < n; i++) {
+        par_deque *d = &par.deques[(first + i) % n];
+        // 락 없이 먼저 보고 빈 덱은 건너뜀 -> 노는 스레드끼리 락을 두고 다투지 않음
+        if (__atomic_load_n(&d->bottom, __ATOMIC_RELAXED) <= __atomic_load_n(&d->top, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        par_task *task = NULL;
+        pthread_mutex_lock(&d->lock);
+        if (d->bottom > d->top) {
+            task = d->tasks[d->top];
+            if (d->top + 1 == d->bottom) {
+                __atomic_store_n(&d->top, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&d->bottom, 0, __ATOMIC_RELAXED);
+            } else {
+                __atomic_store_n(&d->top, d->top + 1, __ATOMIC_RELAXED);
+            }
+        }
+        pthread_mutex_unlock(&d->lock);
+        if (task != NULL) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// 훔친 작업을 실행하고 끝났음을 알림. 결과를 쓴 뒤 done을 보이도록 release
+static void par_exec(par_task *task) {
+    task->fn(task->arg);
+    __atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+}
+
+static void *par_worker(void *arg) {
+    my_deque = (par_deque *)arg;
+    for (unsigned tries = 0;;) {
+        if (__atomic_load_n(&par.active, __ATOMIC_ACQUIRE) == 0) {
+            pthread_mutex_lock(&par.lock);
+            while (par.active == 0) {
+                pthread_cond_wait(&par.wake, &par.lock);
+            }
+            pthread_mutex_unlock(&par.lock);
+        }
+        par_task *task = par_steal(my_deque);
+        if (task != NULL) {
+            par_exec(task);
+            tries = 0;
+        } else {
+            spin_wait(tries++);
+        }
+    }
+    return NULL;
+}
+
+static void par_init(void) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *env = getenv("RBTREE_THREADS");
+    if (env != NULL && atol(env) > 0) {
+        threads = atol(env);
+    }
+    par.n_workers = threads > RBTREE_PAR_MAX_THREADS ? RBTREE_PAR_MAX_THREADS : threads > 1 ? (unsigned)threads - 1 : 0;
+    for (unsigned i = 0; i < par.n_workers + RBTREE_PAR_CALLERS; i++) {
+        pthread_mutex_init(&par.deques[i].lock, NULL);
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (unsigned i = 0; i < par.n_workers; i++) {
+        pthread_t th;
+        pthread_create(&th, &attr, par_worker, &par.deques[i]); // 만들지 못한 일꾼의 덱은 비어 있을 뿐 동작은 같음
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// fn(arg)를 스레드 풀에서 실행. 이 스레드도 빌린 덱으로 참여하고, 그 안의 par_fork2가 일을 나눔
+static void par_run(void (*fn)(void *), void *arg) {
+    if (my_deque != NULL) { // 이미 병렬 연산 안 (그 안에서 다시 부른 경우)
+        fn(arg);
+        return;
+    }
+    pthread_once(&par.once, par_init);
+    par_deque *d = NULL;
+    for (unsigned i = 0; i < RBTREE_PAR_CALLERS && par.n_workers > 0 && d == NULL; i++) {
+        if (!__atomic_exchange_n(&par.deques[par.n_workers + i].busy, 1, __ATOMIC_ACQUIRE)) {
+            d = &par.deques[par.n_workers + i];
+        }
+    }
+    if (d == NULL) { // 일꾼이 없거나 빌릴 덱이 없으면 혼자 실행 (par_fork2가 나누지 않음)
+        fn(arg);
+        return;
+    }
+    my_deque = d;
+    pthread_mutex_lock(&par.lock);
+    __atomic_store_n(&par.active, par.active + 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&par.wake);
+    pthread_mutex_unlock(&par.lock);
+    fn(arg);
+    pthread_mutex_lock(&par.lock);
+    __atomic_store_n(&par.active, par.active - 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&par.lock);
+    my_deque = NULL;
+    __atomic_store_n(&d->busy, 0, __ATOMIC_RELEASE);
+}
+
+// fa(a)와 fb(b)를 (가능하면) 동시에 실행하고 둘 다 끝나면 반환. 두 일은 서로 다른 데이터만 건드려야 함
+static void par_fork2(void (*fa)(void *), void *a, void (*fb)(void *), void *b) {
+    par_deque *d = my_deque;
+    par_task tb = {fb, b, 0};
+    if (d == NULL || !par_push(d, &tb)) {
+        fa(a);
+        fb(b);
+        return;
+    }
+    fa(a);
+    if (par_pop(d, &tb)) {
+        fb(b);
+        return;
+    }
+    for (unsigned tries = 0; !__atomic_load_n(&tb.done, __ATOMIC_ACQUIRE);) {
+        par_task *task = par_steal(d);
+        if (task != NULL) {
+            par_exec(task);
+            tries = 0;
+        } else {
+            spin_wait(tries++);
+        }
+    }
+}
+
+/**
+ * 집합 연산 (rbtree_union / rbtree_intersect / rbtree_difference) : join 기반 분할 정복
+ * 1. b의 루트 k를 떼어내고, a를 k 미만 / k와 같은 키 / k 초과로 split (b의 두 자식에서도 k와 같은 키를 골라냄)
+ * 2. 미만끼리, 초과끼리 재귀로 연산 -> 두 재귀는 서로 다른 노드만 다루므로 스레드 풀에서 동시에 실행
+ * 3. 연산에 따라 k와 같은 키의 노드를 남기거나 버리고, 세 조각을 join으로 다시 엮음
+ * a, b의 크기가 m <= n일 때 일은 O(m log(n / m + 1)), 재귀 깊이는 O(log n log m)
+ * 결과에 남지 않는 노드는 서브트리째 모아두었다가 병렬 구간이 끝난 뒤 한 스레드에서 반납 (free list는 스레드 하나만 씀)
+ */
+enum { SETOP_UNION, SETOP_INTERSECT, SETOP_DIFFERENCE };
+
+typedef struct setop_task {
+    rbtree s; // 원래 트리의 복사본. join / split이 root를 작업 공간으로 쓰므로 동시에 도는 작업마다 따로 둠
+#ifdef RBTREE_STATS
+    rbtree_stats stats; // s.stats가 가리킴. 끝나면 부모 작업에 더함
+#endif
+    int op;
+    node_t *a, *b; // t1 쪽, t2 쪽 서브트리 (부모는 nil)와 검정 높이
+    size_t ha, hb;
+    node_t *out; // 결과 서브트리와 검정 높이
+    size_t hout;
+    node_t *gc_head, *gc_tail; // 버린 서브트리들의 루트 (parent 필드로 연결)
+} setop_task;
+
+// 결과에 넣지 않을 서브트리 x를 버릴 목록에 붙임
+static void setop_discard(setop_task *c, node_t *x) {
+    if (x == c->s.nil) {
+        return;
+    }
+    set_parent(x, NULL);
+    if (c->gc_tail == NULL) {
+        c->gc_head = x;
+    } else {
+        set_parent(c->gc_tail, x);
+    }
+    c->gc_tail = x;
+}
+
+// 끝난 하위 작업의 버릴 목록과 통계를 c로 넘김
+static void setop_gather(setop_task *c, setop_task *sub) {
+    if (sub->gc_head != NULL) {
+        if (c->gc_tail == NULL) {
+            c->gc_head = sub->gc_head;
+        } else {
+            set_parent(c->gc_tail, sub->gc_head);
+        }
+        c->gc_tail = sub->gc_tail;
+    }
+#ifdef RBTREE_STATS
+    c->s.stats->rotations += sub->stats.rotations; // join / split / erase_node가 세는 카운터
+    c->s.stats->insert_fixups += sub->stats.insert_fixups;
+    c->s.stats->erase_fixups += sub->stats.erase_fixups;
+#endif
+}
+
+static void setop_run(void *arg) {
+    setop_task *c = (setop_task *)arg;
+    rbtree *t = &c->s;
+    node_t *b = c->b;
+    if (c->a == t->nil || b == t->nil) {
+        // 한쪽이 비었으면 합집합은 남은 쪽, 교집합은 빈 트리, 차집합은 a 그대로
+        const int keep_a = c->op != SETOP_INTERSECT, keep_b = c->op == SETOP_UNION;
+        c->out = t->nil;
+        c->hout = 0;
+        if (c->a != t->nil) {
+            keep_a ? (c->out = c->a, c->hout = c->ha) : (setop_discard(c, c->a), 0);
+        } else if (b != t->nil) {
+            keep_b ? (c->out = b, c->hout = c->hb) : (setop_discard(c, b), 0);
+        }
+        return;
+    }
+
+    // 1. b의 루트 k를 떼어내고 a는 k 미만(lt) / k와 같은 키(eq) / k 초과(gt)로, b의 두 자식도 k와 같은 키를 골라냄
+    const key_t key = b->key;
+    size_t hl = c->hb - (rbtree_color(b) == RBTREE_BLACK), hr = hl;
+    node_t *l = detach_root(t, b->left, &hl), *r = detach_root(t, b->right, &hr);
+    b->left = b->right = t->nil;
+    node_t *lt, *rest, *eq, *gt, *l_lt, *l_eq, *r_eq, *r_gt;
+    size_t hlt, hrest, heq, hgt, hl_lt, hl_eq, hr_eq, hr_gt;
+    split_nodes(t, c->a, c->ha, key, 0, &lt, &hlt, &rest, &hrest);
+    split_nodes(t, rest, hrest, key, 1, &eq, &heq, &gt, &hgt);
+    split_nodes(t, l, hl, key, 0, &l_lt, &hl_lt, &l_eq, &hl_eq);
+    split_nodes(t, r, hr, key, 1, &r_eq, &hr_eq, &r_gt, &hr_gt);
+
+    // 2. 양쪽 절반을 재귀로. b가 충분히 크면 한쪽을 다른 스레드가 가져갈 수 있게 나눔
+    setop_task sub[2] = {{.s = c->s, .op = c->op, .a = lt, .ha = hlt, .b = l_lt, .hb = hl_lt},
+                         {.s = c->s, .op = c->op, .a = gt, .ha = hgt, .b = r_gt, .hb = hr_gt}};
+#ifdef RBTREE_STATS
+    sub[0].s.stats = &sub[0].stats;
+    sub[1].s.stats = &sub[1].stats;
+#endif
+    if (c->hb >= RBTREE_PAR_GRAIN) {
+        par_fork2(setop_run, &sub[0], setop_run, &sub[1]);
+    } else {
+        setop_run(&sub[0]);
+        setop_run(&sub[1]);
+    }
+    setop_gather(c, &sub[0]);
+    setop_gather(c, &sub[1]);
+
+    // 3. 가운데 : k와 같은 키. 합집합 / 교집합은 a 쪽이 있으면 a 쪽을 남기고 b 쪽을 버림, 차집합은 모두 버림
+    node_t *mid = t->nil;
+    size_t hmid = 0;
+    if (c->op == SETOP_UNION && eq == t->nil) {
+        mid = join_nodes(t, l_eq, hl_eq, b, r_eq, hr_eq, &hmid);
+    } else {
+        setop_discard(c, b);
+        setop_discard(c, l_eq);
+        setop_discard(c, r_eq);
+        if (c->op == SETOP_DIFFERENCE) {
+            setop_discard(c, eq);
+        } else {
+            mid = eq;
+            hmid = heq;
+        }
+    }
+    size_t h;
+    node_t *x = concat_nodes(t, sub[0].out, sub[0].hout, mid, hmid, &h);
+    c->out = concat_nodes(t, x, h, sub[1].out, sub[1].hout, &c->hout);
+}
+
+// t2를 t1에 연산해 넣고 t2를 해제. 풀 모드가 다르거나 스냅샷이 있으면 -1
+static int set_op(rbtree *t1, rbtree *t2, const int op) {
+    if (t1 == NULL || t2 == NULL || t1 == t2 || !movable(t1) || !movable(t2) ||
+        (t1->pool == NULL) != (t2->pool == NULL)) {
+        return -1;
+    }
+#ifdef RBTREE_CONCURRENT
+    rbtree_synchronize(t2); // rbtree_join과 같이, 해제를 기다리던 t2의 노드를 먼저 반납
+#endif
+    if (t1->pool != NULL) {
+        if (pool_adopt(t1->pool, t2->pool) != 0) {
+            return -1;
+        }
+        t2->pool = NULL;
+    }
+    setop_task top = {.s = *t1, .op = op, .a = t1->root, .ha = black_height(t1, t1->root), .b = t2->root,
+                      .hb = black_height(t2, t2->root)};
+#ifdef RBTREE_STATS
+    top.s.stats = &top.stats;
+#endif
+    write_begin(t1);
+    par_run(setop_run, &top);
+    SET_LINK(t1, root, top.out);
+#ifdef RBTREE_FINGER
+    t1->finger = NULL;
+#endif
+    for (node_t *x = top.gc_head; x != NULL;) {
+        node_t *next = rbtree_parent(x); // 반납하면 parent 필드가 바뀔 수 있으므로 먼저 읽음
+#ifdef RBTREE_CONCURRENT
+        free_subtree(t1, x, node_retire);
+#else
+        free_subtree(t1, x, node_free);
+#endif
+        x = next;
+    }
+    write_end(t1);
+#ifdef RBTREE_STATS
+    setop_task sum = {.s = *t1}; // 병렬로 센 카운터를 t1에 더함
+    setop_gather(&sum, &top);
+#endif
+    t2->root = t2->nil;
+    delete_rbtree(t2);
+#ifdef RBTREE_CONCURRENT
+    if (t1->sync->n_retired >= RBTREE_RECLAIM_BATCH) {
+        rbtree_synchronize(t1);
+    }
+#endif
+    return 0;
+}
+
+int rbtree_union(rbtree *t1, rbtree *t2) {
+    return set_op(t1, t2, SETOP_UNION);
+}
+
+int rbtree_intersect(rbtree *t1, rbtree *t2) {
+    return set_op(t1, t2, SETOP_INTERSECT);
+}
+
+int rbtree_difference(rbtree *t1, rbtree *t2) {
+    return set_op(t1, t2, SETOP_DIFFERENCE);
+}
+
+// x 서브트리의 키를 오름차순으로 arr에 최대 n개 쓰고 쓴 개수를 반환. arr가 NULL이면 쓰지 않고 세기만 함
+static size_t subtree_to_array(const rbtree *t, node_t *x, key_t *arr, const size_t n) {
+    size_t index = 0;
+    /**
+     * 재귀 대신 크기가 고정된 지역 배열을 스택으로 써서 중위 순회
+     * rbtree의 높이는 2 * log2(n + 1) 이하이므로 64비트 주소 공간에 들어가는 어떤 트리도 RBTREE_MAX_HEIGHT를 넘지 않음
+     * -> 호출 프레임마다 인자 5개를 넘기던 비용이 없고, 트리 모양과 상관없이 스택 사용량이 일정
+     * 부모 포인터를 따라 successor를 구하는 방식은 이미 지나온 부모 노드를 다시 읽느라 캐시 미스가 늘어 더 느렸음
+     */
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    size_t top = 0;
+    while (index < n) {       // n개를 채우는 즉시 멈추므로 나머지 노드는 방문하지 않음
+        while (x != t->nil) { // 왼쪽 끝까지 내려가며 지나온 노드를 쌓아둠
+            stack[top++] = x;
+            x = x->left;
+        }
+        if (top == 0) { // 더 방문할 노드가 없음
+            break;
+        }
+        x = stack[--top];
+#ifdef RBTREE_MULTISET
+        for (uint32_t c = x->count; c > 0 && index < n; c--) { // 같은 키를 count번 펼쳐 씀
+            if (arr != NULL) {
+                arr[index] = x->key;
+            }
+            index++;
+        }
+#else
+        if (arr != NULL) {
+            arr[index] = x->key;
+        }
+        index++;
+#endif
+        x = x->right;
+    }
+    return index;
 }
 
 int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
     if (t == NULL || arr == NULL) {
         return -1;
     }
-    size_t index = 0;
     /**
      * int가 아닌 size_t 타입을 왜 쓰는가?
      * size_t는 크기나 인덱스를 표현하는데 최적화된 타입임
@@ -395,14 +2236,606 @@ int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
      * unsigned int와 유사하게 양수만 표현이 가능하지만 더 큰 범위를 가짐
      * -> 메모리나 배열 크기를 표현할 때 절대 음수가 될 수 없고, 시스템 메모리 한계까지 표현 가능
      */
-    /**
-     * index를 값 전달이 아닌 주소 전달을 해야하는 이유?
-     * index를 값 전달로 사용하게 되면 각 재귀 호출마다 index 값이 복사되어 사용됨
-     * 즉, 왼쪽 서브트리에 값을 넣고 돌아왔을 때 index 값이 갱신되지 않고 계속 0번째 칸에 덮어씌워짐
-     * index의 주소를 넘기면 모든 재귀에서 하나의 index를 공유할 수 있음 -> 증가된 값 유지
-     * 따라서 왼쪽 서브트리에 몇 개를 넣었는지, result 배열에 얼만큼 채워졌는지를 알 수 있기 때문에 올바른 누적이 가능
-     * -> 오름차순 정렬 배열을 구현할 수 있게됨
-     */
-    inorder_store(t, t->root, arr, &index, n);
+    subtree_to_array(t, t->root, arr, n);
+    return 0;
+}
+
+/**
+ * 트리 전체를 훑는 연산의 병렬 버전 (rbtree_to_array_par / rbtree_foreach_par / delete_rbtree_par)
+ * 루트에서 RBTREE_PAR_CUT_DEPTH 깊이까지의 노드를 잘라 중위 순서의 조각 목록을 만듦
+ * -> 그 깊이의 서브트리(최대 2^depth개)와 그 위의 노드 하나짜리 조각이 번갈아 놓임
+ * 조각마다 앞에 오는 노드 수(offset)를 알면 각 스레드가 출력 배열의 자기 구간에 바로 씀
+ * (RBTREE_ORDER_STAT은 서브트리 크기를 그대로 쓰고, 아니면 조각별로 세는 패스를 먼저 병렬로 돌림)
+ */
+#define RBTREE_PAR_CUT_DEPTH 8
+#define RBTREE_PAR_MAX_PIECES ((2u << RBTREE_PAR_CUT_DEPTH) - 1)
+
+// 검정 높이가 이보다 낮은 트리(무작위로 넣었다면 노드 수만 개 이하)는 스레드를 깨우는 비용이 더 커서 한 스레드로 처리
+#define RBTREE_PAR_MIN_HEIGHT 10
+
+typedef struct {
+    node_t *node;
+    int whole;     // 1이면 node의 서브트리 전체, 0이면 node 하나 (자른 깊이보다 위의 노드)
+    size_t offset; // 중위 순서에서 이 조각 앞에 오는 키 수 (멀티셋 모드에서는 count로 펼친 수)
+    size_t count;  // 이 조각의 키 수
+} par_piece;
+
+// x 서브트리를 depth부터 잘라 pieces[n]부터 중위 순서로 채우고 다음 빈 칸 번호를 반환
+static size_t par_cut(const rbtree *t, node_t *x, const unsigned depth, par_piece *pieces, size_t n) {
+    if (x == t->nil) {
+        return n;
+    }
+    if (depth == RBTREE_PAR_CUT_DEPTH) {
+        pieces[n++] = (par_piece){x, 1, 0, 0};
+        return n;
+    }
+    n = par_cut(t, x->left, depth + 1, pieces, n);
+    pieces[n++] = (par_piece){x, 0, 0, rbtree_key_count(x)};
+    return par_cut(t, x->right, depth + 1, pieces, n);
+}
+
+// 병렬 for : fn(ctx, i)를 i = lo .. hi - 1에 대해 구간을 반씩 나눠 par_fork2로 실행
+typedef struct {
+    void (*fn)(void *, size_t);
+    void *ctx;
+    size_t lo, hi;
+} par_range;
+
+static void par_for_run(void *arg) {
+    const par_range *r = (const par_range *)arg;
+    if (r->hi - r->lo == 1) {
+        r->fn(r->ctx, r->lo);
+        return;
+    }
+    const size_t mid = r->lo + (r->hi - r->lo) / 2;
+    par_range a = {r->fn, r->ctx, r->lo, mid}, b = {r->fn, r->ctx, mid, r->hi};
+    par_fork2(par_for_run, &a, par_for_run, &b);
+}
+
+static void par_for(const size_t n, void (*fn)(void *, size_t), void *ctx) {
+    if (n > 0) {
+        par_range r = {fn, ctx, 0, n};
+        par_run(par_for_run, &r);
+    }
+}
+
+// 트리가 병렬로 나눌 만큼 크고 일꾼 스레드가 있으면 조각 목록을 만들고 조각 수를, 아니면 0을 반환
+// (한 스레드뿐이면 나누지 않음 -> rbtree_to_array_par가 세는 패스 없이 rbtree_to_array와 같아짐)
+static size_t par_pieces(const rbtree *t, par_piece *pieces) {
+    if (black_height(t, t->root) < RBTREE_PAR_MIN_HEIGHT) { // 작은 트리만 다루는 프로그램은 풀을 만들지 않음
+        return 0;
+    }
+    pthread_once(&par.once, par_init);
+    if (par.n_workers == 0) {
+        return 0;
+    }
+    return par_cut(t, t->root, 0, pieces, 0);
+}
+
+typedef struct {
+    const rbtree *t;
+    par_piece *pieces;
+    key_t *arr;
+    size_t n;
+} to_array_ctx;
+
+#ifndef RBTREE_ORDER_STAT
+static void to_array_count(void *arg, const size_t i) {
+    to_array_ctx *c = (to_array_ctx *)arg;
+    if (c->pieces[i].whole) {
+        c->pieces[i].count = subtree_to_array(c->t, c->pieces[i].node, NULL, SIZE_MAX);
+    }
+}
+#endif
+
+static void to_array_fill(void *arg, const size_t i) {
+    const to_array_ctx *c = (const to_array_ctx *)arg;
+    const par_piece *p = &c->pieces[i];
+    if (p->offset >= c->n) {
+        return;
+    }
+    const size_t limit = c->n - p->offset < p->count ? c->n - p->offset : p->count;
+    if (p->whole) {
+        subtree_to_array(c->t, p->node, c->arr + p->offset, limit);
+    } else {
+        for (size_t j = 0; j < limit; j++) { // 멀티셋 모드에서는 노드 하나가 count칸
+            c->arr[p->offset + j] = p->node->key;
+        }
+    }
+}
+
+int rbtree_to_array_par(const rbtree *t, key_t *arr, const size_t n) {
+    if (t == NULL || arr == NULL) {
+        return -1;
+    }
+    par_piece pieces[RBTREE_PAR_MAX_PIECES];
+    const size_t n_pieces = par_pieces(t, pieces);
+    if (n_pieces == 0) {
+        subtree_to_array(t, t->root, arr, n);
+        return 0;
+    }
+    to_array_ctx c = {t, pieces, arr, n};
+#ifdef RBTREE_ORDER_STAT
+    for (size_t i = 0; i < n_pieces; i++) {
+        if (pieces[i].whole) {
+            pieces[i].count = pieces[i].node->size;
+        }
+    }
+#else
+    par_for(n_pieces, to_array_count, &c); // 세는 패스. 키를 쓰는 패스와 같은 순회지만 쓰기가 없음
+#endif
+    size_t offset = 0;
+    for (size_t i = 0; i < n_pieces; i++) {
+        pieces[i].offset = offset;
+        offset += pieces[i].count;
+    }
+    par_for(n_pieces, to_array_fill, &c);
+    return 0;
+}
+
+typedef struct {
+    const rbtree *t;
+    const par_piece *pieces;
+    rbtree_visit_fn visit;
+    void *ctx;
+    int stop; // 콜백 하나가 0이 아닌 값을 돌려주면 1. 다른 스레드는 다음 노드에서 멈춤
+} foreach_ctx;
+
+static void foreach_piece(void *arg, const size_t i) {
+    foreach_ctx *c = (foreach_ctx *)arg;
+    const par_piece *p = &c->pieces[i];
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    size_t top = 0;
+    node_t *x = p->node;
+    if (!p->whole) {
+        stack[top++] = x;
+        x = c->t->nil;
+    }
+    while (!__atomic_load_n(&c->stop, __ATOMIC_RELAXED)) {
+        for (; x != c->t->nil; x = x->left) {
+            stack[top++] = x;
+        }
+        if (top == 0) {
+            break;
+        }
+        x = stack[--top];
+        if (c->visit(x, c->ctx) != 0) {
+            __atomic_store_n(&c->stop, 1, __ATOMIC_RELAXED);
+        }
+        x = p->whole ? x->right : c->t->nil;
+    }
+}
+
+int rbtree_foreach_par(const rbtree *t, rbtree_visit_fn visit, void *ctx) {
+    if (t == NULL || visit == NULL) {
+        return -1;
+    }
+    par_piece pieces[RBTREE_PAR_MAX_PIECES];
+    size_t n_pieces = par_pieces(t, pieces);
+    if (n_pieces == 0 && t->root != t->nil) { // 작은 트리는 통째로 한 조각
+        pieces[n_pieces++] = (par_piece){t->root, 1, 0, 0};
+    }
+    foreach_ctx c = {t, pieces, visit, ctx, 0};
+    if (n_pieces == 1) {
+        foreach_piece(&c, 0);
+    } else {
+        par_for(n_pieces, foreach_piece, &c);
+    }
+    return c.stop;
+}
+
+// delete_rbtree_par가 서브트리를 반납할 때 씀. 트리와 함께 통계도 사라지므로 세지 않음 (여러 스레드가 동시에 부름)
+static void node_free_par(rbtree *t, node_t *z) {
+    (void)t;
+    free(z);
+}
+
+typedef struct {
+    rbtree *t;
+    const par_piece *pieces;
+} teardown_ctx;
+
+static void teardown_piece(void *arg, const size_t i) {
+    const teardown_ctx *c = (const teardown_ctx *)arg;
+    if (c->pieces[i].whole) { // 자른 깊이보다 위의 노드는 다른 조각이 아직 읽으므로 모두 끝난 뒤 해제
+        free_subtree(c->t, c->pieces[i].node, node_free_par);
+    }
+}
+
+void delete_rbtree_par(rbtree *t) {
+    if (t == NULL) {
+        return;
+    }
+    par_piece pieces[RBTREE_PAR_MAX_PIECES];
+    size_t n_pieces;
+    // 풀 모드는 delete_rbtree가 이미 노드를 하나씩 돌지 않고 slab 단위로 해제함
+    if (t->pool == NULL && (n_pieces = par_pieces(t, pieces)) > 0) {
+        teardown_ctx c = {t, pieces};
+        par_for(n_pieces, teardown_piece, &c);
+        for (size_t i = 0; i < n_pieces; i++) {
+            if (!pieces[i].whole) {
+                free(pieces[i].node);
+            }
+        }
+        t->root = t->nil;
+    }
+    delete_rbtree(t);
+}
+
+/**
+ * rbtree_save / rbtree_load 파일 형식 (모든 정수는 리틀 엔디언)
+ * - 헤더 8바이트 : 'R' 'B' 'T' 'S', 버전(16비트), 키 크기(바이트), 인코딩
+ * - 본문 : 오름차순 키를 앞 키와의 차이로 바꿔 7비트씩 나눈 가변 길이 정수(LEB128)로 기록
+ *   키를 부호 없는 정수로 옮긴 u = key ^ 0x80000000은 순서가 같으므로 차이는 항상 0 이상
+ *   -> 키가 촘촘할수록 작아짐 (차이가 128 미만이면 키 하나에 1바이트, 최악이라도 5바이트)
+ * - 꼬리 16바이트 : 키 개수(64비트), 체크섬(64비트)
+ *   개수와 체크섬은 순회가 끝나야 알 수 있으므로 뒤에 두어 파일을 앞에서부터 한 번에 써 내려감 (파이프에도 쓸 수 있음)
+ * 체크섬은 u 값들을 32비트 단위 FNV-1a로 섞은 값. 손상 검출용이고 암호학적 해시는 아님
+ */
+#define RBTREE_FILE_VERSION 1
+#define RBTREE_FILE_VARINT 1 // 인코딩 : 차이의 가변 길이 정수
+#define RBTREE_FILE_HEADER 8
+#define RBTREE_FILE_TRAILER 16
+#define RBTREE_IO_BUFFER 65536
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+// 일부만 써지거나 시그널로 끊겨도 len바이트를 모두 쓸 때까지 반복
+static int write_all(int fd, const unsigned char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+int rbtree_save(const rbtree *t, int fd) {
+    if (t == NULL || fd < 0) {
+        return -1;
+    }
+    unsigned char buf[RBTREE_IO_BUFFER];
+    const unsigned char header[RBTREE_FILE_HEADER] = {'R', 'B', 'T', 'S', RBTREE_FILE_VERSION, 0, sizeof(key_t),
+                                                      RBTREE_FILE_VARINT};
+    memcpy(buf, header, sizeof(header));
+    size_t len = sizeof(header);
+    uint64_t count = 0, sum = FNV_OFFSET;
+    uint32_t prev = 0;
+
+    // rbtree_to_array와 같은 스택 중위 순회. 부모 포인터를 쓰지 않으므로 스냅샷(RBTREE_COW)도 저장할 수 있음
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    size_t top = 0;
+    node_t *x = t->root;
+    for (;;) {
+        while (x != t->nil) {
+            stack[top++] = x;
+            x = x->left;
+        }
+        if (top == 0) {
+            break;
+        }
+        x = stack[--top];
+        if (len > sizeof(buf) - 5) { // 가변 길이 정수 하나는 최대 5바이트
+            if (write_all(fd, buf, len) != 0) {
+                return -1;
+            }
+            len = 0;
+        }
+        uint32_t u = (uint32_t)x->key ^ 0x80000000u;
+        uint32_t delta = u - prev;
+        while (delta >= 0x80) {
+            buf[len++] = (unsigned char)(delta | 0x80);
+            delta >>= 7;
+        }
+        buf[len++] = (unsigned char)delta;
+        prev = u;
+        sum = (sum ^ u) * FNV_PRIME;
+        count++;
+#ifdef RBTREE_MULTISET
+        // 같은 키는 차이 0(1바이트)으로 반복 -> 기본 트리로 저장한 파일과 같고, 어느 모드로든 읽을 수 있음
+        for (uint32_t c = x->count; c > 1; c--) {
+            if (len == sizeof(buf)) {
+                if (write_all(fd, buf, len) != 0) {
+                    return -1;
+                }
+                len = 0;
+            }
+            buf[len++] = 0;
+            sum = (sum ^ u) * FNV_PRIME;
+            count++;
+        }
+#endif
+        x = x->right;
+    }
+
+    if (len > sizeof(buf) - RBTREE_FILE_TRAILER) {
+        if (write_all(fd, buf, len) != 0) {
+            return -1;
+        }
+        len = 0;
+    }
+    put_u64(buf + len, count);
+    put_u64(buf + len + 8, sum);
+    return write_all(fd, buf, len + RBTREE_FILE_TRAILER);
+}
+
+// 본문을 풀어 nodes[0..n)의 키에 차례로 채움. 형식이 어긋나거나 체크섬이 다르면 -1
+static int decode_keys(const unsigned char *p, const unsigned char *end, node_t *nodes, const uint64_t n,
+                       const uint64_t expected_sum) {
+    uint64_t u = 0, sum = FNV_OFFSET;
+    for (uint64_t i = 0; i < n; i++) {
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p == end || (shift == 28 && *p > 0x0f)) { // 잘린 파일이거나 32비트를 넘는 값
+                return -1;
+            }
+            const unsigned char b = *p++;
+            delta |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        u += delta;
+        if (u > UINT32_MAX) { // 차이를 더하다 범위를 넘었다면 손상된 파일
+            return -1;
+        }
+        nodes[i].key = (key_t)(int32_t)((uint32_t)u ^ 0x80000000u);
+        sum = (sum ^ u) * FNV_PRIME;
+    }
+    return p == end && sum == expected_sum ? 0 : -1;
+}
+
+rbtree *rbtree_load(int fd) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size < RBTREE_FILE_HEADER + RBTREE_FILE_TRAILER) {
+        return NULL;
+    }
+    const size_t size = (size_t)st.st_size;
+    // read로 버퍼에 복사하지 않고 페이지 캐시를 그대로 매핑해서 한 번 훑음
+    const unsigned char *file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file == MAP_FAILED) {
+        return NULL;
+    }
+    madvise((void *)file, size, MADV_SEQUENTIAL); // 앞에서부터 한 번만 읽으므로 미리 읽기를 늘림
+
+    rbtree *t = NULL;
+    const unsigned char *body = file + RBTREE_FILE_HEADER;
+    const unsigned char *end = file + size - RBTREE_FILE_TRAILER;
+    const uint64_t n = get_u64(end);
+    // 키 하나는 1바이트 이상이므로 본문보다 많은 개수는 손상된 꼬리 -> 터무니없는 크기를 할당하지 않음
+    if (memcmp(file, "RBTS", 4) == 0 && file[4] == RBTREE_FILE_VERSION && file[5] == 0 && file[6] == sizeof(key_t) &&
+        file[7] == RBTREE_FILE_VARINT && n <= (uint64_t)(end - body)) {
+        // 노드 n개를 한 slab에 잡고 키를 순서대로 채운 뒤 rbtree_from_sorted처럼 O(n)에 연결
+        t = new_rbtree_with_pool((size_t)n);
+        if (t != NULL && decode_keys(body, end, t->pool->current->nodes, n, get_u64(end + 8)) != 0) {
+            delete_rbtree(t);
+            t = NULL;
+        } else if (t != NULL && n > 0) {
+#ifdef RBTREE_MULTISET
+            link_sorted(t, NULL, pack_counts(t->pool->current->nodes, NULL, (size_t)n));
+#else
+            link_sorted(t, NULL, (size_t)n);
+#endif
+        }
+    }
+    munmap((void *)file, size);
+    return t;
+}
+
+/**
+ * 얼린 트리 (rbtree_freeze)
+ * 정렬된 키를 64바이트(키 16개) 블록으로 나눈 배열을 리프 층으로 두고,
+ * 그 위에 캐시 라인 하나 크기의 B+ tree 내부 노드를 쌓음
+ * - 리프 층 : 키를 오름차순 그대로 이어 붙이고 마지막 블록을 INT_MAX로 채움 -> range는 배열을 앞으로 훑기만 하면 됨
+ * - 내부 층 : h층 노드 k의 자식은 h-1층의 17k .. 17k+16 (포인터 없이 번호 계산으로 찾음)
+ *             j번째 키는 j+1번째 자식 서브트리의 최솟값. 없는 자식이면 INT_MAX -> 그쪽으로는 내려가지 않음
+ * 탐색은 층마다 노드(캐시 라인 한 줄)에서 "찾는 키보다 작은 키의 개수"를 SIMD로 세어 그 번호의 자식으로 내려감
+ * -> 키 1000만 개도 6층이라 캐시 미스가 6번 정도 (rbtree_find는 노드마다 한 번씩 30번 가까이)
+ * 다음 층의 위치는 이번 층의 비교 결과로 정해지므로 층 사이에는 미리 읽을 줄이 없음 (층마다 딱 한 줄만 읽음)
+ * 미리 읽기(prefetch)는 range가 리프 층을 훑는 동안 두 블록 앞을 가져오는 데 씀
+ */
+#define FROZEN_B 16                  // 노드 하나의 키 수 = 캐시 라인 / sizeof(key_t)
+#define FROZEN_FANOUT (FROZEN_B + 1) // 내부 노드의 자식 수
+#define FROZEN_MAX_LAYERS 16         // 17^15 > 2^61 블록이므로 어떤 크기도 넘지 않음
+
+_Static_assert(sizeof(key_t) * FROZEN_B == RBTREE_CACHE_LINE, "얼린 트리의 노드는 캐시 라인 하나");
+
+struct rbtree_frozen {
+    size_t n;                        // 키 개수
+    int height;                      // 내부 층 수 (리프 층 제외)
+    key_t *layer[FROZEN_MAX_LAYERS]; // layer[0] = 리프 층, layer[height] = 루트 노드 하나
+    key_t *mem;                      // 모든 층을 담은 한 번의 할당 (캐시 라인 정렬)
+};
+
+// node(키 16개)에서 x보다 작은 키의 개수
+static inline unsigned frozen_rank(const key_t *node, const key_t x) {
+#if defined(__AVX2__)
+    const __m256i v = _mm256_set1_epi32(x);
+    const __m256i a = _mm256_cmpgt_epi32(v, _mm256_load_si256((const __m256i *)node));
+    const __m256i b = _mm256_cmpgt_epi32(v, _mm256_load_si256((const __m256i *)(node + 8)));
+    // 비교 결과(0 또는 -1) 16개를 16비트씩으로 줄여 바이트 마스크로 모으면 키 하나가 2비트
+    // packs가 128비트 단위로 순서를 섞지만 개수만 세므로 상관없음
+    return (unsigned)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_packs_epi32(a, b))) / 2;
+#elif defined(__SSE2__)
+    const __m128i v = _mm_set1_epi32(x);
+    const __m128i a = _mm_cmpgt_epi32(v, _mm_load_si128((const __m128i *)node));
+    const __m128i b = _mm_cmpgt_epi32(v, _mm_load_si128((const __m128i *)(node + 4)));
+    const __m128i c = _mm_cmpgt_epi32(v, _mm_load_si128((const __m128i *)(node + 8)));
+    const __m128i d = _mm_cmpgt_epi32(v, _mm_load_si128((const __m128i *)(node + 12)));
+    const __m128i m = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)); // 키 하나당 1바이트
+    return (unsigned)__builtin_popcount((unsigned)_mm_movemask_epi8(m));
+#else
+    unsigned r = 0;
+    for (int i = 0; i < FROZEN_B; i++) {
+        r += node[i] < x; // 분기 없이 더해서 컴파일러가 벡터화할 수 있게 함
+    }
+    return r;
+#endif
+}
+
+// x 이상인 첫 키의 리프 층 위치. 모든 키가 x보다 작으면 n
+static size_t frozen_lower_bound(const rbtree_frozen *f, const key_t x) {
+    size_t k = 0;
+    for (int h = f->height; h > 0; h--) {
+        k = k * FROZEN_FANOUT + frozen_rank(f->layer[h] + k * FROZEN_B, x);
+    }
+    // 마지막 블록을 채운 INT_MAX는 어떤 x보다도 작지 않으므로 세지 않음 -> 결과는 n을 넘지 않음
+    return k * FROZEN_B + frozen_rank(f->layer[0] + k * FROZEN_B, x);
+}
+
+rbtree_frozen *rbtree_freeze(const rbtree *t) {
+    if (t == NULL) {
+        return NULL;
+    }
+    // 키 개수를 세어 층마다의 노드 수를 정함
+    size_t n = 0, top = 0;
+    node_t *stack[RBTREE_MAX_HEIGHT];
+    for (node_t *x = t->root; x != t->nil || top > 0; x = x->right) {
+        for (; x != t->nil; x = x->left) {
+            stack[top++] = x;
+        }
+        x = stack[--top];
+        n += rbtree_key_count(x);
+    }
+    rbtree_frozen *f = (rbtree_frozen *)calloc(1, sizeof(rbtree_frozen));
+    if (f == NULL) {
+        return NULL;
+    }
+    f->n = n;
+    size_t count[FROZEN_MAX_LAYERS], total = 0;
+    count[0] = n == 0 ? 1 : (n + FROZEN_B - 1) / FROZEN_B; // 빈 트리도 INT_MAX로 채운 블록 하나를 둠
+    for (int h = 0;; h++) {
+        total += count[h];
+        if (count[h] == 1) {
+            f->height = h;
+            break;
+        }
+        count[h + 1] = (count[h] + FROZEN_FANOUT - 1) / FROZEN_FANOUT;
+    }
+    f->mem = (key_t *)aligned_alloc(RBTREE_CACHE_LINE, total * RBTREE_CACHE_LINE);
+    if (f->mem == NULL) {
+        free(f);
+        return NULL;
+    }
+    f->layer[0] = f->mem;
+    for (int h = 1; h <= f->height; h++) {
+        f->layer[h] = f->layer[h - 1] + count[h - 1] * FROZEN_B;
+    }
+    rbtree_to_array(t, f->layer[0], n);
+    for (size_t i = n; i < count[0] * FROZEN_B; i++) {
+        f->layer[0][i] = INT_MAX;
+    }
+    // h층 노드 k의 j번째 키 = 자식 17k+j+1의 서브트리 최솟값 = 그 서브트리 맨 왼쪽 리프 블록의 첫 키
+    // h-1층 노드 m의 맨 왼쪽 리프 블록은 m * 17^(h-1)
+    size_t span = 1; // 17^(h-1)
+    for (int h = 1; h <= f->height; h++, span *= FROZEN_FANOUT) {
+        for (size_t k = 0; k < count[h]; k++) {
+            for (size_t j = 0; j < FROZEN_B; j++) {
+                const size_t block = (k * FROZEN_FANOUT + j + 1) * span;
+                f->layer[h][k * FROZEN_B + j] = block < count[0] ? f->layer[0][block * FROZEN_B] : INT_MAX;
+            }
+        }
+    }
+    return f;
+}
+
+void rbtree_frozen_free(rbtree_frozen *f) {
+    if (f == NULL) {
+        return;
+    }
+    free(f->mem);
+    free(f);
+}
+
+size_t rbtree_frozen_size(const rbtree_frozen *f) {
+    return f == NULL ? 0 : f->n;
+}
+
+int rbtree_frozen_find(const rbtree_frozen *f, const key_t key) {
+    if (f == NULL) {
+        return 0;
+    }
+    const size_t i = frozen_lower_bound(f, key);
+    return i < f->n && f->layer[0][i] == key;
+}
+
+const key_t *rbtree_frozen_lower_bound(const rbtree_frozen *f, const key_t key) {
+    if (f == NULL) {
+        return NULL;
+    }
+    const size_t i = frozen_lower_bound(f, key);
+    return i < f->n ? &f->layer[0][i] : NULL;
+}
+
+int rbtree_frozen_range(const rbtree_frozen *f, const key_t lo, const key_t hi, rbtree_key_visit_fn visit, void *ctx) {
+    if (f == NULL || visit == NULL) {
+        return -1;
+    }
+    const key_t *keys = f->layer[0];
+    for (size_t i = frozen_lower_bound(f, lo); i < f->n && keys[i] <= hi; i++) {
+        if (i % FROZEN_B == 0) {
+            __builtin_prefetch(keys + i + 2 * FROZEN_B); // 지금 블록을 도는 동안 두 블록 뒤를 가져옴
+        }
+        if (visit(keys[i], ctx) != 0) {
+            break;
+        }
+    }
     return 0;
 }
+
+#ifdef RBTREE_STATS
+// 서브트리 x의 높이 (노드 수 기준). 재귀 깊이는 트리 높이이므로 RBTREE_MAX_HEIGHT 이하
+// x 서브트리의 높이를 반환하고 노드 수를 *count에 더함
+static size_t subtree_height(const rbtree *t, const node_t *x, size_t *count) {
+    if (x == t->nil) {
+        return 0;
+    }
+    (*count)++;
+    size_t l = subtree_height(t, x->left, count);
+    size_t r = subtree_height(t, x->right, count);
+    return (l > r ? l : r) + 1;
+}
+
+void rbtree_get_stats(const rbtree *t, rbtree_stats *out) {
+    *out = *t->stats;
+    // 노드 수도 함께 셈. rbtree_split / rbtree_join으로 노드가 트리 사이를 옮겨 가므로 카운터로는 셀 수 없음
+    out->nodes = 0;
+    out->height = subtree_height(t, t->root, &out->nodes);
+    // 트리 구조체 + 통계에 노드 메모리를 더함. 풀 모드는 아직 나눠주지 않은 칸까지 slab 전체가 잡혀 있음
+    // (다른 트리와 함께 가진 slab도 전부 셈). 센티넬은 모든 트리가 함께 쓰는 정적 rbtree_nil이라 세지 않음
+    out->bytes = sizeof(rbtree) + sizeof(rbtree_stats);
+    if (t->pool != NULL) {
+        out->bytes += sizeof(struct node_pool) + t->pool->max_slabs * sizeof(node_slab *);
+        for (size_t i = 0; i < t->pool->n_slabs; i++) {
+            out->bytes += sizeof(node_slab) + t->pool->slabs[i]->capacity * sizeof(node_t);
+        }
+    } else {
+        out->bytes += out->nodes * sizeof(node_t);
+    }
+}
+
+void rbtree_reset_stats(rbtree *t) {
+    memset(t->stats, 0, sizeof(rbtree_stats));
+}
+#endif
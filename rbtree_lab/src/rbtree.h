@@ -9,6 +9,7 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * 헤더파일은 Java의 interface와 유사한가?
@@ -29,14 +30,151 @@ typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
 typedef int key_t;
 
 typedef struct node_t {
+#ifdef RBTREE_COMPACT
+    key_t key;
+#ifdef RBTREE_ORDER_STAT
+    uint32_t size; // 32비트로 줄여 key 옆의 패딩 자리에 넣음 (노드 수 2^32 미만)
+#elif defined(RBTREE_MULTISET)
+    uint32_t count; // size가 없으면 key 옆의 패딩 자리에 넣음
+#endif
+    uintptr_t parent_color; // 부모 노드 주소 | 색. 노드 주소는 8바이트 정렬이라 최하위 비트가 항상 0이므로 거기에 색을 저장
+    struct node_t *left, *right;
+#else
     color_t color;
     key_t key;
     struct node_t *parent, *left, *right;
+#ifdef RBTREE_ORDER_STAT
+    size_t size; // 이 노드를 루트로 하는 서브트리의 노드 수 (nil은 0)
+#endif
+#endif
+#ifdef RBTREE_INTERVAL
+    key_t end;     // 이 노드가 나타내는 구간 [key, end]의 끝 (key <= end)
+    key_t max_end; // 이 노드를 루트로 하는 서브트리에서 가장 큰 end (nil은 INT_MIN)
+#endif
+#if defined(RBTREE_MULTISET) && (!defined(RBTREE_COMPACT) || defined(RBTREE_ORDER_STAT))
+    uint32_t count; // 이 키가 들어 있는 개수 (1 이상, 2^32 미만). COW의 refs와는 8바이트 한 칸을 나눠 씀
+#endif
+#ifdef RBTREE_COW
+    uint32_t refs; // 이 노드를 가리키는 곳의 수 (원본 트리 1 + 스냅샷에만 남은 부모 노드 / 스냅샷 루트)
+#endif
 } node_t;
 
-typedef struct {
+/**
+ * RBTREE_COMPACT : 압축 노드 레이아웃
+ * -DRBTREE_COMPACT로 컴파일하면 color 필드를 없애고 색을 부모 포인터의 최하위 비트에 함께 저장
+ * -> 부모와 색은 반드시 rbtree_parent / rbtree_color로 읽어야 함 (두 레이아웃 모두에서 동작)
+ * 키가 8바이트이거나 RBTREE_ORDER_STAT과 함께 쓸 때 노드가 40바이트에서 32바이트로 줄어듦
+ * int 키만 쓰는 기본 노드는 color와 key가 8바이트 한 칸을 나눠 쓰고 있어 크기 변화가 없음
+ */
+static inline node_t *rbtree_parent(const node_t *x) {
+#ifdef RBTREE_COMPACT
+    return (node_t *)(x->parent_color & ~(uintptr_t)1);
+#else
+    return x->parent;
+#endif
+}
+
+static inline color_t rbtree_color(const node_t *x) {
+#ifdef RBTREE_COMPACT
+    return (color_t)(x->parent_color & 1); // RBTREE_RED = 0, RBTREE_BLACK = 1
+#else
+    return x->color;
+#endif
+}
+
+/**
+ * RBTREE_MULTISET : 중복 키를 개수로 세는 멀티셋 모드
+ * 기본 트리는 같은 키를 넣을 때마다 노드를 하나씩 더 만듦 -> 한 키가 수천 번 들어오면 트리가 그만큼 크고 깊어짐
+ * -DRBTREE_MULTISET로 컴파일하면 키마다 노드는 하나뿐이고 노드의 count에 들어 있는 개수를 셈
+ * - rbtree_insert / rbtree_insert_hint : 같은 키가 있으면 새 노드 없이 그 노드의 count를 1 늘리고 그 노드를 반환
+ * - rbtree_erase / rbtree_erase_key / rbtree_erase_next : count를 1 줄이고, 0이 될 때만 노드를 지움
+ * - rbtree_erase_range : 노드를 통째로 지우고 지운 키 개수(count의 합)를 반환
+ * - rbtree_to_array / rbtree_to_array_par / rbtree_save / rbtree_freeze : 키를 count번 펼쳐 씀 (기본 트리와 같은 결과)
+ * - rbtree_from_sorted / rbtree_load : 연속된 같은 키를 노드 하나로 모음
+ * - rbtree_range / rbtree_foreach_par / rbtree_next : 노드 단위로 방문하므로 개수는 rbtree_key_count로 읽음
+ * - RBTREE_ORDER_STAT의 size는 노드 수가 아니라 count의 합 -> rbtree_select / rbtree_rank도 펼친 배열 기준
+ * count는 4바이트. RBTREE_COMPACT(key 옆)나 RBTREE_COW(refs 옆)에서는 패딩 자리에 들어가 노드가 커지지 않고,
+ * 그 밖의 조합에서는 노드가 8바이트 커짐 -> 같은 키가 평균 두 번 이상 들어오면 노드 수가 줄어드는 쪽이 이득
+ */
+static inline uint32_t rbtree_key_count(const node_t *x) {
+#ifdef RBTREE_MULTISET
+    return x->count;
+#else
+    (void)x;
+    return 1;
+#endif
+}
+
+/**
+ * RBTREE_INTERVAL : 구간 트리(interval tree) 모드
+ * -DRBTREE_INTERVAL로 컴파일하면 노드 하나가 구간 [key, end]를 나타내고, 시작점 key 순서로 정렬됨
+ * 노드마다 서브트리에서 가장 큰 end(max_end)를 저장하고 회전/삽입/삭제/join에서 RBTREE_ORDER_STAT의 size처럼 함께 갱신
+ * -> rbtree_overlap이 max_end가 질의 시작보다 작은 서브트리를 통째로 건너뜀 (rbtree_to_array 후 선형 탐색을 대신함)
+ * - rbtree_insert_interval(t, start, end)로 넣음. rbtree_insert / rbtree_insert_hint / rbtree_from_sorted 등
+ *   키만 받는 함수는 점 구간 [key, key]를 넣음
+ * - rbtree_to_array / rbtree_save / rbtree_freeze는 시작점만 옮기므로 rbtree_load로 되살린 트리는 점 구간이 됨
+ * - 집합 연산과 rbtree_find / rbtree_erase_key는 시작점만 비교 (시작점이 같은 구간은 서로 구분하지 않음)
+ * 노드가 8바이트 커짐. 같은 시작점의 구간도 각각 노드가 되어야 하므로 RBTREE_MULTISET과 함께 쓸 수 없음
+ */
+#if defined(RBTREE_INTERVAL) && defined(RBTREE_MULTISET)
+#error "RBTREE_INTERVAL과 RBTREE_MULTISET은 함께 쓸 수 없음"
+#endif
+
+/**
+ * RBTREE_ORDER_STAT : 순서 통계(order statistic) 모드
+ * -DRBTREE_ORDER_STAT로 컴파일하면 노드마다 서브트리 크기를 저장하고 회전/삽입/삭제에서 함께 갱신함
+ * 노드가 8바이트 커지고 insert/erase마다 경로를 한 번 더 갱신하는 비용이 생기므로 필요할 때만 켬
+ * 라이브러리(rbtree.c)와 사용하는 코드 모두 같은 플래그로 컴파일해야 구조체 모양이 일치함
+ */
+
+// 노드 풀(pool)의 내부 구조는 rbtree.c에만 공개 (불완전 타입으로 선언만 해둠)
+struct node_pool;
+
+// 동시 읽기 모드의 시퀀스 카운터와 읽기 스레드 카운터 (rbtree.c에만 공개)
+struct rbtree_sync;
+
+#ifdef RBTREE_STATS
+/**
+ * RBTREE_STATS : 연산 통계 모드
+ * -DRBTREE_STATS로 컴파일하면 트리마다 아래 카운터를 세고 rbtree_get_stats로 꺼내볼 수 있음
+ * 지연이 튈 때 트리가 깊어서인지(compares/height), 재균형 때문인지(rotations/fixup), 할당 때문인지(mallocs) 구분하는 용도
+ * 끄면(기본) 카운터를 세는 코드가 전부 사라져 비용이 없음
+ * 카운터는 원자적이지 않으므로 여러 스레드가 동시에 읽는 트리에서는 근삿값
+ */
+typedef struct rbtree_stats {
+    uint64_t finds, find_compares;        // rbtree_find 호출 수, 그 동안 비교한 노드 수 (나누면 평균 탐색 깊이)
+    uint64_t inserts, insert_compares;    // rbtree_insert / rbtree_insert_unique 호출 수와 비교한 노드 수
+    uint64_t erases;                      // rbtree_erase 호출 수
+    uint64_t rotations;                   // left_rotate + right_rotate 횟수
+    uint64_t insert_fixups, erase_fixups; // rbtree_fixup / delete_fixup의 while 반복 수
+    uint64_t node_allocs, node_frees;     // 노드를 할당/반납한 횟수 (풀 모드 포함)
+    uint64_t mallocs;                     // 실제 malloc 호출 수 (풀 모드는 slab 하나에 1번)
+    size_t nodes;                         // 현재 노드 수 (get_stats 때 계산)
+    size_t height;                        // 루트에서 가장 깊은 노드까지의 노드 수, 빈 트리는 0 (get_stats 때 계산)
+    size_t bytes;                         // 트리가 잡고 있는 메모리, malloc 자체의 헤더는 제외 (get_stats 때 계산)
+} rbtree_stats;
+#endif
+
+typedef struct rbtree {
     node_t *root;
-    node_t *nil; // for sentinel
+    node_t *nil;            // for sentinel
+    struct node_pool *pool; // NULL이면 노드마다 malloc/free, 아니면 slab 풀에서 할당
+#ifdef RBTREE_STATS
+    rbtree_stats *stats; // rbtree_find처럼 const 트리를 받는 함수에서도 세야 하므로 구조체 밖에 따로 할당
+#endif
+#ifdef RBTREE_CONCURRENT
+    struct rbtree_sync *sync; // 시퀀스 카운터는 쓰기마다 바뀌므로 root/nil과 다른 캐시 라인에 둠
+#endif
+#ifdef RBTREE_FINGER
+    node_t *finger;                    // 마지막으로 삽입한 노드. NULL이면 기억하는 위치가 없음
+    node_t *finger_prev, *finger_next; // finger의 중위 순서 바로 앞/뒤 노드 (없으면 NULL)
+#endif
+#ifdef RBTREE_COW
+    struct rbtree *origin; // 스냅샷이면 원본 트리 (해제한 노드를 반납할 곳), 원본 트리면 NULL
+    size_t snapshots;      // 살아 있는 스냅샷 수. 0이면 공유된 노드가 없으므로 복사 검사를 건너뜀
+    node_t *spare;         // fixup 도중의 복사에 쓰려고 미리 할당해 둔 노드 (left로 연결)
+    size_t n_spare;
+#endif
 } rbtree;
 
 /**
@@ -49,14 +187,66 @@ typedef struct {
  * 어떤 노드의 NULL체크 대신 nil(not in list)이라는 동일한 포인터와 비교.
  * 예외 분기가 줄어들어 코드가 간결하고 안전해짐
  * 모든 NIL은 BLACK이어야 하는 규칙을 센티넬 하나로 충족
+ *
+ * 센티넬은 모든 트리가 함께 쓰는 읽기 전용 노드라 트리마다 할당하지 않음
+ * -> 한 트리의 서브트리를 다른 트리로 그대로 옮길 수 있음 (rbtree_join / rbtree_split)
  */
 
 rbtree *new_rbtree(void);
 void delete_rbtree(rbtree *);
 
+/**
+ * 노드 풀을 사용하는 트리 생성
+ * capacity_hint : 첫 slab에 미리 잡아둘 노드 수 (0이면 기본값)
+ * - 노드는 연속된 slab에서 잘라서 나눠주고, 삭제된 노드는 free list로 재사용
+ * - slab이 가득 차면 이전 slab의 두 배 크기로 새 slab을 붙임
+ * - delete_rbtree는 노드를 하나씩 순회하지 않고 slab 단위로 해제
+ * insert/erase가 잦은 경우 malloc/free 비용과 힙 단편화를 줄여줌
+ */
+rbtree *new_rbtree_with_pool(const size_t capacity_hint);
+
+/**
+ * 오름차순으로 정렬된 arr의 키 n개로 트리를 만듦
+ * - insert를 n번 부르는 대신 가운데 원소를 루트로 삼아 완전히 균형 잡힌 트리를 O(n)에 구성
+ * - 깊이에 따라 색을 칠하므로 회전(fixup)이 한 번도 일어나지 않음
+ * - 노드 n개는 한 번의 할당으로 하나의 slab에 담기고, 반환되는 트리는 노드 풀 모드
+ * arr이 정렬되어 있지 않으면 결과는 올바른 탐색 트리가 아님
+ */
+rbtree *rbtree_from_sorted(const key_t *arr, const size_t n);
+
 node_t *rbtree_insert(rbtree *, const key_t);
 node_t *rbtree_find(const rbtree *, const key_t);
 
+/**
+ * 같은 키가 없을 때만 삽입 (insert-if-absent)
+ * 루트에서 한 번만 내려가며, 같은 키를 만나면 할당 없이 그 노드를 반환
+ * existed가 NULL이 아니면 이미 있었는지(1) 새로 넣었는지(0)를 기록. 할당 실패 시 NULL
+ * -> rbtree_find 후 rbtree_insert를 부르는 두 번의 탐색을 하나로 줄이고 중복 노드도 생기지 않음
+ * RBTREE_MULTISET에서도 이미 있는 키의 count는 늘리지 않음
+ */
+node_t *rbtree_insert_unique(rbtree *, const key_t, int *existed);
+
+/**
+ * 위치 힌트를 받는 삽입
+ * hint는 이 트리의 노드로, key가 hint와 그 바로 앞 또는 뒤 노드 사이에 들어가면 루트부터 내려가지 않고 그 자리에 붙임
+ * 중위 순서로 이웃한 두 노드 중 앞 노드의 오른쪽이나 뒤 노드의 왼쪽은 항상 비어 있으므로 붙일 자리는 바로 정해짐
+ * 이웃 노드는 rbtree_next / rbtree_prev로 구하므로 부모 포인터는 필요할 때만 거슬러 올라감
+ * hint가 NULL이거나 key가 hint 옆에 들어가지 않으면 rbtree_insert와 같이 루트부터 내려감
+ * 같은 키는 rbtree_insert처럼 기존 같은 키들의 뒤에 들어감 (뒤 노드가 같은 키면 루트부터 내려감)
+ * -> 직전에 삽입한 노드를 hint로 넘기면 정렬된/거의 정렬된 키의 삽입이 탐색 없이 fixup만 남음
+ *    (RBTREE_ORDER_STAT에서는 조상들의 size를 늘려야 하므로 여전히 O(log n))
+ */
+node_t *rbtree_insert_hint(rbtree *, node_t *hint, const key_t);
+
+/**
+ * RBTREE_FINGER : 마지막 삽입 위치(finger)를 기억하는 모드
+ * -DRBTREE_FINGER로 컴파일하면 트리가 마지막으로 삽입한 노드와 그 앞뒤 노드를 기억하고,
+ * rbtree_insert / rbtree_insert_unique가 먼저 key가 그 사이에 들어가는지 비교 두 번으로 확인함
+ * -> 오름차순/내림차순, 추가 위주의 키는 hint 없이도 탐색을 건너뛰고 상수 시간에 자리를 찾음
+ *    rbtree_insert_hint에 finger를 넘기면 부모 포인터를 따라 이웃을 구하지 않고 기억한 값을 씀
+ * 기억한 노드를 지우면 잊고 다음 삽입은 루트부터 내려감. 무작위 키에서는 삽입마다 비교 두 번이 늘어남
+ */
+
 /**
  * insert/find에서 const key_t를 받는 이유?
  * key_t는 현재 int이므로 기능적으로는 const가 없어도 동작이 같음
@@ -80,7 +270,269 @@ node_t *rbtree_min(const rbtree *);
 node_t *rbtree_max(const rbtree *);
 int rbtree_erase(rbtree *, node_t *);
 
+/**
+ * key인 노드 하나를 지움 (중복 키면 rbtree_find가 찾는 노드). rbtree_find + rbtree_erase와 달리 한 번만 내려감
+ * 지웠으면 0, 없으면 -1
+ */
+int rbtree_erase_key(rbtree *, const key_t key);
+
+/**
+ * p를 지우고 p의 다음 노드(rbtree_next(t, p)였던 노드)를 반환. p가 최댓값이었거나 지우지 못했으면 NULL
+ * 다음 노드를 다시 찾지 않으므로 훑으면서 지우는 루프가 한 걸음에 분할 상환 O(1)
+ *   for (node_t *p = rbtree_min(t); p != NULL;) p = expired(p) ? rbtree_erase_next(t, p) : rbtree_next(t, p);
+ * RBTREE_MULTISET에서 p의 count가 남았다면 p는 그대로 두고 역시 다음 노드를 반환
+ */
+node_t *rbtree_erase_next(rbtree *, node_t *p);
+
+/**
+ * lo <= key <= hi 인 키를 모두 지우고 지운 개수를 반환 - O(log n + k)
+ * 구간이 크면 트리를 lo와 hi에서 세 조각으로 나눠(split) 가운데를 fixup 없이 통째로 반납하고 나머지 둘을 합침(join)
+ * -> find + erase를 k번 하는 것과 달리 재균형은 한 번뿐. 지운 노드를 가리키던 포인터는 더 이상 쓸 수 없음
+ */
+size_t rbtree_erase_range(rbtree *, const key_t lo, const key_t hi);
+
+/**
+ * 두 트리를 하나로 합침 (join) - O(log n)
+ * t1의 모든 키 <= pivot <= t2의 모든 키여야 하고, 결과는 pivot을 새로 넣은 t1에 담기며 t2는 해제됨
+ * 검정 높이가 큰 쪽의 가장자리를 따라 작은 쪽 높이까지만 내려가 붙이고 삽입 fixup 한 번으로 균형을 복구
+ * -> 키를 하나씩 다시 넣지 않으므로 파티션을 합치거나 옆 shard가 넘긴 구간을 받을 때 O(n)이 들지 않음
+ * 순서가 맞지 않거나, 한쪽만 풀 모드이거나, 스냅샷이 있거나, 할당에 실패하면 -1 (두 트리 모두 그대로)
+ */
+int rbtree_join(rbtree *t1, const key_t pivot, rbtree *t2);
+
+/**
+ * t를 key 미만과 key 이상의 두 트리로 나눔 (split) - O(log n)
+ * key를 찾아 내려간 경로를 아래에서부터 join으로 다시 엮음. 성공하면 *lt는 t 자신(key 미만), *ge는 새 트리
+ * 풀 모드에서는 두 트리가 slab을 참조 수로 함께 가지므로, 어느 쪽을 먼저 지워도 되고 서로 다른 스레드에서 써도 됨
+ * 할당에 실패하거나 스냅샷이 있으면 -1 (t는 그대로)
+ * RBTREE_CONCURRENT : rbtree_join의 t2에는 읽기 스레드가 없어야 하고, rbtree_split은 그 전에 시작한 읽기를 기다림
+ */
+int rbtree_split(rbtree *t, const key_t key, rbtree **lt, rbtree **ge);
+
+/**
+ * 두 트리의 집합 연산. 결과는 t1에 남고 t2는 해제됨 (노드는 복사하지 않고 두 트리의 노드를 그대로 엮음)
+ * - rbtree_union      : t1 + (t1에 없는 키의 t2 노드)
+ * - rbtree_intersect  : t2에도 있는 키의 t1 노드
+ * - rbtree_difference : t2에 없는 키의 t1 노드
+ * 키 단위로 판단하므로 중복 키는 t1 쪽 개수를 그대로 유지 (t1에 없어 합집합에 들어가는 키는 t2 쪽 개수)
+ * t2의 루트로 t1을 split하고 양쪽 절반을 재귀로 연산한 뒤 join으로 엮음 - 크기 m <= n일 때 O(m log(n / m + 1))
+ * 두 재귀는 작업 훔치기 스레드 풀에서 동시에 실행 (스레드 수는 CPU 수, 환경 변수 RBTREE_THREADS로 바꿀 수 있음)
+ * 한쪽만 풀 모드이거나, 스냅샷이 있거나, 할당에 실패하면 -1 (두 트리 모두 그대로)
+ * RBTREE_CONCURRENT : rbtree_join과 같이 t2에는 읽기 스레드가 없어야 함
+ */
+int rbtree_union(rbtree *t1, rbtree *t2);
+int rbtree_intersect(rbtree *t1, rbtree *t2);
+int rbtree_difference(rbtree *t1, rbtree *t2);
+
 int rbtree_to_array(const rbtree *, key_t *, const size_t);
 
+/**
+ * rbtree_to_array / delete_rbtree의 병렬 버전 (집합 연산과 같은 스레드 풀)
+ * 루트 근처에서 트리를 서브트리 수백 개로 잘라 스레드에 나눠줌. 수만 개 이하의 작은 트리는 한 스레드로 처리
+ * - rbtree_to_array_par : 서브트리마다 앞에 오는 노드 수를 먼저 구해 각 스레드가 arr의 자기 구간에 바로 씀
+ *   (RBTREE_ORDER_STAT은 서브트리 크기를 그대로 쓰고, 아니면 세는 패스를 한 번 더 병렬로 돌림)
+ *   결과는 rbtree_to_array와 같고, 스레드가 하나뿐이면 세는 패스 없이 rbtree_to_array를 그대로 부름
+ * - delete_rbtree_par : 서브트리를 스레드마다 따로 해제. 풀 모드는 이미 slab 단위로 해제하므로 delete_rbtree와 같음
+ * 두 함수 모두 rbtree_to_array / delete_rbtree와 같은 조건에서 불러야 함 (쓰기 스레드에서, 다른 쓰기와 겹치지 않게)
+ */
+int rbtree_to_array_par(const rbtree *, key_t *, const size_t);
+void delete_rbtree_par(rbtree *);
+
+/**
+ * 트리의 키를 오름차순으로 fd에 저장 (헤더 + 앞 키와의 차이를 가변 길이 정수로 + 개수와 체크섬)
+ * 앞에서부터 한 번에 써 내려가므로 파일뿐 아니라 파이프/소켓에도 쓸 수 있음. 성공 0, 쓰기 실패 -1
+ * 키가 촘촘하면 키 하나에 1바이트, 32비트 범위에 고르게 퍼진 키 1000만 개는 약 2바이트
+ */
+int rbtree_save(const rbtree *, int fd);
+
+/**
+ * rbtree_save로 저장한 파일(처음부터 끝까지 트리 하나)을 mmap으로 읽어 트리를 만듦
+ * 키가 이미 정렬되어 있으므로 insert를 반복하지 않고 rbtree_from_sorted처럼 O(n)에 균형 트리를 구성 (풀 모드 트리)
+ * 형식이 다르거나, 파일이 잘렸거나, 체크섬이 맞지 않거나, 일반 파일이 아니면 NULL
+ */
+rbtree *rbtree_load(int fd);
+
+/**
+ * 중위 순회 순서의 다음/이전 노드. 없으면 NULL
+ * 부모 포인터를 따라 움직이므로 추가 메모리 없이 트리를 순서대로 걸을 수 있음
+ * for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) { ... }
+ */
+node_t *rbtree_next(const rbtree *, const node_t *);
+node_t *rbtree_prev(const rbtree *, const node_t *);
+
+/**
+ * 가장 가까운 키 찾기. 루트에서 한 번 내려가는 O(log n), 없으면 NULL
+ * - rbtree_lower_bound : key 이상인 첫 노드      - rbtree_upper_bound : key 초과인 첫 노드
+ * - rbtree_floor       : key 이하인 마지막 노드  - rbtree_ceiling     : key 이상인 가장 작은 노드 (= lower_bound)
+ * 중복 키는 lower_bound / upper_bound / ceiling이면 그중 처음, floor이면 마지막 노드
+ * 찾은 노드에서 rbtree_next / rbtree_prev로 이어 걸으면 배열로 옮기지 않고 구간을 훑을 수 있음
+ *   for (node_t *p = rbtree_lower_bound(t, from); p != NULL && p->key < to; p = rbtree_next(t, p)) { ... }
+ */
+node_t *rbtree_lower_bound(const rbtree *, const key_t key);
+node_t *rbtree_upper_bound(const rbtree *, const key_t key);
+node_t *rbtree_floor(const rbtree *, const key_t key);
+node_t *rbtree_ceiling(const rbtree *, const key_t key);
+
+/**
+ * 순회 콜백 타입
+ * 방문한 노드와 호출자가 넘긴 ctx를 받음. 0을 반환하면 계속, 0이 아닌 값을 반환하면 순회를 멈춤
+ */
+typedef int (*rbtree_visit_fn)(node_t *, void *);
+
+/**
+ * lo <= key <= hi 인 노드를 오름차순으로 visit에 넘김
+ * 시작 노드를 찾는 한 번의 탐색 + 구간 안의 k개 방문 -> O(log n + k), 동적 할당 없음
+ */
+int rbtree_range(const rbtree *, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx);
+
+/**
+ * 모든 노드를 여러 스레드에서 나눠 visit에 넘김 (rbtree_to_array_par와 같은 방식으로 나눔)
+ * visit은 여러 스레드에서 동시에 불리므로 ctx를 고칠 때는 스스로 동기화해야 함. 서브트리 안에서만 오름차순
+ * visit이 0이 아닌 값을 돌려주면 다른 스레드도 곧 멈추고 1을 반환 (모두 방문했으면 0)
+ */
+int rbtree_foreach_par(const rbtree *, rbtree_visit_fn visit, void *ctx);
+
+/**
+ * 얼린 트리 : 한 번 만들고 조회만 아주 많이 하는 트리를 위한 읽기 전용 검색 구조
+ * rbtree_find는 노드마다 다른 캐시 라인을 따라가므로 트리가 캐시보다 크면 층마다 캐시 미스가 남
+ * rbtree_freeze는 그 순간의 키를 정렬된 배열 + 캐시 라인(키 16개) 크기 노드의 B+ tree로 옮김
+ * -> 층마다 캐시 라인 한 줄만 읽고 그 안의 키 16개를 SIMD로 한 번에 비교 (키 1000만 개에 6층)
+ * 원본 트리와 메모리를 공유하지 않으므로 만든 뒤 원본을 바꾸거나 지워도 그대로 쓸 수 있음 (메모리는 키당 약 4.3바이트)
+ * 바꿀 수 없으므로 여러 스레드가 락 없이 동시에 읽어도 안전
+ */
+typedef struct rbtree_frozen rbtree_frozen;
+
+// 트리의 키로 얼린 트리를 만듦 - O(n). 실패 시 NULL (RBTREE_CONCURRENT에서는 쓰기 스레드에서만)
+rbtree_frozen *rbtree_freeze(const rbtree *);
+void rbtree_frozen_free(rbtree_frozen *);
+size_t rbtree_frozen_size(const rbtree_frozen *);
+
+// key가 있으면 1, 없으면 0
+int rbtree_frozen_find(const rbtree_frozen *, const key_t);
+
+// key 이상인 첫 키(중복이면 그중 처음). 없으면 NULL
+// 키는 오름차순으로 이어 저장하므로 반환한 포인터 뒤로 다음 키들이 이어짐 (전체는 lower_bound(f, INT_MIN)부터 size개)
+const key_t *rbtree_frozen_lower_bound(const rbtree_frozen *, const key_t);
+
+// 노드가 없는 구조를 위한 순회 콜백. 키와 ctx를 받고, 0이 아닌 값을 반환하면 순회를 멈춤
+typedef int (*rbtree_key_visit_fn)(key_t, void *);
+
+// lo <= key <= hi 인 키를 오름차순으로 visit에 넘김 - O(log n + k)
+int rbtree_frozen_range(const rbtree_frozen *, const key_t lo, const key_t hi, rbtree_key_visit_fn visit, void *ctx);
+
+#ifdef RBTREE_ORDER_STAT
+/**
+ * k번째(0부터 셈)로 작은 키를 가진 노드. k가 노드 수 이상이면 NULL - O(log n)
+ * rbtree_to_array 결과의 arr[k]와 같은 노드
+ */
+node_t *rbtree_select(const rbtree *, size_t k);
+
+// key보다 작은 키의 개수 - O(log n)
+size_t rbtree_rank(const rbtree *, const key_t key);
+#endif
+
+#ifdef RBTREE_INTERVAL
+/**
+ * 구간 [start, end]를 넣고 그 노드를 반환. end < start이거나 할당에 실패하면 NULL
+ * 같은 시작점의 구간은 rbtree_insert의 중복 키처럼 이미 있는 노드들 뒤에 들어감
+ */
+node_t *rbtree_insert_interval(rbtree *, const key_t start, const key_t end);
+
+/**
+ * 구간 [lo, hi]와 겹치는(key <= hi이고 end >= lo인) 노드를 시작점 오름차순으로 visit에 넘김
+ * 중위 순회하면서 max_end < lo인 서브트리는 내려가지 않고, key > hi인 노드를 만나면 멈춤
+ * -> 겹치는 구간이 k개면 그 노드들과 거기까지의 경로만 방문 : 구간 길이가 고르면 O(log n + k),
+ *    긴 구간이 짧은 구간들 사이에 흩어진 최악의 경우 O(log n + k log(n / k))
+ * rbtree_range처럼 동적 할당 없이 스택만 쓰고 부모 포인터를 따라가지 않음 (스냅샷에서도 사용 가능)
+ */
+int rbtree_overlap(const rbtree *, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx);
+#endif
+
+#ifdef RBTREE_STATS
+/**
+ * 현재까지의 통계를 out에 복사
+ * nodes와 height는 모든 노드를 한 번 방문해서 구하므로 O(n) -> 핫 패스가 아니라 진단할 때 부를 것
+ */
+void rbtree_get_stats(const rbtree *, rbtree_stats *out);
+
+// 누적 카운터를 0으로 되돌림
+void rbtree_reset_stats(rbtree *);
+#endif
+
+#ifdef RBTREE_CONCURRENT
+/**
+ * RBTREE_CONCURRENT : 락 없는 동시 읽기 모드 (쓰기 스레드 1개 + 읽기 스레드 여러 개)
+ * -DRBTREE_CONCURRENT로 컴파일하면 rbtree_find / rbtree_min / rbtree_max를 여러 스레드가 락 없이 부를 수 있음
+ *
+ * 시퀀스 락(seqlock)
+ * - 쓰기 스레드는 rbtree_insert / rbtree_insert_unique / rbtree_erase 전체(fixup의 회전 포함)를
+ *   시퀀스 카운터를 홀수로 만든 뒤 수행하고, 끝나면 다시 짝수로 만듦
+ * - 읽기 스레드는 카운터를 읽고 탐색한 뒤 카운터를 다시 읽어서, 홀수였거나 그 사이 바뀌었다면 처음부터 다시 탐색
+ *   -> 읽기 스레드는 쓰기 스레드를 기다리게 하지 않고, 트리 노드와 시퀀스 카운터에는 쓰지 않음
+ *   단, find/min/max는 매번 아래 안전한 해제를 위해 자기 슬롯의 읽기 카운터를 원자적으로 늘렸다 줄임 (RMW 두 번)
+ * - 쓰기 스레드는 자식 포인터와 루트를 원자적 저장(release)으로 바꾸고 읽기 스레드는 acquire로 읽음
+ *   -> 쓰기 도중에 읽어도 데이터 경합이 아니고, 새로 연결된 노드는 초기화를 마친 상태로 보임
+ *
+ * 안전한 해제
+ * - 재시도할 읽기 스레드가 아직 보고 있을 수 있으므로 rbtree_erase는 노드를 바로 해제하지 않고 모아둠
+ * - 일정 개수가 모이면(또는 rbtree_synchronize) 그 전에 시작한 읽기가 모두 끝나기를 기다린 뒤 한꺼번에 해제
+ * - 읽기 스레드는 자기 슬롯의 카운터만 늘렸다 줄임. 슬롯은 캐시 라인마다 하나이고 스레드가 처음 읽을 때
+ *   전역 번호를 슬롯 수(64)로 나눈 나머지로 정해짐 -> 64개가 넘는 스레드는 슬롯(캐시 라인)을 함께 써서 서로 경합함
+ *
+ * 제약
+ * - 쓰기 함수는 한 스레드만 호출해야 함 (쓰기끼리는 호출하는 쪽에서 직렬화)
+ * - rbtree_to_array / rbtree_next / rbtree_prev / rbtree_range / rbtree_select / rbtree_rank는 쓰기 스레드에서만 안전
+ *   (rbtree_lower_bound / rbtree_upper_bound / rbtree_floor / rbtree_ceiling / rbtree_overlap도 마찬가지)
+ * - find/min/max가 반환한 노드는 그 뒤 쓰기 스레드가 지우면 해제될 수 있음
+ *   반환된 노드를 계속 쓰려면 rbtree_read_lock ~ rbtree_read_unlock 사이에서 찾고 사용할 것
+ * - 읽기 구간 안에 있는 스레드는 rbtree_erase / rbtree_synchronize를 부르면 안 됨 (자기 자신을 기다림)
+ */
+
+// 읽기 구간 시작. 반환값을 rbtree_read_unlock에 그대로 넘김. 중첩 가능
+unsigned rbtree_read_lock(const rbtree *);
+void rbtree_read_unlock(const rbtree *, unsigned ticket);
+
+// (쓰기 스레드) 지금까지 지운 노드를, 그 전에 시작한 읽기가 모두 끝나기를 기다린 뒤 해제
+void rbtree_synchronize(rbtree *);
+#endif
+
+#ifdef RBTREE_COW
+#ifdef RBTREE_CONCURRENT
+#error "RBTREE_COW와 RBTREE_CONCURRENT는 함께 쓸 수 없음"
+#endif
+/**
+ * RBTREE_COW : 경로 복사(path copying) 스냅샷 모드
+ * -DRBTREE_COW로 컴파일하면 rbtree_snapshot으로 트리의 그 순간 모습을 O(1)에 얻고,
+ * 원본 트리에 쓰기를 계속하는 동안 다른 스레드가 락 없이 스냅샷을 읽을 수 있음
+ * -> rbtree_to_array로 트리 전체를 복사하던 스냅샷을 대신함
+ *
+ * 동작
+ * - 스냅샷은 루트 포인터만 가진 읽기 전용 트리. 노드는 원본과 공유하고 노드마다 참조 수(refs)를 셈
+ * - 스냅샷이 살아 있는 동안 insert/erase는 바꿀 노드를 제자리에서 고치지 않고,
+ *   루트에서 그 노드까지의 경로(와 fixup이 색을 바꾸거나 회전하는 형제 노드)만 복사해서 고침
+ *   -> 쓰기 한 번에 O(log n)개의 노드만 새로 할당하고, 스냅샷이 보는 노드의 key/left/right/색은 바뀌지 않음
+ * - 스냅샷을 해제하면 참조 수가 0이 된 노드(그 스냅샷만 보던 옛 경로)만 해제
+ * - 스냅샷이 하나도 없으면 복사하지 않으므로 일반 트리와 같게 동작 (노드마다 refs 4바이트만 추가)
+ *
+ * 스냅샷에서 쓸 수 있는 함수
+ * - rbtree_find / rbtree_min / rbtree_max / rbtree_to_array / rbtree_range / rbtree_select / rbtree_rank
+ * - rbtree_lower_bound / rbtree_upper_bound / rbtree_floor / rbtree_ceiling / rbtree_overlap
+ * - rbtree_next / rbtree_prev는 원본 트리 전용 (공유 노드의 부모 포인터는 원본 트리 기준으로 갱신됨)
+ *
+ * 제약
+ * - rbtree_snapshot / rbtree_snapshot_release는 원본 트리의 쓰기와 같은 락 안에서(같은 스레드처럼) 불러야 함
+ *   스냅샷을 읽는 것은 어느 스레드에서든 락 없이 가능
+ * - 스냅샷이 살아 있는 동안 원본 트리에서 얻은 노드 포인터는 다음 쓰기까지만 유효 (그 노드가 복사될 수 있음)
+ * - 스냅샷이 살아 있으면 rbtree_erase도 노드를 할당하므로, 할당에 실패하면 트리를 바꾸지 않고 -1을 반환
+ * - delete_rbtree 전에 모든 스냅샷을 해제해야 함
+ */
+
+// t의 지금 모습을 보는 읽기 전용 스냅샷. O(1), 실패 시 NULL
+const rbtree *rbtree_snapshot(rbtree *t);
+
+// 스냅샷을 해제하고 그 스냅샷만 참조하던 노드를 반납
+void rbtree_snapshot_release(const rbtree *snapshot);
+#endif
+
 // ifndef로 연 블록을 닫는 지점
 #endif // _RBTREE_H_
@@ -0,0 +1,369 @@
+/**
+ * 키를 보지 않는 RB tree 균형 로직 (회전, 삽입/삭제 fixup, 이식, 삭제, 이웃 노드)
+ *
+ * 회전과 fixup은 포인터와 색만 바꾸고 키는 읽지 않음 -> 키 타입이 달라도 같은 코드
+ * rbtree.c(int 키와 모든 모드)와 rbtree_tmpl.h(타입별 트리)가 이 헤더를 include해서 같은 본문을 찍어냄
+ * 균형 로직은 여기 한 곳에만 있고, 두 쪽에는 키 비교가 필요한 탐색과 노드 할당만 남음
+ *
+ * include하기 전에 정의하는 매크로 (끝에서 모두 #undef 하므로 한 파일에서 여러 번 include 가능)
+ *   RBC_TREE, RBC_NODE         트리(root, nil 필드)와 노드(left, right 필드) 타입 (필수)
+ *   RBC_FN(name)               생성할 함수 이름 (필수)
+ *   RBC_PARENT(x)              부모 노드 읽기 (필수)
+ *   RBC_SET_PARENT(x, p)       부모 노드 쓰기 (필수)
+ *   RBC_COLOR(x)               색 읽기. RBC_RED(0) / RBC_BLACK(1) (필수)
+ *   RBC_SET_COLOR(x, c)        색 쓰기 (필수)
+ *   RBC_AUGMENT(x)             자식이 바뀐 x의 부가 정보를 다시 계산 (생략 시 없음)
+ *   RBC_AUGMENT_PATH(t, x)     x부터 루트까지 부가 정보를 다시 계산 (생략 시 없음)
+ *   RBC_OWN(t, x)              x를 고치기 전에 이 트리 전용으로 만든 노드 (생략 시 x. 스냅샷 모드의 경로 복사)
+ *   RBC_STAT(t, field)         통계 카운터 하나 증가 (생략 시 없음)
+ *   RBC_SET_LINK(p, field, v)  자식 포인터(left/right)나 루트를 씀. p->field = v (생략 시 그냥 대입)
+ *                              락 없이 읽는 스레드가 있는 모드는 원자적 저장으로 바꿈
+ *
+ * nil에는 아무것도 쓰지 않음 (여러 트리가 nil 하나를 함께 쓸 수 있음)
+ * -> 삭제 fixup은 x가 nil일 때도 부모를 알 수 있도록 부모를 따로 들고 다님
+ */
+
+#define RBC_RED 0 // rbtree.h의 RBTREE_RED / RBTREE_BLACK과 같은 값
+#define RBC_BLACK 1
+
+#ifndef RBC_AUGMENT
+#define RBC_AUGMENT(x) ((void)0)
+#endif
+#ifndef RBC_AUGMENT_PATH
+#define RBC_AUGMENT_PATH(t, x) ((void)0)
+#endif
+#ifndef RBC_OWN
+#define RBC_OWN(t, x) (x)
+#endif
+#ifndef RBC_STAT
+#define RBC_STAT(t, field) ((void)0)
+#endif
+#ifndef RBC_SET_LINK
+#define RBC_SET_LINK(p, field, v) ((p)->field = (v))
+#endif
+
+/**
+ * sentinel 방식만을 사용하는 구현
+ * 상황 가정
+ * x의 부모가 p
+ * x의 right(오른쪽 자식)이 y, left가 A
+ * y의 왼쪽 자식이 B, 오른쪽 자식이 C
+ * x의 오른쪽 자식 y를 x 자리로 끌어올리고, x를 y의 왼쪽 자식으로 보내는 좌회전
+ */
+static inline void RBC_FN(left_rotate)(RBC_TREE *t, RBC_NODE *x) {
+    RBC_STAT(t, rotations);
+    RBC_NODE *y = x->right;          // 1. y는 x의 오른쪽 자식
+    RBC_SET_LINK(x, right, y->left); // 2. x의 오른쪽 자식을 y가 아닌 y의 왼쪽 자식인 B로 변경
+    if (y->left != t->nil) {         // 3. 만약 y의 왼쪽 자식 B가 존재한다면 (nil이 아니라면)
+        RBC_SET_PARENT(y->left, x);  // 4. y 왼쪽 자식 B의 부모는 x가 됨
+    }
+
+    RBC_SET_PARENT(y, RBC_PARENT(x));          // 5. y의 부모를 x의 부모로 변경
+    if (RBC_PARENT(x) == t->nil) {             // 6. 만약 x 자신이 트리의 루트라면 ()
+        RBC_SET_LINK(t, root, y);              // 7. 트리의 루트는 y가 됨
+    } else if (x == RBC_PARENT(x)->left) {     // 8. 만약 x의 부모의 left가 x라면 (x가 왼쪽 자식이라면)
+        RBC_SET_LINK(RBC_PARENT(x), left, y);  // 9. 기존 x 부모의 왼쪽 자식을 y로 변경
+    } else {                                   // 10. x가 부모의 오른쪽 자식이었다면
+        RBC_SET_LINK(RBC_PARENT(x), right, y); // 11. x 부모 오른쪽이 y가 됨
+    }
+
+    RBC_SET_LINK(y, left, x); // 12. y의 왼쪽 자식을 x로 변경
+    RBC_SET_PARENT(x, y);     // 13. x의 부모를 y로 변경
+
+    RBC_AUGMENT(x); // 14. 아래로 내려간 x를 먼저, 그 위의 y를 다음으로 부가 정보 갱신
+    RBC_AUGMENT(y);
+}
+
+/**
+ * sentinel 방식만을 사용하는 구현 (우회전)
+ * 상황 가정
+ * y의 부모가 p
+ * y의 left(왼쪽 자식)이 x, right가 C
+ * x의 왼쪽 자식이 A, 오른쪽 자식이 B
+ * y의 왼쪽 자식 x를 y 자리로 끌어올리고, y를 x의 오른쪽 자식으로 보내는 우회전
+ */
+static inline void RBC_FN(right_rotate)(RBC_TREE *t, RBC_NODE *y) {
+    RBC_STAT(t, rotations);
+    RBC_NODE *x = y->left;           // 1. x는 y의 왼쪽 자식
+    RBC_SET_LINK(y, left, x->right); // 2. y의 왼쪽 자식을 x의 오른쪽 자식 B로 변경
+    if (x->right != t->nil)          // 3. 만약 x의 오른쪽 자식 B가 존재한다면 (nil이 아니라면)
+        RBC_SET_PARENT(x->right, y); // 4. B의 부모는 y가 됨
+
+    RBC_SET_PARENT(x, RBC_PARENT(y));          // 5. x의 부모를 y의 부모로 변경 (x가 y의 자리로 승격)
+    if (RBC_PARENT(y) == t->nil) {             // 6. y 자신이 트리의 루트라면
+        RBC_SET_LINK(t, root, x);              // 7. 트리의 루트는 x가 됨
+    } else if (y == RBC_PARENT(y)->left) {     // 8. y가 부모의 왼쪽 자식이었다면
+        RBC_SET_LINK(RBC_PARENT(y), left, x);  // 9. 부모의 왼쪽 자식을 x로 변경
+    } else {                                   // 10. y가 부모의 오른쪽 자식이었다면
+        RBC_SET_LINK(RBC_PARENT(y), right, x); // 11. 부모의 오른쪽 자식을 x로 변경
+    }
+
+    RBC_SET_LINK(x, right, y); // 12. x의 오른쪽 자식을 y로 변경
+    RBC_SET_PARENT(y, x);      // 13. y의 부모를 x로 변경
+
+    RBC_AUGMENT(y); // 14. 아래로 내려간 y를 먼저, 그 위의 x를 다음으로 부가 정보 갱신
+    RBC_AUGMENT(x);
+}
+
+// 삽입 이후 rbtree가 규칙을 위반하지 않도록 복구
+// RED가 된 루트를 BLACK으로 바꿨다면(트리의 검정 높이가 1 늘었다면) 1을 반환
+static inline int RBC_FN(insert_fixup)(RBC_TREE *t, RBC_NODE *z) {
+    // 삽입된 노드의 부모가 RED인 경우만 반복. 부모가 BLACK이어야 규칙 4를 위반x
+    while (RBC_COLOR(RBC_PARENT(z)) == RBC_RED) {
+        RBC_STAT(t, insert_fixups);
+        if (RBC_PARENT(z) == RBC_PARENT(RBC_PARENT(z))->left) { // z의 부모가 z의 조부모의 왼쪽 자식이라면
+            RBC_NODE *y = RBC_PARENT(RBC_PARENT(z))->right;     // 삼촌을 확인해야 함
+            // Case 1 : z 삼촌의 색이 RED라면 -> 부모, 삼촌 둘 다 RED
+            if (RBC_COLOR(y) == RBC_RED) {
+                // z 조부모와 그 자식들의 색을 바꾼 후 문제를 위로 올림
+                RBC_SET_COLOR(RBC_PARENT(z), RBC_BLACK);            // 1. z 부모의 색 BLACK
+                RBC_SET_COLOR(RBC_OWN(t, y), RBC_BLACK);            // 2. z 삼촌의 색 BLACK (삼촌은 경로 밖)
+                RBC_SET_COLOR(RBC_PARENT(RBC_PARENT(z)), RBC_RED); // 3. z 조부모의 색 RED
+                z = RBC_PARENT(RBC_PARENT(z));                      // 4. 조부모부터 다시 검사
+            } else {                                                // z 삼촌의 색이 BLACK
+                // Case 2 : z가 zp의 오른쪽 자식일 경우
+                if (z == RBC_PARENT(z)->right) {
+                    z = RBC_PARENT(z); // 회전 축을 z에서 z의 부모로 변경
+                    // 윗줄이 잘 이해가 안갔음. left rotate시 z의 부모가 원래 z가 있어야 할 자리로 가기 때문에
+                    // z를 z->parent로 변경해주어야 올바른 case 3으로 시작할 수 있게 되는 거였다.
+                    RBC_FN(left_rotate)(t, z); // 좌회전하여 case 3으로 만들기
+                }
+                // Case 3 : z가 z 부모의 왼쪽 자식
+                RBC_SET_COLOR(RBC_PARENT(z), RBC_BLACK);            // 1. z의 부모를 black
+                RBC_SET_COLOR(RBC_PARENT(RBC_PARENT(z)), RBC_RED); // 2. z의 조부모를 red
+                RBC_FN(right_rotate)(t, RBC_PARENT(RBC_PARENT(z))); // 3. z의 조부모를 기준으로 right rotate
+                // -> RED-RED 인접이 해소되고 Black-height가 유지됨
+            }
+        } else {                                           // 대칭 케이스 : 부모가 조부모의 오른쪽 자식
+            RBC_NODE *y = RBC_PARENT(RBC_PARENT(z))->left; // 삼촌은 조부모의 왼쪽
+            // Case 1
+            if (RBC_COLOR(y) == RBC_RED) {
+                RBC_SET_COLOR(RBC_PARENT(z), RBC_BLACK);
+                RBC_SET_COLOR(RBC_OWN(t, y), RBC_BLACK);
+                RBC_SET_COLOR(RBC_PARENT(RBC_PARENT(z)), RBC_RED);
+                z = RBC_PARENT(RBC_PARENT(z));
+            } else {
+                // Case 2
+                if (z == RBC_PARENT(z)->left) {
+                    z = RBC_PARENT(z);
+                    RBC_FN(right_rotate)(t, z);
+                }
+                // Case 3
+                RBC_SET_COLOR(RBC_PARENT(z), RBC_BLACK);
+                RBC_SET_COLOR(RBC_PARENT(RBC_PARENT(z)), RBC_RED);
+                RBC_FN(left_rotate)(t, RBC_PARENT(RBC_PARENT(z)));
+            }
+        }
+    }
+    const int grew = RBC_COLOR(t->root) == RBC_RED;
+    RBC_SET_COLOR(t->root, RBC_BLACK); // 루트의 색은 항상 BLACK
+    return grew;
+}
+
+/**
+ * 중위 순서로 바로 이웃한 prev와 next 사이에 z를 자식으로 붙이고 그 부모를 반환 (NULL은 z가 처음/끝이라는 뜻)
+ * prev에 오른쪽 자식이 없으면 그 자리가 z의 자리
+ * 있다면 next는 그 오른쪽 서브트리의 최솟값이므로 next의 왼쪽이 비어 있음 -> 루트부터 내려가지 않고 바로 붙임
+ * prev <= z < next 이므로 어느 쪽에 붙여도 탐색 트리 조건이 유지됨. 균형은 호출한 쪽이 insert_fixup으로 복구
+ */
+static inline RBC_NODE *RBC_FN(link_between)(RBC_TREE *t, RBC_NODE *z, RBC_NODE *prev, RBC_NODE *next) {
+    RBC_NODE *y;
+    if (prev != NULL && prev->right == t->nil) {
+        y = prev;
+        RBC_SET_LINK(y, right, z);
+    } else if (next != NULL) {
+        y = next;
+        RBC_SET_LINK(y, left, z);
+    } else { // 빈 트리
+        y = t->nil;
+        RBC_SET_LINK(t, root, z);
+    }
+    RBC_SET_PARENT(z, y);
+    return y;
+}
+
+// 서브트리에서 successor 찾기 (오른쪽 서브트리 중 가장 작은 값)
+static inline RBC_NODE *RBC_FN(subtree_min)(const RBC_TREE *t, RBC_NODE *x) {
+    while (x->left != t->nil) { // 왼쪽 끝까지 내려가며 최소 찾기
+        x = x->left;
+    }
+    return x;
+}
+
+// 서브트리에서 가장 큰 값 (오른쪽 끝)
+static inline RBC_NODE *RBC_FN(subtree_max)(const RBC_TREE *t, RBC_NODE *x) {
+    while (x->right != t->nil) {
+        x = x->right;
+    }
+    return x;
+}
+
+// 중위 순회 기준 다음 노드(successor)
+// 1. 오른쪽 서브트리가 있으면 그 중 가장 작은 노드
+// 2. 없으면 부모를 따라 올라가다가 처음으로 '왼쪽 자식에서 올라온' 순간의 부모
+static inline RBC_NODE *RBC_FN(successor)(const RBC_TREE *t, const RBC_NODE *x) {
+    if (x->right != t->nil) {
+        return RBC_FN(subtree_min)(t, x->right);
+    }
+    RBC_NODE *p = RBC_PARENT(x);
+    while (p != t->nil && x == p->right) {
+        x = p;
+        p = RBC_PARENT(p);
+    }
+    return p == t->nil ? NULL : p; // 루트까지 올라왔다면 x가 최댓값이었던 것
+}
+
+// 중위 순회 기준 이전 노드(predecessor) - successor의 좌우 대칭
+static inline RBC_NODE *RBC_FN(predecessor)(const RBC_TREE *t, const RBC_NODE *x) {
+    if (x->left != t->nil) {
+        return RBC_FN(subtree_max)(t, x->left);
+    }
+    RBC_NODE *p = RBC_PARENT(x);
+    while (p != t->nil && x == p->left) {
+        x = p;
+        p = RBC_PARENT(p);
+    }
+    return p == t->nil ? NULL : p;
+}
+
+// u의 자리에 v를 이식. nil은 모든 트리가 함께 쓰므로 v가 nil이면 부모를 적지 않음
+static inline void RBC_FN(transplant)(RBC_TREE *t, RBC_NODE *u, RBC_NODE *v) {
+    if (RBC_PARENT(u) == t->nil) { // u가 루트였다면
+        RBC_SET_LINK(t, root, v);
+    } else if (u == RBC_PARENT(u)->left) { // u가 왼쪽 자식이었다면
+        RBC_SET_LINK(RBC_PARENT(u), left, v);
+    } else { // u가 오른쪽 자식이었다면
+        RBC_SET_LINK(RBC_PARENT(u), right, v);
+    }
+    if (v != t->nil) {
+        RBC_SET_PARENT(v, RBC_PARENT(u)); // 부모 갱신
+    }
+}
+
+// 삭제 후 doubly black을 해소
+// x는 검정 높이를 보전해야하는 자리, xp는 x의 부모
+// x가 nil이면 nil->parent로 부모를 알 수 없으므로(공용 센티넬이라 쓰지 않음) 부모를 따로 들고 다님
+static inline void RBC_FN(delete_fixup)(RBC_TREE *t, RBC_NODE *x, RBC_NODE *xp) {
+    // 스냅샷 모드 : 색을 바꾸거나 회전하는 노드 중 삭제 경로 밖의 것(x, 형제, 조카)은 바꾸기 전에 RBC_OWN
+    x = RBC_OWN(t, x);
+    // x가 루트가 아니고, x가 검정일 때만 반복
+    while (x != t->root && RBC_COLOR(x) == RBC_BLACK) {
+        RBC_STAT(t, erase_fixups);
+        if (x == xp->left) {                     // x가 왼쪽 자식일 경우 (x가 nil이어도 형제는 nil이 아니므로 구분됨)
+            RBC_NODE *w = RBC_OWN(t, xp->right); // x의 형제 w
+            // Case 1 : 형제가 RED
+            if (RBC_COLOR(w) == RBC_RED) {
+                RBC_SET_COLOR(w, RBC_BLACK); // 형제를 BLACK
+                RBC_SET_COLOR(xp, RBC_RED);  // 부모를 RED
+                RBC_FN(left_rotate)(t, xp);  // 부모 기준 좌회전으로 검정 형제의 상황 만들기
+                w = RBC_OWN(t, xp->right);   // 새로운 형제 갱신 (x의 부모는 그대로 xp)
+            }
+
+            // 여기부터는 형제가 BLACK
+            // Case 2 : 형제의 두 자식 모두 BLACK -> 형제를 RED로 칠하고 부모로 extra-black을 올려보냄
+            if (RBC_COLOR(w->left) == RBC_BLACK && RBC_COLOR(w->right) == RBC_BLACK) {
+                RBC_SET_COLOR(w, RBC_RED);
+                x = xp;
+                xp = RBC_PARENT(x);
+            } else {
+                if (RBC_COLOR(w->right) == RBC_BLACK) {
+                    // Case 3 : 형제의 오른쪽 자식이 BLACK, 왼쪽 자식이 RED
+                    RBC_SET_COLOR(RBC_OWN(t, w->left), RBC_BLACK); // 왼쪽 자식을 BLACK
+                    RBC_SET_COLOR(w, RBC_RED);                     // 형제는 RED
+                    RBC_FN(right_rotate)(t, w); // 형제 기준 우회전으로 Case 4를 만들고 Case 4로 해결
+                    w = xp->right;              // 형제 갱신
+                }
+                // Case 4 : 형제의 오른쪽 자식이 RED
+                RBC_SET_COLOR(w, RBC_COLOR(xp));                // 형제는 부모의 색을 물려받음
+                RBC_SET_COLOR(xp, RBC_BLACK);                   // 부모는 BLACK
+                RBC_SET_COLOR(RBC_OWN(t, w->right), RBC_BLACK); // 형제의 오른쪽 자식을 BLACK
+                RBC_FN(left_rotate)(t, xp);                     // 부모 기준 좌회전
+                x = t->root; // 이거 왜하냐 -> while문 종료의 break의 역할임. Case 4가 해결되면 무조건 해결됨
+            }
+        } else { // 대칭 : x가 오른쪽 자식인 경우
+            RBC_NODE *w = RBC_OWN(t, xp->left);
+            // Case 1
+            if (RBC_COLOR(w) == RBC_RED) {
+                RBC_SET_COLOR(w, RBC_BLACK);
+                RBC_SET_COLOR(xp, RBC_RED);
+                RBC_FN(right_rotate)(t, xp);
+                w = RBC_OWN(t, xp->left);
+            }
+            // Case 2
+            if (RBC_COLOR(w->right) == RBC_BLACK && RBC_COLOR(w->left) == RBC_BLACK) {
+                RBC_SET_COLOR(w, RBC_RED);
+                x = xp;
+                xp = RBC_PARENT(x);
+            } else {
+                // Case 3
+                if (RBC_COLOR(w->left) == RBC_BLACK) {
+                    RBC_SET_COLOR(RBC_OWN(t, w->right), RBC_BLACK);
+                    RBC_SET_COLOR(w, RBC_RED);
+                    RBC_FN(left_rotate)(t, w);
+                    w = xp->left;
+                }
+                // Case 4
+                RBC_SET_COLOR(w, RBC_COLOR(xp));
+                RBC_SET_COLOR(xp, RBC_BLACK);
+                RBC_SET_COLOR(RBC_OWN(t, w->left), RBC_BLACK);
+                RBC_FN(right_rotate)(t, xp);
+                x = t->root;
+            }
+        }
+    }
+    if (x != t->nil) {                // 트리가 비었을 때만 x가 nil로 남음
+        RBC_SET_COLOR(x, RBC_BLACK); // x는 삭제 노드를 대체하게된 노드. 이것을 BLACK으로 설정하여 규칙 2, 4를 해결
+    }
+}
+
+// z를 트리에서 떼어내고 균형을 복구 (z는 해제하지 않음)
+static inline void RBC_FN(erase_node)(RBC_TREE *t, RBC_NODE *z) {
+    RBC_NODE *y = z;                    // 트리에서 제거될 노드
+    int y_origin_color = RBC_COLOR(y);  // 제거되는 노드의 원래 색
+    RBC_NODE *x;                        // y를 치환하고 남는 자리
+    RBC_NODE *xp = RBC_PARENT(z);       // x의 부모 = 구조가 바뀐 가장 아래 노드 -> 여기부터 위로 부가 정보 갱신
+
+    if (z->left == t->nil) {                // 왼쪽 자식이 없는 경우
+        x = z->right;                       // z 자리를 z->right로 매움
+        RBC_FN(transplant)(t, z, z->right); // z 위치에 z의 오른쪽 자식을 이식
+    } else if (z->right == t->nil) {        // 오른쪽 자식이 없는 경우
+        x = z->left;
+        RBC_FN(transplant)(t, z, z->left);
+    } else {                                   // 자식이 둘 다 있는 경우
+        y = RBC_FN(subtree_min)(t, z->right); // 후계자 찾기
+        y_origin_color = RBC_COLOR(y);         // 기존 색깔 저장
+        x = y->right;                          // x가 삭제된 노드의 대체가 되기때문에 y->right로하면 nil이나
+        if (RBC_PARENT(y) == z) {              // y의 부모가 z라면 -> 바로 오른쪽 자식이 최소, x는 그대로 y 아래
+            xp = y;
+        } else {
+            xp = RBC_PARENT(y);
+            RBC_FN(transplant)(t, y, y->right);
+            RBC_SET_LINK(y, right, z->right);
+            RBC_SET_PARENT(y->right, y);
+        }
+        RBC_FN(transplant)(t, z, y); // y가 대체되었으니 왼쪽 오른쪽을 올바르게 이어주기
+        RBC_SET_LINK(y, left, z->left);
+        RBC_SET_PARENT(y->left, y);
+        RBC_SET_COLOR(y, RBC_COLOR(z));
+    }
+    RBC_AUGMENT_PATH(t, xp);
+
+    if (y_origin_color == RBC_BLACK) {
+        RBC_FN(delete_fixup)(t, x, xp);
+    }
+}
+
+#undef RBC_TREE
+#undef RBC_NODE
+#undef RBC_FN
+#undef RBC_PARENT
+#undef RBC_SET_PARENT
+#undef RBC_COLOR
+#undef RBC_SET_COLOR
+#undef RBC_AUGMENT
+#undef RBC_AUGMENT_PATH
+#undef RBC_OWN
+#undef RBC_STAT
+#undef RBC_SET_LINK
+#undef RBC_RED
+#undef RBC_BLACK
@@ -0,0 +1,368 @@
+/**
+ * 키 타입별로 특수화된 rbtree를 찍어내는 템플릿 헤더
+ *
+ * rbtree.h의 트리는 key_t가 int로 고정되어 있음
+ * 이 헤더는 include하기 직전에 정의한 매크로로 키 타입/비교 함수/값 타입을 받아 그 타입 전용 트리를 만들어냄
+ * -> C에는 C++의 template이 없으므로 전처리기로 "타입만 바꾼 코드"를 생성하는 방식
+ *
+ * 사용법
+ *   #define RBT_NAME rbtree_u64            // 생성될 타입/함수 이름의 접두어 (필수)
+ *   #define RBT_KEY uint64_t               // 키 타입 (필수)
+ *   #define RBT_CMP(a, b) strcmp((a), (b)) // 3-way 비교: a<b 음수, a==b 0, a>b 양수 (생략 시 <, == 연산자)
+ *   #define RBT_VALUE void *               // 노드에 함께 저장할 값 타입 (생략 시 void *)
+ *   #include "rbtree_tmpl.h"
+ *
+ * 생성되는 것 (RBT_NAME이 rbtree_u64일 때)
+ *   rbtree_u64, rbtree_u64_node 타입
+ *   rbtree_u64_new / _delete / _insert / _insert_unique / _upsert / _insert_hint / _find / _lower_bound
+ *   / _upper_bound / _erase / _erase_key / _erase_next / _min / _max / _next / _prev / _to_array
+ *   (rbtree.h의 같은 이름 함수와 같은 동작. 삽입 함수는 value를 함께 받음)
+ *
+ * 회전, fixup, 삭제, 이웃 노드 찾기는 키를 보지 않으므로 rbtree.c와 같은 rbtree_core.h의 본문을 이 타입으로 찍어냄
+ * -> 이 헤더에 있는 것은 키를 비교하며 내려가는 탐색과 노드 할당뿐. 균형 로직을 고치면 두 트리에 함께 반영됨
+ *
+ * 비교가 함수 포인터가 아니라 매크로로 그 자리에 펼쳐지므로 정수 키는 비교 명령 하나로 인라인됨
+ * 정수처럼 <, ==가 되는 키는 RBT_CMP를 생략하고, 문자열처럼 비교가 비싼 키만 RBT_CMP를 정의하는 것이 빠름
+ * 함수는 모두 static inline이라 여러 소스 파일에서 include해도 링크 충돌이 없고, 쓰지 않는 함수는 경고 없이 사라짐
+ * 한 파일에서 매크로를 바꿔가며 여러 번 include할 수 있음 (끝에서 RBT_* 매크로를 모두 #undef)
+ *
+ * 노드는 rbtree.c의 RBTREE_COMPACT 레이아웃과 같이 색을 부모 포인터의 최하위 비트에 저장
+ * -> 8바이트 키 + 8바이트 값이어도 노드는 40바이트
+ * 문자열 같은 포인터 키는 포인터만 저장하므로, 키가 가리키는 메모리는 노드가 살아있는 동안 호출자가 유지해야 함
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef RBT_NAME
+#error "rbtree_tmpl.h: RBT_NAME을 정의한 뒤 include 해야 함"
+#endif
+#ifndef RBT_KEY
+#error "rbtree_tmpl.h: RBT_KEY를 정의한 뒤 include 해야 함"
+#endif
+#ifdef RBT_CMP
+#define RBT_LT(a, b) (RBT_CMP((a), (b)) < 0)
+#else
+#define RBT_LT(a, b) ((a) < (b)) // 비교 함수가 없으면 키 타입의 <, == 연산자를 그대로 사용
+#endif
+#ifndef RBT_VALUE
+#define RBT_VALUE void *
+#endif
+
+// 이름 이어붙이기 도우미. 한 단계 더 거쳐야 RBT_NAME이 먼저 펼쳐진 뒤 ##로 붙음
+#ifndef RBT_CAT
+#define RBT_CAT_(a, b) a##_##b
+#define RBT_CAT(a, b) RBT_CAT_(a, b)
+#endif
+
+#define RBT_TREE RBT_NAME
+#define RBT_NODE RBT_CAT(RBT_NAME, node)
+#define RBT_FN(suffix) RBT_CAT(RBT_NAME, suffix)
+
+typedef struct RBT_NODE {
+    RBT_KEY key;
+    RBT_VALUE value;
+    uintptr_t parent_color; // 부모 노드 주소 | 색 (최하위 비트, 0 = RED, 1 = BLACK)
+    struct RBT_NODE *left, *right;
+} RBT_NODE;
+
+typedef struct {
+    RBT_NODE *root;
+    RBT_NODE *nil; // for sentinel
+} RBT_TREE;
+
+static inline RBT_NODE *RBT_FN(parent)(const RBT_NODE *x) {
+    return (RBT_NODE *)(x->parent_color & ~(uintptr_t)1);
+}
+
+static inline int RBT_FN(is_black)(const RBT_NODE *x) {
+    return (int)(x->parent_color & 1);
+}
+
+static inline void RBT_FN(set_parent)(RBT_NODE *x, RBT_NODE *p) {
+    x->parent_color = (uintptr_t)p | (x->parent_color & 1);
+}
+
+static inline void RBT_FN(set_black)(RBT_NODE *x, const int black) {
+    x->parent_color = (x->parent_color & ~(uintptr_t)1) | (uintptr_t)(black != 0);
+}
+
+// 균형 로직 : rbtree.c와 같은 본문을 이 노드 타입으로 생성 (RBT_FN(left_rotate), RBT_FN(insert_fixup), ...)
+#define RBC_TREE RBT_TREE
+#define RBC_NODE RBT_NODE
+#define RBC_FN(name) RBT_FN(name)
+#define RBC_PARENT(x) RBT_FN(parent)(x)
+#define RBC_SET_PARENT(x, p) RBT_FN(set_parent)((x), (p))
+#define RBC_COLOR(x) RBT_FN(is_black)(x)
+#define RBC_SET_COLOR(x, c) RBT_FN(set_black)((x), (c))
+#include "rbtree_core.h"
+
+static inline RBT_TREE *RBT_FN(new)(void) {
+    RBT_TREE *t = (RBT_TREE *)calloc(1, sizeof(RBT_TREE));
+    if (t == NULL) {
+        return NULL;
+    }
+    RBT_NODE *nil = (RBT_NODE *)calloc(1, sizeof(RBT_NODE));
+    if (nil == NULL) {
+        free(t);
+        return NULL;
+    }
+    nil->left = nil->right = nil;
+    nil->parent_color = 1; // 색은 BLACK. 부모는 읽지 않으므로 NULL
+    t->nil = nil;
+    t->root = nil;
+    return t;
+}
+
+// 회전으로 트리를 한 줄로 펴가며 해제 (rbtree.c의 free_subtree와 같은 방식, 스택 사용 없음)
+static inline void RBT_FN(delete)(RBT_TREE *t) {
+    if (t == NULL) {
+        return;
+    }
+    RBT_NODE *x = t->root;
+    while (x != t->nil) {
+        if (x->left == t->nil) {
+            RBT_NODE *next = x->right;
+            free(x);
+            x = next;
+        } else {
+            RBT_NODE *y = x->left;
+            x->left = y->right;
+            y->right = x;
+            x = y;
+        }
+    }
+    free(t->nil);
+    free(t);
+}
+
+// key/value를 가진 RED 노드 하나를 할당 (아직 트리에 연결하지 않음). 실패 시 NULL
+static inline RBT_NODE *RBT_FN(node_new)(const RBT_TREE *t, RBT_KEY key, RBT_VALUE value) {
+    RBT_NODE *z = (RBT_NODE *)malloc(sizeof(RBT_NODE));
+    if (z == NULL) {
+        return NULL;
+    }
+    z->key = key;
+    z->value = value;
+    z->left = z->right = t->nil;
+    z->parent_color = 0; // RED (최하위 비트 0)
+    return z;
+}
+
+// z를 탐색이 멈춘 y의 자식으로 붙이고 균형을 복구 (y가 nil이면 빈 트리의 루트)
+static inline RBT_NODE *RBT_FN(link)(RBT_TREE *t, RBT_NODE *z, RBT_NODE *y, const int less) {
+    RBT_FN(set_parent)(z, y);
+    if (y == t->nil) {
+        t->root = z;
+    } else if (less) {
+        y->left = z;
+    } else {
+        y->right = z;
+    }
+    RBT_FN(insert_fixup)(t, z);
+    return z;
+}
+
+// key/value를 가진 노드를 추가 (같은 키가 있으면 그 뒤에 하나 더 추가하는 multiset 동작)
+static inline RBT_NODE *RBT_FN(insert)(RBT_TREE *t, RBT_KEY key, RBT_VALUE value) {
+    RBT_NODE *z = RBT_FN(node_new)(t, key, value);
+    if (z == NULL) {
+        return NULL;
+    }
+    RBT_NODE *x = t->root;
+    RBT_NODE *y = t->nil;
+    int less = 0;
+    while (x != t->nil) {
+        y = x;
+        less = RBT_LT(key, x->key);
+        x = less ? x->left : x->right;
+    }
+    return RBT_FN(link)(t, z, y, less);
+}
+
+// 같은 키가 없을 때만 삽입. 있으면 할당 없이 기존 노드를 반환 (값은 건드리지 않음)
+// 탐색은 루트에서 한 번만. existed가 NULL이 아니면 이미 있었는지(1) 새로 넣었는지(0) 기록
+static inline RBT_NODE *RBT_FN(insert_unique)(RBT_TREE *t, RBT_KEY key, RBT_VALUE value, int *existed) {
+    RBT_NODE *x = t->root;
+    RBT_NODE *y = t->nil;
+    int less = 0;
+    while (x != t->nil) {
+#ifdef RBT_CMP
+        int c = RBT_CMP(key, x->key);
+        if (c == 0) {
+            break;
+        }
+        less = c < 0;
+#else
+        if (key == x->key) {
+            break;
+        }
+        less = key < x->key;
+#endif
+        y = x;
+        x = less ? x->left : x->right;
+    }
+    if (existed != NULL) {
+        *existed = x != t->nil;
+    }
+    if (x != t->nil) {
+        return x;
+    }
+    RBT_NODE *z = RBT_FN(node_new)(t, key, value);
+    return z == NULL ? NULL : RBT_FN(link)(t, z, y, less);
+}
+
+// key가 있으면 그 노드의 값을 value로 바꾸고, 없으면 새로 삽입 - 탐색 한 번
+static inline RBT_NODE *RBT_FN(upsert)(RBT_TREE *t, RBT_KEY key, RBT_VALUE value) {
+    int existed;
+    RBT_NODE *x = RBT_FN(insert_unique)(t, key, value, &existed);
+    if (x != NULL && existed) {
+        x->value = value;
+    }
+    return x;
+}
+
+// 위치 힌트를 받는 삽입 (rbtree_insert_hint와 같음). key가 hint와 그 이웃 사이가 아니면 insert처럼 루트부터
+// 같은 키는 insert처럼 기존 같은 키들의 뒤에 들어가야 하므로 뒤 이웃과 같으면 루트부터 내려감
+static inline RBT_NODE *RBT_FN(insert_hint)(RBT_TREE *t, RBT_NODE *hint, RBT_KEY key, RBT_VALUE value) {
+    if (hint == NULL || hint == t->nil) {
+        return RBT_FN(insert)(t, key, value);
+    }
+    RBT_NODE *prev, *next;
+    if (RBT_LT(key, hint->key)) {
+        prev = RBT_FN(predecessor)(t, hint);
+        next = hint;
+        if (prev != NULL && RBT_LT(key, prev->key)) {
+            return RBT_FN(insert)(t, key, value);
+        }
+    } else {
+        prev = hint;
+        next = RBT_FN(successor)(t, hint);
+        if (next != NULL && !RBT_LT(key, next->key)) {
+            return RBT_FN(insert)(t, key, value);
+        }
+    }
+    RBT_NODE *z = RBT_FN(node_new)(t, key, value);
+    if (z == NULL) {
+        return NULL;
+    }
+    RBT_FN(link_between)(t, z, prev, next);
+    RBT_FN(insert_fixup)(t, z);
+    return z;
+}
+
+static inline RBT_NODE *RBT_FN(find)(const RBT_TREE *t, RBT_KEY key) {
+    RBT_NODE *x = t->root;
+    while (x != t->nil) {
+#ifdef RBT_CMP
+        int c = RBT_CMP(key, x->key); // 비교 함수는 한 번만 부름 (문자열 등 비싼 비교)
+        if (c == 0) {
+            return x;
+        }
+        x = c < 0 ? x->left : x->right;
+#else
+        // 연산자 비교는 rbtree_find와 같은 모양으로 두어야 컴파일러가 비교 플래그로 바로 cmov를 만듦
+        // (3-way 값을 만든 뒤 다시 비교하면 의존 사슬이 길어져 1M 키에서 탐색이 두 배 이상 느려짐)
+        if (key == x->key) {
+            return x;
+        }
+        x = key < x->key ? x->left : x->right;
+#endif
+    }
+    return NULL;
+}
+
+// key 이상인 첫 노드 / key보다 큰 첫 노드 (없으면 NULL). 같은 키가 여럿이면 그중 처음부터
+static inline RBT_NODE *RBT_FN(lower_bound)(const RBT_TREE *t, RBT_KEY key) {
+    RBT_NODE *found = NULL;
+    for (RBT_NODE *x = t->root; x != t->nil;) {
+        const int hit = !RBT_LT(x->key, key);
+        found = hit ? x : found;
+        x = hit ? x->left : x->right;
+    }
+    return found;
+}
+
+static inline RBT_NODE *RBT_FN(upper_bound)(const RBT_TREE *t, RBT_KEY key) {
+    RBT_NODE *found = NULL;
+    for (RBT_NODE *x = t->root; x != t->nil;) {
+        const int hit = RBT_LT(key, x->key);
+        found = hit ? x : found;
+        x = hit ? x->left : x->right;
+    }
+    return found;
+}
+
+static inline RBT_NODE *RBT_FN(min)(const RBT_TREE *t) {
+    return t->root == t->nil ? NULL : RBT_FN(subtree_min)(t, t->root);
+}
+
+static inline RBT_NODE *RBT_FN(max)(const RBT_TREE *t) {
+    return t->root == t->nil ? NULL : RBT_FN(subtree_max)(t, t->root);
+}
+
+static inline RBT_NODE *RBT_FN(next)(const RBT_TREE *t, const RBT_NODE *x) {
+    return RBT_FN(successor)(t, x);
+}
+
+static inline RBT_NODE *RBT_FN(prev)(const RBT_TREE *t, const RBT_NODE *x) {
+    return RBT_FN(predecessor)(t, x);
+}
+
+static inline int RBT_FN(erase)(RBT_TREE *t, RBT_NODE *z) {
+    if (t == NULL || z == NULL || z == t->nil) {
+        return -1;
+    }
+    RBT_FN(erase_node)(t, z);
+    free(z);
+    return 0;
+}
+
+// key를 가진 노드 하나를 찾아 지움. 없으면 -1
+static inline int RBT_FN(erase_key)(RBT_TREE *t, RBT_KEY key) {
+    return RBT_FN(erase)(t, RBT_FN(find)(t, key));
+}
+
+// z를 지우고 z의 다음 노드를 반환 (없으면 NULL). 지우는 동안 다른 노드의 주소는 바뀌지 않으므로 먼저 구해둠
+static inline RBT_NODE *RBT_FN(erase_next)(RBT_TREE *t, RBT_NODE *z) {
+    if (t == NULL || z == NULL || z == t->nil) {
+        return NULL;
+    }
+    RBT_NODE *next = RBT_FN(successor)(t, z);
+    RBT_FN(erase)(t, z);
+    return next;
+}
+
+// 키를 오름차순으로 최대 n개 arr에 복사 (rbtree.c의 rbtree_to_array와 같은 고정 크기 스택 순회)
+static inline int RBT_FN(to_array)(const RBT_TREE *t, RBT_KEY *arr, const size_t n) {
+    if (t == NULL || arr == NULL) {
+        return -1;
+    }
+    RBT_NODE *stack[128]; // 높이 2 * log2(n + 1) <= 128
+    size_t top = 0, index = 0;
+    RBT_NODE *x = t->root;
+    while (index < n) {
+        while (x != t->nil) {
+            stack[top++] = x;
+            x = x->left;
+        }
+        if (top == 0) {
+            break;
+        }
+        x = stack[--top];
+        arr[index++] = x->key;
+        x = x->right;
+    }
+    return 0;
+}
+
+// 다음 include에서 다른 타입으로 다시 정의할 수 있도록 매개변수 매크로 정리
+#undef RBT_TREE
+#undef RBT_NODE
+#undef RBT_FN
+#undef RBT_NAME
+#undef RBT_KEY
+#undef RBT_CMP
+#undef RBT_LT
+#undef RBT_VALUE
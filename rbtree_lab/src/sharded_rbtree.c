@@ -0,0 +1,213 @@
+#include "sharded_rbtree.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+// shard마다 락과 트리 포인터를 서로 다른 캐시 라인에 두어, 이웃 shard를 쓰는 스레드끼리 캐시 라인을 두고 다투지 않게 함
+#define SHARD_CACHE_LINE 64
+
+typedef struct {
+    _Alignas(SHARD_CACHE_LINE) pthread_mutex_t lock;
+    rbtree *t;
+} shard_t;
+
+struct sharded_rbtree {
+    size_t n;       // shard 수
+    int by_range;   // 1 : 구간 모드, 0 : 해시 모드
+    key_t lo;       // 구간 모드의 시작 키
+    int64_t width;  // 구간 모드에서 shard 하나가 맡는 키의 폭
+    shard_t *shards;
+};
+
+// key가 들어갈 shard 번호
+static size_t shard_of(const sharded_rbtree *st, const key_t key) {
+    if (st->by_range) {
+        if (key <= st->lo) {
+            return 0;
+        }
+        int64_t i = ((int64_t)key - st->lo) / st->width;
+        return i < (int64_t)st->n ? (size_t)i : st->n - 1; // hi보다 큰 키는 마지막 shard
+    }
+    // 피보나치 해싱 : 연속된 키도 고르게 흩어짐
+    // 32비트 해시에 n을 곱한 상위 32비트를 쓰면 나머지 연산 없이 [0, n) 구간으로 줄어듦
+    uint32_t h = (uint32_t)key * 2654435769u;
+    return (size_t)(((uint64_t)h * st->n) >> 32);
+}
+
+static sharded_rbtree *new_sharded(const size_t n_shards, const int by_range, const key_t lo, const key_t hi) {
+    if (n_shards == 0) {
+        return NULL;
+    }
+    sharded_rbtree *st = (sharded_rbtree *)calloc(1, sizeof(sharded_rbtree));
+    if (st == NULL) {
+        return NULL;
+    }
+    st->by_range = by_range;
+    st->lo = lo;
+    st->width = ((int64_t)hi - lo) / (int64_t)n_shards + 1; // n * width > hi - lo 이므로 [lo, hi]가 모두 덮임
+    st->shards = (shard_t *)aligned_alloc(SHARD_CACHE_LINE, n_shards * sizeof(shard_t));
+    if (st->shards == NULL) {
+        free(st);
+        return NULL;
+    }
+    for (st->n = 0; st->n < n_shards; st->n++) {
+        shard_t *s = &st->shards[st->n];
+        // shard마다 노드 풀을 둠 -> 노드 할당이 shard의 락 안에서 끝나 malloc 내부의 락을 두고 다투지 않음
+        s->t = new_rbtree_with_pool(0);
+        if (s->t == NULL) {
+            delete_sharded_rbtree(st); // 지금까지 만든 st->n개만 정리됨
+            return NULL;
+        }
+        pthread_mutex_init(&s->lock, NULL);
+    }
+    return st;
+}
+
+sharded_rbtree *new_sharded_rbtree_hash(const size_t n_shards) {
+    return new_sharded(n_shards, 0, 0, 0);
+}
+
+sharded_rbtree *new_sharded_rbtree_range(const size_t n_shards, const key_t lo, const key_t hi) {
+    if (lo > hi) {
+        return NULL;
+    }
+    return new_sharded(n_shards, 1, lo, hi);
+}
+
+void delete_sharded_rbtree(sharded_rbtree *st) {
+    if (st == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < st->n; i++) {
+        pthread_mutex_destroy(&st->shards[i].lock);
+        delete_rbtree(st->shards[i].t);
+    }
+    free(st->shards);
+    free(st);
+}
+
+int sharded_rbtree_insert(sharded_rbtree *st, const key_t key) {
+    shard_t *s = &st->shards[shard_of(st, key)];
+    pthread_mutex_lock(&s->lock);
+    node_t *p = rbtree_insert(s->t, key);
+    pthread_mutex_unlock(&s->lock);
+    return p != NULL ? 0 : -1;
+}
+
+int sharded_rbtree_find(sharded_rbtree *st, const key_t key) {
+    shard_t *s = &st->shards[shard_of(st, key)];
+    pthread_mutex_lock(&s->lock);
+    int found = rbtree_find(s->t, key) != NULL;
+    pthread_mutex_unlock(&s->lock);
+    return found;
+}
+
+int sharded_rbtree_erase(sharded_rbtree *st, const key_t key) {
+    shard_t *s = &st->shards[shard_of(st, key)];
+    pthread_mutex_lock(&s->lock);
+    node_t *p = rbtree_find(s->t, key);
+    if (p != NULL) {
+        rbtree_erase(s->t, p);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return p != NULL ? 0 : -1;
+}
+
+// rbtree_range로 [lo, hi] 구간의 첫 노드 하나만 받아오는 콜백
+static int take_first(node_t *p, void *ctx) {
+    *(node_t **)ctx = p;
+    return 1;
+}
+
+/**
+ * [lo, hi]에 걸치는 shard들의 락을 번호 순서대로 모두 잡고 오름차순으로 방문
+ * 락을 항상 같은 순서로 잡으므로 여러 스레드가 동시에 불러도 교착 상태가 생기지 않음
+ * - 구간 모드 : shard끼리 키 구간이 겹치지 않으므로 shard를 앞에서부터 차례로 순회
+ * - 해시 모드 : shard마다 구간의 첫 노드를 커서로 두고, 매번 가장 작은 커서를 방문한 뒤 successor로 옮기는 k-way 병합
+ *   shard 수가 코어 수 정도라 가장 작은 커서를 힙 대신 선형으로 찾음
+ */
+static int merge_range(sharded_rbtree *st, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx) {
+    if (lo > hi) {
+        return 0;
+    }
+    const size_t first = st->by_range ? shard_of(st, lo) : 0;
+    const size_t last = st->by_range ? shard_of(st, hi) : st->n - 1;
+    const size_t k = last - first + 1;
+    node_t **cur = (node_t **)malloc(k * sizeof(node_t *));
+    if (cur == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < k; i++) {
+        pthread_mutex_lock(&st->shards[first + i].lock);
+    }
+
+    if (st->by_range) {
+        int stop = 0;
+        for (size_t i = 0; i < k && !stop; i++) {
+            const rbtree *t = st->shards[first + i].t;
+            node_t *x = NULL;
+            rbtree_range(t, lo, hi, take_first, &x);
+            for (; x != NULL && x->key <= hi; x = rbtree_next(t, x)) {
+                if (visit(x, ctx) != 0) {
+                    stop = 1;
+                    break;
+                }
+            }
+        }
+    } else {
+        for (size_t i = 0; i < k; i++) {
+            cur[i] = NULL;
+            rbtree_range(st->shards[first + i].t, lo, hi, take_first, &cur[i]);
+        }
+        for (;;) {
+            size_t best = k;
+            for (size_t i = 0; i < k; i++) {
+                if (cur[i] != NULL && (best == k || cur[i]->key < cur[best]->key)) {
+                    best = i;
+                }
+            }
+            if (best == k || visit(cur[best], ctx) != 0) { // 모든 커서가 끝났거나 콜백이 멈춤을 요청
+                break;
+            }
+            node_t *next = rbtree_next(st->shards[first + best].t, cur[best]);
+            cur[best] = next != NULL && next->key <= hi ? next : NULL;
+        }
+    }
+
+    for (size_t i = k; i > 0; i--) {
+        pthread_mutex_unlock(&st->shards[first + i - 1].lock);
+    }
+    free(cur);
+    return 0;
+}
+
+int sharded_rbtree_range(sharded_rbtree *st, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx) {
+    if (st == NULL || visit == NULL) {
+        return -1;
+    }
+    return merge_range(st, lo, hi, visit, ctx);
+}
+
+// to_array용 콜백 상태 : 채울 배열과 그 크기, 지금까지 채운 수
+typedef struct {
+    key_t *arr;
+    size_t n, index;
+} fill_ctx;
+
+static int fill_array(node_t *p, void *ctx) {
+    fill_ctx *c = (fill_ctx *)ctx;
+    c->arr[c->index++] = p->key;
+    return c->index == c->n; // n개를 채우면 멈춤
+}
+
+int sharded_rbtree_to_array(sharded_rbtree *st, key_t *arr, const size_t n) {
+    if (st == NULL || arr == NULL) {
+        return -1;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    fill_ctx c = {arr, n, 0};
+    return merge_range(st, INT_MIN, INT_MAX, fill_array, &c);
+}
@@ -0,0 +1,49 @@
+#ifndef _SHARDED_RBTREE_H_
+#define _SHARDED_RBTREE_H_
+
+#include "rbtree.h"
+
+/**
+ * sharded_rbtree : 키 공간을 N개의 독립된 rbtree(shard)로 나누고 shard마다 락을 둔 래퍼
+ * 트리 하나에 전역 락을 걸면 쓰기 스레드가 몇 개든 한 번에 하나만 들어갈 수 있음
+ * 키마다 들어갈 shard가 정해져 있으므로, 다른 shard에 들어가는 삽입/삭제는 서로 기다리지 않고 동시에 진행
+ *
+ * 나누는 방법
+ * - 해시 : 키를 해시해서 shard를 고름. 어떤 키 분포든 고르게 퍼지지만, 순서 연산은 모든 shard를 병합해야 함
+ * - 구간 : [lo, hi]를 같은 폭으로 N등분. 순서 연산은 겹치는 shard만 차례로 보면 되지만,
+ *   키가 한쪽에 몰리면 그 shard만 바쁨
+ *   구간 밖의 키는 가장 앞/뒤 shard에 들어감
+ *
+ * 모든 함수는 여러 스레드에서 동시에 불러도 안전
+ * 다른 스레드가 언제든 지울 수 있으므로 노드 포인터는 밖으로 내보내지 않고 키 단위로 다룸
+ * (range의 콜백은 해당 shard들의 락을 잡은 채 불리므로 그 안에서만 노드를 써야 하고, 같은 트리의 함수를 부르면 안 됨)
+ */
+typedef struct sharded_rbtree sharded_rbtree;
+
+// n_shards개의 shard로 나누는 해시 sharded 트리. 실패 시 NULL
+sharded_rbtree *new_sharded_rbtree_hash(const size_t n_shards);
+
+// [lo, hi]를 n_shards개 구간으로 나누는 구간 sharded 트리. lo > hi이거나 실패 시 NULL
+sharded_rbtree *new_sharded_rbtree_range(const size_t n_shards, const key_t lo, const key_t hi);
+
+void delete_sharded_rbtree(sharded_rbtree *);
+
+// key 추가 (multiset이므로 중복 허용). 성공 0, 할당 실패 -1
+int sharded_rbtree_insert(sharded_rbtree *, const key_t);
+
+// key가 있으면 1, 없으면 0
+int sharded_rbtree_find(sharded_rbtree *, const key_t);
+
+// key를 가진 노드 하나를 삭제. 성공 0, 없으면 -1
+int sharded_rbtree_erase(sharded_rbtree *, const key_t);
+
+/**
+ * 모든 shard의 키를 오름차순으로 최대 n개 arr에 채움
+ * 관련된 shard의 락을 번호 순서대로 모두 잡은 채 병합하므로, 그 순간의 일관된 결과를 얻음
+ */
+int sharded_rbtree_to_array(sharded_rbtree *, key_t *, const size_t);
+
+// lo <= key <= hi 인 노드를 shard와 상관없이 오름차순으로 visit에 넘김. 콜백이 0이 아닌 값을 반환하면 멈춤
+int sharded_rbtree_range(sharded_rbtree *, const key_t lo, const key_t hi, rbtree_visit_fn visit, void *ctx);
+
+#endif // _SHARDED_RBTREE_H_
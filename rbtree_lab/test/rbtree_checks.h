@@ -0,0 +1,266 @@
+/**
+ * 키 타입과 상관없는 검사 묶음 (RB / 탐색 트리 조건, 중복 키, 부분 to_array, 무작위 find/erase)
+ * test-rbtree.c가 int 키 rbtree로, test-rbtree-tmpl.c가 rbtree_tmpl.h로 만든 트리마다 이 헤더를 include해서
+ * 같은 검사를 그 트리의 타입으로 찍어냄 (끝에서 CHECK_* 매크로를 모두 #undef)
+ *
+ * include하기 전에 정의하는 매크로
+ *   CHECK_TREE, CHECK_NODE, CHECK_KEY  트리 / 노드 / 키 타입 (노드에는 key, left, right 필드)
+ *   CHECK_FN(name)                     생성할 함수 이름
+ *   CHECK_KEY_OF(i)                    int i(0 이상)로 키를 만듦. i의 크기 순서가 키의 순서와 같아야 함
+ *                                      (-1은 to_array가 쓰지 않은 칸을 표시할 때만 씀)
+ *   CHECK_LT(a, b), CHECK_EQ(a, b)     키 비교
+ *   CHECK_NEW(), CHECK_DELETE(t)       트리 생성 / 해제
+ *   CHECK_INSERT(t, key), CHECK_FIND(t, key), CHECK_ERASE(t, p), CHECK_TO_ARRAY(t, arr, n)
+ *   CHECK_NIL(t)                       자식이 없음을 나타내는 노드 (센티넬 또는 NULL)
+ *   CHECK_IS_RED(p)                    노드의 색
+ */
+
+static void CHECK_FN(insert_arr)(CHECK_TREE *t, const CHECK_KEY *arr, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        CHECK_INSERT(t, arr[i]);
+    }
+}
+
+static int CHECK_FN(comp)(const void *p1, const void *p2) {
+    const CHECK_KEY *e1 = (const CHECK_KEY *)p1;
+    const CHECK_KEY *e2 = (const CHECK_KEY *)p2;
+    if (CHECK_LT(*e1, *e2)) {
+        return -1;
+    } else if (CHECK_LT(*e2, *e1)) {
+        return 1;
+    } else {
+        return 0;
+    }
+};
+
+// ids의 값들로 만든 키 배열 (호출한 쪽이 free)
+static CHECK_KEY *CHECK_FN(keys_of)(const int *ids, const size_t n) {
+    CHECK_KEY *arr = calloc(n, sizeof(CHECK_KEY));
+    assert(arr != NULL);
+    for (size_t i = 0; i < n; i++) {
+        arr[i] = CHECK_KEY_OF(ids[i]);
+    }
+    return arr;
+}
+
+// 트리 크기보다 작은 n을 주면 앞에서부터 n개만 채우고, 그 뒤 칸은 건드리지 않아야 함
+static void CHECK_FN(test_to_array_partial)(void) {
+    CHECK_TREE *t = CHECK_NEW();
+    assert(t != NULL);
+
+    const int ids[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+    const size_t n = sizeof(ids) / sizeof(ids[0]);
+    CHECK_KEY *entries = CHECK_FN(keys_of)(ids, n);
+    CHECK_FN(insert_arr)(t, entries, n);
+    qsort((void *)entries, n, sizeof(CHECK_KEY), CHECK_FN(comp));
+
+    const size_t m = 5;
+    const CHECK_KEY unused = CHECK_KEY_OF(-1);
+    CHECK_KEY res[n];
+    for (int i = 0; i < n; i++) {
+        res[i] = unused;
+    }
+    CHECK_TO_ARRAY(t, res, m);
+    for (int i = 0; i < n; i++) {
+        assert(CHECK_EQ(res[i], i < m ? entries[i] : unused));
+    }
+
+    free(entries);
+    CHECK_DELETE(t);
+}
+
+// Search tree constraint
+// The values of left subtree should be less than or equal to the current node
+// The values of right subtree should be greater than or equal to the current
+// node
+
+static bool CHECK_FN(search_traverse)(const CHECK_NODE *p, CHECK_KEY *min, CHECK_KEY *max, const CHECK_NODE *nil) {
+    if (p == nil) {
+        return true;
+    }
+
+    *min = *max = p->key;
+
+    CHECK_KEY l_min, l_max, r_min, r_max;
+    l_min = l_max = r_min = r_max = p->key;
+
+    const bool lr = CHECK_FN(search_traverse)(p->left, &l_min, &l_max, nil);
+    if (!lr || CHECK_LT(p->key, l_max)) {
+        return false;
+    }
+    const bool rr = CHECK_FN(search_traverse)(p->right, &r_min, &r_max, nil);
+    if (!rr || CHECK_LT(r_min, p->key)) {
+        return false;
+    }
+
+    *min = l_min;
+    *max = r_max;
+    return true;
+}
+
+static void CHECK_FN(test_search_constraint)(const CHECK_TREE *t) {
+    assert(t != NULL);
+    CHECK_KEY min, max;
+    assert(CHECK_FN(search_traverse)(t->root, &min, &max, CHECK_NIL(t)));
+}
+
+// Color constraint
+// 1. Each node is either red or black. (by definition)
+// 2. All NIL nodes are considered black.
+// 3. A red node does not have a red child.
+// 4. Every path from a given node to any of its descendant NIL nodes goes
+// through the same number of black nodes.
+
+static bool CHECK_FN(touch_nil) = false;
+static int CHECK_FN(max_black_depth) = 0;
+
+static void CHECK_FN(init_color_traverse)(void) {
+    CHECK_FN(touch_nil) = false;
+    CHECK_FN(max_black_depth) = 0;
+}
+
+static bool CHECK_FN(color_traverse)(const CHECK_NODE *p, const bool parent_red, const int black_depth,
+                                     const CHECK_NODE *nil) {
+    if (p == nil) {
+        if (!CHECK_FN(touch_nil)) {
+            CHECK_FN(touch_nil) = true;
+            CHECK_FN(max_black_depth) = black_depth;
+        } else if (black_depth != CHECK_FN(max_black_depth)) {
+            return false;
+        }
+        return true;
+    }
+    if (parent_red && CHECK_IS_RED(p)) {
+        return false;
+    }
+    int next_depth = (CHECK_IS_RED(p) ? 0 : 1) + black_depth;
+    return CHECK_FN(color_traverse)(p->left, CHECK_IS_RED(p), next_depth, nil) &&
+           CHECK_FN(color_traverse)(p->right, CHECK_IS_RED(p), next_depth, nil);
+}
+
+static void CHECK_FN(test_color_constraint)(const CHECK_TREE *t) {
+    assert(t != NULL);
+    const CHECK_NODE *nil = CHECK_NIL(t);
+    const CHECK_NODE *p = t->root;
+    assert(p == nil || !CHECK_IS_RED(p));
+
+    CHECK_FN(init_color_traverse)();
+    assert(CHECK_FN(color_traverse)(p, false, 0, nil));
+}
+
+// rbtree should keep search tree and color constraints
+static void CHECK_FN(test_rb_constraints)(const CHECK_KEY arr[], const size_t n) {
+    CHECK_TREE *t = CHECK_NEW();
+    assert(t != NULL);
+
+    CHECK_FN(insert_arr)(t, arr, n);
+    assert(t->root != NULL);
+
+    CHECK_FN(test_color_constraint)(t);
+    CHECK_FN(test_search_constraint)(t);
+
+    CHECK_DELETE(t);
+}
+
+// rbtree should manage distinct values
+// 삭제 기능 사용 x, 중복 없는 값들에 대해 RED-BLACK 불변식과 BST 불변식 유지를 검증
+static void CHECK_FN(test_distinct_values)(void) {
+    const int ids[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
+    const size_t n = sizeof(ids) / sizeof(ids[0]);
+    CHECK_KEY *entries = CHECK_FN(keys_of)(ids, n);
+    CHECK_FN(test_rb_constraints)(entries, n);
+    free(entries);
+}
+
+// rbtree should manage values with duplicate
+// 중복 값 존재 시에도 RED-BLACK, 탐색 불변식 유지를 검증
+static void CHECK_FN(test_duplicate_values)(void) {
+    const int ids[] = {10, 5, 5, 34, 6, 23, 12, 12, 6, 12};
+    const size_t n = sizeof(ids) / sizeof(ids[0]);
+    CHECK_KEY *entries = CHECK_FN(keys_of)(ids, n);
+    CHECK_FN(test_rb_constraints)(entries, n);
+    free(entries);
+}
+
+// 올바른 삽입 검증
+// 올바른 삭제 검증
+static void CHECK_FN(test_find_erase)(CHECK_TREE *t, const CHECK_KEY *arr, const size_t n) {
+    for (int i = 0; i < n; i++) { // 삽입 검증
+        CHECK_NODE *p = CHECK_INSERT(t, arr[i]);
+        assert(p != NULL);
+    }
+
+    for (int i = 0; i < n; i++) {
+        CHECK_NODE *p = CHECK_FIND(t, arr[i]);
+        assert(p != NULL);
+        assert(CHECK_EQ(p->key, arr[i]));
+        CHECK_ERASE(t, p);
+    }
+
+    for (int i = 0; i < n; i++) {
+        CHECK_NODE *p = CHECK_FIND(t, arr[i]);
+        assert(p == NULL);
+    }
+
+    for (int i = 0; i < n; i++) {
+        CHECK_NODE *p = CHECK_INSERT(t, arr[i]);
+        assert(p != NULL);
+        CHECK_NODE *q = CHECK_FIND(t, arr[i]);
+        assert(q != NULL);
+        assert(CHECK_EQ(q->key, arr[i]));
+        assert(p == q);
+        CHECK_ERASE(t, p);
+        q = CHECK_FIND(t, arr[i]);
+        assert(q == NULL);
+    }
+}
+
+static void CHECK_FN(test_find_erase_fixed)(void) {
+    const int ids[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+    const size_t n = sizeof(ids) / sizeof(ids[0]);
+    CHECK_KEY *arr = CHECK_FN(keys_of)(ids, n);
+    CHECK_TREE *t = CHECK_NEW();
+    assert(t != NULL);
+
+    CHECK_FN(test_find_erase)(t, arr, n);
+
+    free(arr);
+    CHECK_DELETE(t);
+}
+
+// 난수로 만들어진 키 집합에 대해
+// 1. 전부 삽입 -> 모두 탐색 가능
+// 2. 모두 삭제 -> 더이상 탐색 불가
+// 3. 다시 개별 삽입, 탐색, 삭제를 반복하며 검증
+static void CHECK_FN(test_find_erase_rand)(const size_t n, const unsigned int seed) {
+    srand(seed); // 고정 시드 - 매 실행마다 같은 난수를 얻어 테스트를 재현 가능하게 함
+    CHECK_TREE *t = CHECK_NEW();
+    CHECK_KEY *arr = calloc(n, sizeof(CHECK_KEY)); // n개 키를 담을 배열 동적 할당
+    for (int i = 0; i < n; i++) {                  // n개의 난수를 arr에 채워넣음
+        arr[i] = CHECK_KEY_OF(rand());
+    }
+
+    // arr의 모든 원소 삽입 -> find 검증
+    // 각 노드를 삭제 -> 같은 키로 찾을 시 NULL인지 검증
+    // 다시 삽입 -> find가 같은 포인터 주소를 돌려주는디 확인 후 삭제
+    CHECK_FN(test_find_erase)(t, arr, n);
+
+    free(arr);
+    CHECK_DELETE(t);
+}
+
+#undef CHECK_TREE
+#undef CHECK_NODE
+#undef CHECK_KEY
+#undef CHECK_FN
+#undef CHECK_KEY_OF
+#undef CHECK_LT
+#undef CHECK_EQ
+#undef CHECK_NEW
+#undef CHECK_DELETE
+#undef CHECK_INSERT
+#undef CHECK_FIND
+#undef CHECK_ERASE
+#undef CHECK_TO_ARRAY
+#undef CHECK_NIL
+#undef CHECK_IS_RED
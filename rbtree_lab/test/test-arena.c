@@ -0,0 +1,269 @@
+#define _GNU_SOURCE // memfd_create
+
+#include <arena_rbtree.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// arena_rbtree가 rbtree와 같은 결과를 내는지, 다른 주소/다른 프로세스에서 매핑해도 그대로 쓰이는지 검증
+// 트리 모양은 arena_rbtree.h에 적힌 파일 형식을 직접 읽어 RB 규칙을 검사
+
+typedef struct {
+    char magic[4];
+    uint16_t version, key_size;
+    uint32_t seq, capacity, used, free_head, root, count;
+} file_header;
+
+typedef struct {
+    key_t key;
+    uint32_t parent_color, left, right;
+} file_node;
+
+#define HEADER_SIZE 64
+
+static int comp(const void *p1, const void *p2) {
+    const key_t *e1 = (const key_t *)p1;
+    const key_t *e2 = (const key_t *)p2;
+    return (*e1 > *e2) - (*e1 < *e2);
+}
+
+// x 서브트리의 검정 높이. 부모 번호, 정렬 순서, RED-RED 인접을 함께 검사
+static int check_subtree(const file_node *nd, const uint32_t x, const uint32_t parent, const key_t *lo, const key_t *hi,
+                         size_t *count) {
+    if (x == 0) {
+        return 1;
+    }
+    (*count)++;
+    assert(nd[x].parent_color >> 1 == parent);
+    assert((lo == NULL || nd[x].key >= *lo) && (hi == NULL || nd[x].key <= *hi));
+    const int red = (nd[x].parent_color & 1) == 0;
+    if (red) {
+        assert(nd[nd[x].left].parent_color & 1);
+        assert(nd[nd[x].right].parent_color & 1);
+    }
+    int lh = check_subtree(nd, nd[x].left, x, lo, &nd[x].key, count);
+    int rh = check_subtree(nd, nd[x].right, x, &nd[x].key, hi, count);
+    assert(lh == rh);
+    return lh + !red;
+}
+
+// fd의 arena를 따로 매핑해 RB 규칙과 헤더의 키 개수를 확인
+static void check_arena(int fd, const size_t expected) {
+    file_header h;
+    assert(pread(fd, &h, sizeof(h), 0) == sizeof(h));
+    assert(h.seq % 2 == 0 && h.count == expected && h.used <= h.capacity);
+    const size_t bytes = HEADER_SIZE + (size_t)h.capacity * sizeof(file_node);
+    char *p = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    const file_node *nd = (const file_node *)(p + HEADER_SIZE);
+    assert(nd[0].parent_color & 1); // nil은 BLACK
+    assert(h.root == 0 || (nd[h.root].parent_color & 1));
+    size_t count = 0;
+    check_subtree(nd, h.root, 0, NULL, NULL, &count);
+    assert(count == expected);
+    munmap(p, bytes);
+}
+
+// to_array 결과가 sorted(오름차순 m개)와 같은지, range가 sorted를 걸러낸 것과 같은지 확인
+typedef struct {
+    key_t *out;
+    size_t count, limit;
+} range_ctx;
+
+static int collect(key_t key, void *ctx) {
+    range_ctx *c = ctx;
+    c->out[c->count++] = key;
+    return c->count == c->limit;
+}
+
+static void check_ordered(arena_rbtree *a, const key_t *sorted, const size_t m, const key_t lo, const key_t hi) {
+    assert(arena_rbtree_size(a) == m);
+    key_t *res = calloc(m + 1, sizeof(key_t));
+    assert(arena_rbtree_to_array(a, res, m + 1) == 0);
+    for (size_t i = 0; i < m; i++) {
+        assert(res[i] == sorted[i]);
+    }
+    range_ctx c = {res, 0, m + 1};
+    assert(arena_rbtree_range(a, lo, hi, collect, &c) == 0);
+    size_t j = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (sorted[i] >= lo && sorted[i] <= hi) {
+            assert(j < c.count && res[j++] == sorted[i]);
+        }
+    }
+    assert(j == c.count);
+    c = (range_ctx){res, 0, 2}; // 콜백이 멈추면 더 방문하지 않음
+    arena_rbtree_range(a, lo, hi, collect, &c);
+    assert(c.count <= 2);
+    free(res);
+}
+
+static void test_arena(int fd, const size_t n, const unsigned seed) {
+    arena_rbtree *a = arena_rbtree_create(fd, 16); // 작게 시작해 삽입 중에 여러 번 늘어나게 함
+    assert(a != NULL);
+    arena_rbtree *r = arena_rbtree_open(fd, 0); // 같은 arena를 다른 주소에 매핑한 읽기 전용 핸들
+    assert(r != NULL);
+    assert(arena_rbtree_size(a) == 0 && arena_rbtree_find(r, 0) == 0);
+
+    key_t *keys = calloc(n, sizeof(key_t)), *sorted = calloc(n, sizeof(key_t));
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand() % (int)n - (int)n / 4; // 중복 키와 음수 포함
+        assert(arena_rbtree_insert(a, keys[i]) == 0);
+        sorted[i] = keys[i];
+    }
+    qsort(sorted, n, sizeof(key_t), comp);
+    check_arena(fd, n);
+    check_ordered(a, sorted, n, (key_t)n / 5, (key_t)n / 2);
+    for (size_t i = 0; i < n; i++) {
+        assert(arena_rbtree_find(r, keys[i])); // 읽기 핸들은 늘어난 arena를 다시 매핑해서 찾음
+    }
+    assert(!arena_rbtree_find(r, (key_t)n));
+    check_ordered(r, sorted, n, (key_t)n / 5, (key_t)n / 2);
+
+    // 읽기 전용 핸들로는 바꿀 수 없음
+    assert(arena_rbtree_insert(r, 1) == -1 && arena_rbtree_erase(r, keys[0]) == -1 && arena_rbtree_sync(r) == -1);
+
+    // 절반을 지움 -> 지운 슬롯이 다음 삽입에 재사용됨
+    for (size_t i = 0; i < n; i += 2) {
+        assert(arena_rbtree_erase(a, keys[i]) == 0);
+    }
+    assert(arena_rbtree_erase(a, (key_t)n) == -1);
+    size_t m = 0;
+    for (size_t i = 1; i < n; i += 2) {
+        sorted[m++] = keys[i];
+    }
+    qsort(sorted, m, sizeof(key_t), comp);
+    check_arena(fd, m);
+    check_ordered(r, sorted, m, -(key_t)n, 0);
+    const off_t size = lseek(fd, 0, SEEK_END);
+    for (size_t i = 0; i < n; i += 2) {
+        assert(arena_rbtree_insert(a, keys[i]) == 0);
+    }
+    assert(lseek(fd, 0, SEEK_END) == size); // 지운 슬롯만으로 충분하므로 arena가 늘지 않음
+    check_arena(fd, n);
+    assert(arena_rbtree_sync(a) == 0);
+
+    // 핸들을 모두 닫고 다시 열면 변환 없이 그대로 이어서 쓸 수 있음
+    arena_rbtree_close(r);
+    arena_rbtree_close(a);
+    a = arena_rbtree_open(fd, 1);
+    assert(a != NULL && arena_rbtree_size(a) == n);
+    for (size_t i = 0; i < n; i++) {
+        assert(arena_rbtree_find(a, keys[i]));
+        assert(arena_rbtree_erase(a, keys[i]) == 0);
+    }
+    check_arena(fd, 0);
+    assert(arena_rbtree_to_array(a, sorted, n) == 0 && arena_rbtree_size(a) == 0);
+    arena_rbtree_close(a);
+
+    // 이미 arena가 있는 파일에는 새로 만들지 않음
+    assert(arena_rbtree_create(fd, 0) == NULL);
+    free(sorted);
+    free(keys);
+}
+
+// 다른 프로세스에서 연 읽기 핸들 : 부모가 쓰는 도중에도 지우지 않는 키는 항상 보여야 함
+static void test_cross_process(const size_t n) {
+    int fd = memfd_create("test-arena", 0);
+    assert(fd >= 0);
+    arena_rbtree *a = arena_rbtree_create(fd, n);
+    for (key_t k = 0; k < (key_t)n; k++) {
+        assert(arena_rbtree_insert(a, 2 * k) == 0); // 짝수 키는 그대로 둠
+    }
+    int go[2];
+    assert(pipe(go) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        arena_rbtree *r = arena_rbtree_open(fd, 0);
+        char c;
+        if (r == NULL || read(go[0], &c, 1) != 1) {
+            _exit(1);
+        }
+        int ok = 1;
+        for (int round = 0; round < 20; round++) {
+            for (key_t k = 0; k < (key_t)n; k++) {
+                ok &= arena_rbtree_find(r, 2 * k);
+            }
+        }
+        arena_rbtree_close(r);
+        _exit(ok ? 0 : 2);
+    }
+    assert(write(go[1], "x", 1) == 1);
+    // 자식이 읽는 동안 홀수 키를 넣고 지우며 회전을 일으키고, arena도 늘림
+    for (int round = 0; round < 20; round++) {
+        for (key_t k = 0; k < (key_t)n; k++) {
+            assert(arena_rbtree_insert(a, 2 * k + 1) == 0);
+        }
+        for (key_t k = 0; k < (key_t)n; k++) {
+            assert(arena_rbtree_erase(a, 2 * k + 1) == 0);
+        }
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    check_arena(fd, n);
+    arena_rbtree_close(a);
+    close(go[0]);
+    close(go[1]);
+    close(fd);
+}
+
+// 형식이 다르거나, 잘렸거나, 쓰다 만 arena는 열지 않음
+static void test_reject(void) {
+    FILE *f = tmpfile();
+    int fd = fileno(f);
+    assert(arena_rbtree_open(fd, 0) == NULL); // 빈 파일
+    arena_rbtree *a = arena_rbtree_create(fd, 100);
+    assert(a != NULL && arena_rbtree_insert(a, 7) == 0);
+    arena_rbtree_close(a);
+
+    file_header h, bad;
+    assert(pread(fd, &h, sizeof(h), 0) == sizeof(h));
+    bad = h;
+    bad.magic[0] = 'X';
+    assert(pwrite(fd, &bad, sizeof(bad), 0) == sizeof(bad));
+    assert(arena_rbtree_open(fd, 0) == NULL);
+    bad = h;
+    bad.key_size = 8;
+    assert(pwrite(fd, &bad, sizeof(bad), 0) == sizeof(bad));
+    assert(arena_rbtree_open(fd, 0) == NULL);
+    bad = h;
+    bad.seq = 1; // 쓰던 프로세스가 도중에 죽은 arena
+    assert(pwrite(fd, &bad, sizeof(bad), 0) == sizeof(bad));
+    assert(arena_rbtree_open(fd, 1) == NULL && arena_rbtree_open(fd, 0) == NULL);
+    assert(pwrite(fd, &h, sizeof(h), 0) == sizeof(h));
+
+    const off_t size = lseek(fd, 0, SEEK_END);
+    assert(ftruncate(fd, size - 1) == 0); // 잘린 파일
+    assert(arena_rbtree_open(fd, 0) == NULL);
+    assert(ftruncate(fd, size) == 0);
+    a = arena_rbtree_open(fd, 0);
+    assert(a != NULL && arena_rbtree_find(a, 7) && arena_rbtree_size(a) == 1);
+    arena_rbtree_close(a);
+    fclose(f);
+
+    int p[2];
+    assert(pipe(p) == 0);
+    assert(arena_rbtree_create(p[0], 0) == NULL && arena_rbtree_open(p[0], 0) == NULL); // 일반 파일이 아님
+    close(p[0]);
+    close(p[1]);
+    assert(arena_rbtree_create(-1, 0) == NULL && arena_rbtree_open(-1, 0) == NULL);
+}
+
+int main(void) {
+    int fd = memfd_create("test-arena", 0);
+    assert(fd >= 0);
+    test_arena(fd, 20000, 17);
+    close(fd);
+    FILE *f = tmpfile(); // 파일 기반 arena
+    test_arena(fileno(f), 5000, 18);
+    fclose(f);
+    test_cross_process(20000);
+    test_reject();
+    printf("Passed all tests!\n");
+}
@@ -0,0 +1,322 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// rbtree_tmpl.h로 찍어낸 트리들이 test-rbtree.c와 같은 검사를 통과하는지 검증
+// int 키(기존 트리와 같은 조건), uint64_t 키, 문자열 키 세 가지를 생성하고
+// 1. test-rbtree.c와 함께 쓰는 rbtree_checks.h의 검사를 트리마다 생성해서 실행
+// 2. 템플릿에만 있는 값(payload), insert_unique / upsert와 경계 탐색, 힌트 삽입을 검사
+
+#define RBT_NAME rbtree_i32
+#define RBT_KEY int
+#define RBT_VALUE size_t
+#include "rbtree_tmpl.h"
+
+#define RBT_NAME rbtree_u64
+#define RBT_KEY uint64_t
+#define RBT_VALUE uint64_t
+#include "rbtree_tmpl.h"
+
+typedef const char *str_key; // 매크로로 선언을 이어 쓸 때(CHECK_KEY a, b;) 모두 포인터가 되도록 typedef
+
+#define RBT_NAME rbtree_str
+#define RBT_KEY str_key
+#define RBT_CMP(a, b) strcmp((a), (b))
+#define RBT_VALUE size_t
+#include "rbtree_tmpl.h"
+
+// 검사용 키 생성. 0 이상인 i의 순서가 키의 순서와 같아야 함 (rbtree_checks.h의 CHECK_KEY_OF)
+static int i32_of(const int i) {
+    return i;
+}
+
+static uint64_t u64_of(const int i) {
+    return ((uint64_t)(uint32_t)i << 32) | (uint32_t)i; // 상위 32비트까지 쓰는 값
+}
+
+// 문자열 키는 폭을 맞춘 십진수라 문자열 순서가 수의 순서와 같음
+// 트리는 포인터만 저장하므로 키는 덩어리 단위로 모아 두었다가 마지막에 한꺼번에 해제
+#define STR_CHUNK_KEYS 4096
+
+typedef struct str_chunk {
+    struct str_chunk *next;
+    size_t used;
+    char keys[STR_CHUNK_KEYS][12]; // "-000000001" ~ "2147483647"
+} str_chunk;
+
+static str_chunk *str_chunks = NULL;
+
+static str_key str_of(const int i) {
+    if (str_chunks == NULL || str_chunks->used == STR_CHUNK_KEYS) {
+        str_chunk *c = malloc(sizeof(str_chunk));
+        assert(c != NULL);
+        c->next = str_chunks;
+        c->used = 0;
+        str_chunks = c;
+    }
+    char *k = str_chunks->keys[str_chunks->used++];
+    snprintf(k, sizeof(str_chunks->keys[0]), "%010d", i);
+    return k;
+}
+
+static void str_free_all(void) {
+    while (str_chunks != NULL) {
+        str_chunk *next = str_chunks->next;
+        free(str_chunks);
+        str_chunks = next;
+    }
+}
+
+// 공용 검사 생성 : i32_test_find_erase_rand, u64_test_color_constraint, ...
+#define CHECK_TREE rbtree_i32
+#define CHECK_NODE rbtree_i32_node
+#define CHECK_KEY int
+#define CHECK_FN(name) i32_##name
+#define CHECK_KEY_OF(i) i32_of(i)
+#define CHECK_LT(a, b) ((a) < (b))
+#define CHECK_EQ(a, b) ((a) == (b))
+#define CHECK_NEW() rbtree_i32_new()
+#define CHECK_DELETE(t) rbtree_i32_delete(t)
+#define CHECK_INSERT(t, key) rbtree_i32_insert((t), (key), 0)
+#define CHECK_FIND(t, key) rbtree_i32_find((t), (key))
+#define CHECK_ERASE(t, p) rbtree_i32_erase((t), (p))
+#define CHECK_TO_ARRAY(t, arr, n) rbtree_i32_to_array((t), (arr), (n))
+#define CHECK_NIL(t) ((t)->nil)
+#define CHECK_IS_RED(p) (!rbtree_i32_is_black(p))
+#include "rbtree_checks.h"
+
+#define CHECK_TREE rbtree_u64
+#define CHECK_NODE rbtree_u64_node
+#define CHECK_KEY uint64_t
+#define CHECK_FN(name) u64_##name
+#define CHECK_KEY_OF(i) u64_of(i)
+#define CHECK_LT(a, b) ((a) < (b))
+#define CHECK_EQ(a, b) ((a) == (b))
+#define CHECK_NEW() rbtree_u64_new()
+#define CHECK_DELETE(t) rbtree_u64_delete(t)
+#define CHECK_INSERT(t, key) rbtree_u64_insert((t), (key), 0)
+#define CHECK_FIND(t, key) rbtree_u64_find((t), (key))
+#define CHECK_ERASE(t, p) rbtree_u64_erase((t), (p))
+#define CHECK_TO_ARRAY(t, arr, n) rbtree_u64_to_array((t), (arr), (n))
+#define CHECK_NIL(t) ((t)->nil)
+#define CHECK_IS_RED(p) (!rbtree_u64_is_black(p))
+#include "rbtree_checks.h"
+
+#define CHECK_TREE rbtree_str
+#define CHECK_NODE rbtree_str_node
+#define CHECK_KEY str_key
+#define CHECK_FN(name) str_##name
+#define CHECK_KEY_OF(i) str_of(i)
+#define CHECK_LT(a, b) (strcmp((a), (b)) < 0)
+#define CHECK_EQ(a, b) (strcmp((a), (b)) == 0)
+#define CHECK_NEW() rbtree_str_new()
+#define CHECK_DELETE(t) rbtree_str_delete(t)
+#define CHECK_INSERT(t, key) rbtree_str_insert((t), (key), 0)
+#define CHECK_FIND(t, key) rbtree_str_find((t), (key))
+#define CHECK_ERASE(t, p) rbtree_str_erase((t), (p))
+#define CHECK_TO_ARRAY(t, arr, n) rbtree_str_to_array((t), (arr), (n))
+#define CHECK_NIL(t) ((t)->nil)
+#define CHECK_IS_RED(p) (!rbtree_str_is_black(p))
+#include "rbtree_checks.h"
+
+/**
+ * 인스턴스 하나에 대한 템플릿 전용 테스트 묶음을 생성
+ * NAME : 트리 이름, KEY : 키 타입, P : 위의 키 생성 함수와 공용 검사의 접두어(i32/u64/str)
+ * i번째로 넣은 노드에는 값으로 i를 저장
+ */
+#define DEFINE_TMPL_TESTS(NAME, KEY, P)                                                                                \
+    /* RB / 탐색 트리 조건(공용 검사)과 부모 포인터, 노드 수 */                                                        \
+    static void NAME##_check_rb(const NAME *t, size_t n) {                                                             \
+        P##_test_color_constraint(t);                                                                                  \
+        P##_test_search_constraint(t);                                                                                 \
+        size_t count = 0;                                                                                              \
+        for (const NAME##_node *p = NAME##_min(t); p != NULL; p = NAME##_next(t, p)) {                                 \
+            assert(NAME##_parent(p->left) == p || p->left == t->nil);                                                  \
+            assert(NAME##_parent(p->right) == p || p->right == t->nil);                                                \
+            count++;                                                                                                   \
+        }                                                                                                              \
+        assert(count == n);                                                                                            \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* sorted[0, n)에서 key 이상(upper가 1이면 key 초과)인 첫 위치 */                                                  \
+    static size_t NAME##_bound_index(const KEY *sorted, const size_t n, const KEY key, const int upper) {              \
+        size_t lo = 0, hi = n;                                                                                         \
+        while (lo < hi) {                                                                                              \
+            const size_t mid = lo + (hi - lo) / 2;                                                                     \
+            const int c = P##_comp(&sorted[mid], &key);                                                                \
+            if (upper ? c <= 0 : c < 0) {                                                                              \
+                lo = mid + 1;                                                                                          \
+            } else {                                                                                                   \
+                hi = mid;                                                                                              \
+            }                                                                                                          \
+        }                                                                                                              \
+        return lo;                                                                                                     \
+    }                                                                                                                  \
+                                                                                                                       \
+    static void NAME##_tests(const size_t n, const unsigned seed) {                                                    \
+        /* 빈 트리 */                                                                                                  \
+        NAME *t = NAME##_new();                                                                                        \
+        assert(t != NULL && t->root == t->nil);                                                                        \
+        assert(NAME##_min(t) == NULL && NAME##_max(t) == NULL);                                                        \
+        assert(NAME##_lower_bound(t, P##_of(0)) == NULL && NAME##_erase_key(t, P##_of(0)) == -1);                      \
+                                                                                                                       \
+        /* 키 준비 : 앞쪽 n/4 자리는 뒤쪽과 같은 난수로 만들어 중복 키를 포함시킴 */                                   \
+        srand(seed);                                                                                                   \
+        int *r = calloc(n, sizeof(int));                                                                               \
+        KEY *arr = calloc(n, sizeof(KEY));                                                                             \
+        KEY *sorted = calloc(n, sizeof(KEY));                                                                          \
+        KEY *res = calloc(n, sizeof(KEY));                                                                             \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            r[i] = rand();                                                                                             \
+        }                                                                                                              \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            arr[i] = P##_of(i < n / 4 ? r[n - 1 - i] : r[i]);                                                          \
+        }                                                                                                              \
+                                                                                                                       \
+        /* 단일 삽입/탐색/삭제 */                                                                                      \
+        NAME##_node *p = NAME##_insert(t, arr[0], 0);                                                                  \
+        assert(p != NULL && t->root == p && NAME##_parent(p) == t->nil);                                               \
+        assert(NAME##_find(t, arr[0]) == p);                                                                           \
+        assert(NAME##_find(t, arr[1]) == NULL || P##_comp(&arr[0], &arr[1]) == 0);                                     \
+        NAME##_erase(t, p);                                                                                            \
+        assert(t->root == t->nil);                                                                                     \
+                                                                                                                       \
+        /* 전체 삽입 후 RB 조건, 값 payload, min/max, to_array */                                                      \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            p = NAME##_insert(t, arr[i], i);                                                                           \
+            assert(p != NULL && p->value == i);                                                                        \
+        }                                                                                                              \
+        NAME##_check_rb(t, n);                                                                                         \
+        memcpy(sorted, arr, n * sizeof(KEY));                                                                          \
+        qsort(sorted, n, sizeof(KEY), P##_comp);                                                                       \
+        assert(P##_comp(&NAME##_min(t)->key, &sorted[0]) == 0);                                                        \
+        assert(P##_comp(&NAME##_max(t)->key, &sorted[n - 1]) == 0);                                                    \
+        NAME##_to_array(t, res, n);                                                                                    \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            assert(P##_comp(&res[i], &sorted[i]) == 0);                                                                \
+        }                                                                                                              \
+        size_t back = n;                                                                                               \
+        for (NAME##_node *q = NAME##_max(t); q != NULL; q = NAME##_prev(t, q)) {                                       \
+            assert(P##_comp(&q->key, &sorted[--back]) == 0);                                                           \
+        }                                                                                                              \
+                                                                                                                       \
+        /* lower_bound / upper_bound : 정렬된 배열을 이진 탐색한 위치의 키와 같아야 함 (있는 키, 무작위 키) */         \
+        for (size_t i = 0; i < n; i += 7) {                                                                            \
+            const KEY probes[] = {arr[i], P##_of(rand())};                                                             \
+            for (size_t j = 0; j < 2; j++) {                                                                           \
+                const size_t lo = NAME##_bound_index(sorted, n, probes[j], 0);                                         \
+                const size_t hi = NAME##_bound_index(sorted, n, probes[j], 1);                                         \
+                const NAME##_node *lb = NAME##_lower_bound(t, probes[j]);                                              \
+                const NAME##_node *ub = NAME##_upper_bound(t, probes[j]);                                              \
+                assert(lo == n ? lb == NULL : lb != NULL && P##_comp(&lb->key, &sorted[lo]) == 0);                     \
+                assert(hi == n ? ub == NULL : ub != NULL && P##_comp(&ub->key, &sorted[hi]) == 0);                     \
+            }                                                                                                          \
+        }                                                                                                              \
+                                                                                                                       \
+        /* 같은 키를 힌트로 넣어도 기존 같은 키들의 뒤에 들어가고, erase_next는 그 다음 노드를 돌려줌 */               \
+        NAME##_node *first = NAME##_lower_bound(t, arr[0]), *after = NAME##_upper_bound(t, arr[0]);                    \
+        p = NAME##_insert_hint(t, first, arr[0], n);                                                                   \
+        assert(p != NULL && p->value == n && NAME##_next(t, p) == after);                                              \
+        assert(NAME##_erase_next(t, p) == after);                                                                      \
+        NAME##_check_rb(t, n);                                                                                         \
+                                                                                                                       \
+        /* 모두 찾아서 삭제 (짝수 번째는 erase_key) -> 다시 찾으면 없음 (삭제 중간에도 RB 조건 유지) */                \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            if (i % 2 == 0) {                                                                                          \
+                assert(NAME##_erase_key(t, arr[i]) == 0);                                                              \
+            } else {                                                                                                   \
+                p = NAME##_find(t, arr[i]);                                                                            \
+                assert(p != NULL && P##_comp(&p->key, &arr[i]) == 0);                                                  \
+                NAME##_erase(t, p);                                                                                    \
+            }                                                                                                          \
+            if (i % (n / 8) == 0) {                                                                                    \
+                NAME##_check_rb(t, n - i - 1);                                                                         \
+            }                                                                                                          \
+        }                                                                                                              \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            assert(NAME##_find(t, arr[i]) == NULL);                                                                    \
+        }                                                                                                              \
+                                                                                                                       \
+        /* 정렬된 키를 직전 노드를 힌트로 넣기 (같은 키가 이어져도 힌트 옆) -> erase_next로 처음부터 모두 지움 */      \
+        NAME##_node *hint = NULL;                                                                                      \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            hint = NAME##_insert_hint(t, hint, sorted[i], i);                                                          \
+            assert(hint != NULL && hint->value == i);                                                                  \
+        }                                                                                                              \
+        NAME##_check_rb(t, n);                                                                                         \
+        size_t k = 0;                                                                                                  \
+        for (p = NAME##_min(t); p != NULL; k++) {                                                                      \
+            assert(p->value == k);                                                                                     \
+            p = NAME##_erase_next(t, p);                                                                               \
+        }                                                                                                              \
+        assert(k == n && t->root == t->nil);                                                                           \
+                                                                                                                       \
+        /* insert_unique : 중복 키는 노드를 늘리지 않고 처음 넣은 값을 유지 */                                         \
+        size_t uniq = 0;                                                                                               \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            int existed;                                                                                               \
+            p = NAME##_insert_unique(t, arr[i], i, &existed);                                                          \
+            assert(p != NULL && P##_comp(&p->key, &arr[i]) == 0);                                                      \
+            if (!existed) {                                                                                            \
+                assert(p->value == i);                                                                                 \
+                uniq++;                                                                                                \
+            } else {                                                                                                   \
+                assert(p->value < i);                                                                                  \
+            }                                                                                                          \
+        }                                                                                                              \
+        size_t distinct = 1;                                                                                           \
+        for (size_t i = 1; i < n; i++) {                                                                               \
+            distinct += P##_comp(&sorted[i - 1], &sorted[i]) != 0;                                                     \
+        }                                                                                                              \
+        assert(uniq == distinct);                                                                                      \
+        NAME##_check_rb(t, uniq);                                                                                      \
+                                                                                                                       \
+        /* upsert : 노드 수는 그대로, 값은 마지막으로 넣은 것으로 덮어씀 */                                            \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            p = NAME##_upsert(t, arr[i], i);                                                                           \
+            assert(p != NULL && p->value == i);                                                                        \
+        }                                                                                                              \
+        NAME##_check_rb(t, uniq);                                                                                      \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            p = NAME##_find(t, arr[i]);                                                                                \
+            assert(p->value >= i && P##_comp(&arr[p->value], &arr[i]) == 0);                                           \
+        }                                                                                                              \
+        while (NAME##_min(t) != NULL) {                                                                                \
+            NAME##_erase(t, NAME##_min(t));                                                                            \
+        }                                                                                                              \
+                                                                                                                       \
+        /* 노드가 남아있는 상태에서도 delete가 모두 해제해야 함 */                                                     \
+        for (size_t i = 0; i < n; i++) {                                                                               \
+            NAME##_insert(t, arr[i], i);                                                                               \
+        }                                                                                                              \
+        NAME##_delete(t);                                                                                              \
+                                                                                                                       \
+        free(r);                                                                                                       \
+        free(res);                                                                                                     \
+        free(sorted);                                                                                                  \
+        free(arr);                                                                                                     \
+    }
+
+DEFINE_TMPL_TESTS(rbtree_i32, int, i32)
+DEFINE_TMPL_TESTS(rbtree_u64, uint64_t, u64)
+DEFINE_TMPL_TESTS(rbtree_str, str_key, str)
+
+// test-rbtree.c의 main과 같은 순서로 공용 검사를 돌린 뒤 템플릿 전용 테스트
+#define RUN_TMPL_TESTS(NAME, P)                                                                                        \
+    P##_test_find_erase_fixed();                                                                                       \
+    P##_test_to_array_partial();                                                                                       \
+    P##_test_distinct_values();                                                                                        \
+    P##_test_duplicate_values();                                                                                       \
+    P##_test_find_erase_rand(10000, 17);                                                                               \
+    NAME##_tests(10000, 17)
+
+int main(void) {
+    RUN_TMPL_TESTS(rbtree_i32, i32);
+    RUN_TMPL_TESTS(rbtree_u64, u64);
+    RUN_TMPL_TESTS(rbtree_str, str);
+    str_free_all();
+    printf("Passed all tests!\n");
+}
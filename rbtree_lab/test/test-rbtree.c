@@ -1,8 +1,36 @@
 #include <assert.h>
+#include <limits.h>
 #include <rbtree.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(RBTREE_CONCURRENT) || defined(RBTREE_COW)
+#include <pthread.h>
+#endif
+
+// 키 타입과 상관없는 검사 (rbtree_checks.h). test-rbtree-tmpl.c도 같은 검사를 템플릿 트리마다 생성함
+#define CHECK_TREE rbtree
+#define CHECK_NODE node_t
+#define CHECK_KEY key_t
+#define CHECK_FN(name) name
+#define CHECK_KEY_OF(i) ((key_t)(i))
+#define CHECK_LT(a, b) ((a) < (b))
+#define CHECK_EQ(a, b) ((a) == (b))
+#define CHECK_NEW() new_rbtree()
+#define CHECK_DELETE(t) delete_rbtree(t)
+#define CHECK_INSERT(t, key) rbtree_insert((t), (key))
+#define CHECK_FIND(t, key) rbtree_find((t), (key))
+#define CHECK_ERASE(t, p) rbtree_erase((t), (p))
+#define CHECK_TO_ARRAY(t, arr, n) rbtree_to_array((t), (arr), (n))
+#ifdef SENTINEL
+#define CHECK_NIL(t) ((t)->nil)
+#else
+#define CHECK_NIL(t) NULL
+#endif
+#define CHECK_IS_RED(p) (rbtree_color(p) == RBTREE_RED)
+#include "rbtree_checks.h"
 
 // new_rbtree should return rbtree struct with null root node
 // 새로 만든 Red-Black Tree가 빈 트리 상태로 올바르게 초기화되었는지 검증
@@ -30,11 +58,11 @@ void test_insert_single(const key_t key) {
     // root의 왼쪽, 오른쪽, 부모는 sentinel
     assert(p->left == t->nil);
     assert(p->right == t->nil);
-    assert(p->parent == t->nil);
+    assert(rbtree_parent(p) == t->nil);
 #else
     assert(p->left == NULL);
     assert(p->right == NULL);
-    assert(p->parent == NULL);
+    assert(rbtree_parent(p) == NULL);
 #endif
     delete_rbtree(t);
 }
@@ -73,24 +101,6 @@ void test_erase_root(const key_t key) {
     delete_rbtree(t);
 }
 
-static void insert_arr(rbtree *t, const key_t *arr, const size_t n) {
-    for (size_t i = 0; i < n; i++) {
-        rbtree_insert(t, arr[i]);
-    }
-}
-
-static int comp(const void *p1, const void *p2) {
-    const key_t *e1 = (const key_t *)p1;
-    const key_t *e2 = (const key_t *)p2;
-    if (*e1 < *e2) {
-        return -1;
-    } else if (*e1 > *e2) {
-        return 1;
-    } else {
-        return 0;
-    }
-};
-
 // min/max should return the min/max value of the tree
 void test_minmax(key_t *arr, const size_t n) {
     // null array is not allowed
@@ -148,6 +158,84 @@ void test_to_array(rbtree *t, const key_t *arr, const size_t n) {
     free(res);
 }
 
+// rbtree_next/rbtree_prev로 양방향 순회한 결과가 정렬된 배열과 같아야 함
+void test_next_prev() {
+    rbtree *t = new_rbtree();
+    assert(t != NULL);
+    assert(rbtree_min(t) == NULL); // 빈 트리에서는 순회 시작점이 없음
+    assert(rbtree_max(t) == NULL);
+
+    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+    const size_t n = sizeof(entries) / sizeof(entries[0]);
+    insert_arr(t, entries, n);
+    qsort((void *)entries, n, sizeof(key_t), comp);
+
+    size_t i = 0;
+    for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) {
+        for (uint32_t k = rbtree_key_count(p); k > 0; k--) { // RBTREE_MULTISET : 노드 하나에 같은 키 count개
+            assert(i < n);
+            assert(p->key == entries[i++]);
+        }
+    }
+    assert(i == n);
+
+    for (node_t *p = rbtree_max(t); p != NULL; p = rbtree_prev(t, p)) {
+        for (uint32_t k = rbtree_key_count(p); k > 0; k--) {
+            assert(i > 0);
+            assert(p->key == entries[--i]);
+        }
+    }
+    assert(i == 0);
+
+    delete_rbtree(t);
+}
+
+typedef struct {
+    key_t keys[32];
+    size_t count;
+    size_t limit;
+} range_ctx;
+
+static int collect_range(node_t *p, void *ctx) {
+    range_ctx *c = (range_ctx *)ctx;
+    for (uint32_t k = rbtree_key_count(p); k > 0; k--) { // RBTREE_MULTISET : 같은 키 count개
+        c->keys[c->count++] = p->key;
+        if (c->count == c->limit) { // limit에 도달하면 순회 중단
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// [lo, hi] 구간의 키만 오름차순으로, 경계값과 중복 키를 포함해 방문해야 함
+void test_range() {
+    rbtree *t = new_rbtree();
+    assert(t != NULL);
+
+    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+    const size_t n = sizeof(entries) / sizeof(entries[0]);
+    insert_arr(t, entries, n);
+
+    range_ctx c = {.count = 0, .limit = 0};
+    rbtree_range(t, 12, 36, collect_range, &c);
+    const key_t expected[] = {12, 23, 24, 24, 25, 34, 36};
+    assert(c.count == sizeof(expected) / sizeof(expected[0]));
+    for (int i = 0; i < c.count; i++) {
+        assert(c.keys[i] == expected[i]);
+    }
+
+    c.count = 0;
+    rbtree_range(t, 37, 66, collect_range, &c); // 구간 안에 키가 없음
+    assert(c.count == 0);
+
+    c.count = 0;
+    c.limit = 2;
+    rbtree_range(t, 0, 1000, collect_range, &c); // 콜백이 멈추라고 하면 거기서 끝
+    assert(c.count == 2 && c.keys[0] == 2 && c.keys[1] == 5);
+
+    delete_rbtree(t);
+}
+
 // 트리의 인스턴스 2개를 동시에 운영해도 각각 정렬/불변이 유지되는지 검증
 void test_multi_instance() {
     rbtree *t1 = new_rbtree();
@@ -183,206 +271,1441 @@ void test_multi_instance() {
     delete_rbtree(t1);
 }
 
-// Search tree constraint
-// The values of left subtree should be less than or equal to the current node
-// The values of right subtree should be greater than or equal to the current
-// node
+void test_minmax_suite() {
+    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
+    const size_t n = sizeof(entries) / sizeof(entries[0]);
+    test_minmax(entries, n);
+}
 
-static bool search_traverse(const node_t *p, key_t *min, key_t *max, node_t *nil) {
-    if (p == nil) {
-        return true;
-    }
+// 중위순회 결과가 오름차순 배열과 같은지 검증
+void test_to_array_suite() {
+    rbtree *t = new_rbtree();
+    assert(t != NULL);
 
-    *min = *max = p->key;
+    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+    const size_t n = sizeof(entries) / sizeof(entries[0]);
+    test_to_array(t, entries, n);
 
-    key_t l_min, l_max, r_min, r_max;
-    l_min = l_max = r_min = r_max = p->key;
+    delete_rbtree(t);
+}
 
-    const bool lr = search_traverse(p->left, &l_min, &l_max, nil);
-    if (!lr || l_max > p->key) {
-        return false;
-    }
-    const bool rr = search_traverse(p->right, &r_min, &r_max, nil);
-    if (!rr || r_min < p->key) {
-        return false;
+// 정렬된 배열로 한 번에 만든 트리도 RED-BLACK, 탐색 불변식을 지켜야 함
+// 마지막 레벨이 꽉 찬 경우/덜 찬 경우가 모두 나오도록 n을 0부터 늘려가며 검증
+void test_from_sorted() {
+    const size_t max_n = 300;
+    key_t *arr = calloc(max_n, sizeof(key_t));
+    key_t *res = calloc(max_n, sizeof(key_t));
+    for (int i = 0; i < max_n; i++) {
+        arr[i] = i / 3; // 중복 키 포함
     }
 
-    *min = l_min;
-    *max = r_max;
-    return true;
-}
+    for (size_t n = 0; n <= max_n; n++) {
+        rbtree *t = rbtree_from_sorted(arr, n);
+        assert(t != NULL);
+        test_color_constraint(t);
+        test_search_constraint(t);
 
-void test_search_constraint(const rbtree *t) {
-    assert(t != NULL);
-    node_t *p = t->root;
-    key_t min, max;
+        rbtree_to_array(t, res, n);
+        for (int i = 0; i < n; i++) {
+            assert(res[i] == arr[i]);
+        }
+        delete_rbtree(t);
+    }
+
+    // 만들어진 트리에 이어서 삭제/삽입해도 정상 동작해야 함
+    rbtree *t = rbtree_from_sorted(arr, max_n);
+    for (int i = 0; i < max_n; i++) {
+        node_t *p = rbtree_find(t, arr[i]);
+        assert(p != NULL);
+        rbtree_erase(t, p);
+    }
 #ifdef SENTINEL
-    node_t *nil = t->nil;
+    assert(t->root == t->nil);
 #else
-    node_t *nil = NULL;
+    assert(t->root == NULL);
 #endif
-    assert(search_traverse(p, &min, &max, nil));
+    test_find_erase(t, arr, max_n);
+    insert_arr(t, arr, max_n);
+    test_color_constraint(t);
+    test_search_constraint(t);
+    delete_rbtree(t);
+
+    free(res);
+    free(arr);
 }
 
-// Color constraint
-// 1. Each node is either red or black. (by definition)
-// 2. All NIL nodes are considered black.
-// 3. A red node does not have a red child.
-// 4. Every path from a given node to any of its descendant NIL nodes goes
-// through the same number of black nodes.
+// 노드 풀 모드에서도 삽입/탐색/삭제가 같은 결과를 내는지 검증
+// capacity_hint를 작게 주어 slab이 여러 번 추가되는 경로까지 확인
+void test_pool(const size_t n, const unsigned int seed) {
+    srand(seed);
+    rbtree *t = new_rbtree_with_pool(4);
+    assert(t != NULL);
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (int i = 0; i < n; i++) {
+        arr[i] = rand();
+    }
+
+    test_find_erase(t, arr, n);
+
+    // 삭제된 노드는 free list에 올라가 다음 삽입에서 재사용되어야 함
+#ifdef RBTREE_CONCURRENT
+    rbtree_synchronize(t); // 앞선 삭제로 해제를 기다리는 노드를 먼저 반납해 둠
+#endif
+    node_t *p = rbtree_insert(t, arr[0]);
+    rbtree_erase(t, p);
+#ifdef RBTREE_CONCURRENT
+    rbtree_synchronize(t); // 동시 읽기 모드는 읽기 스레드가 끝났음을 확인한 뒤에 반납
+#endif
+    node_t *q = rbtree_insert(t, arr[1]);
+    assert(p == q);
+    rbtree_erase(t, q);
+
+    insert_arr(t, arr, n);
+    test_color_constraint(t);
+    test_search_constraint(t);
 
-bool touch_nil = false;
-int max_black_depth = 0;
+    free(arr);
+    delete_rbtree(t); // 노드가 남아있는 상태에서도 slab 단위 해제로 누수가 없어야 함
+}
 
-static void init_color_traverse(void) {
-    touch_nil = false;
-    max_black_depth = 0;
+#ifdef RBTREE_ORDER_STAT
+// 모든 노드의 size가 왼쪽 size + 오른쪽 size + 1 과 같은지 재귀로 확인하고 서브트리 크기 반환
+// (RBTREE_MULTISET은 1 대신 그 노드의 count)
+static size_t check_subtree_size(const rbtree *t, const node_t *p) {
+    if (p == t->nil) {
+        return 0;
+    }
+    size_t size = check_subtree_size(t, p->left) + check_subtree_size(t, p->right) + rbtree_key_count(p);
+    assert(p->size == size);
+    return size;
 }
 
-static bool color_traverse(const node_t *p, const color_t parent_color, const int black_depth, node_t *nil) {
-    if (p == nil) {
-        if (!touch_nil) {
-            touch_nil = true;
-            max_black_depth = black_depth;
-        } else if (black_depth != max_black_depth) {
-            return false;
+// select(k)는 정렬 결과의 k번째, rank(key)는 key보다 작은 키의 개수와 같아야 함
+static void check_order_stat(const rbtree *t, key_t *sorted, const size_t n) {
+    assert(check_subtree_size(t, t->root) == n);
+    for (size_t k = 0; k < n; k++) {
+        node_t *p = rbtree_select(t, k);
+        assert(p != NULL && p->key == sorted[k]);
+        size_t expected = k;
+        while (expected > 0 && sorted[expected - 1] == sorted[k]) { // 중복 키는 첫 위치가 rank
+            expected--;
         }
-        return true;
+        assert(rbtree_rank(t, sorted[k]) == expected);
     }
-    if (parent_color == RBTREE_RED && p->color == RBTREE_RED) {
-        return false;
-    }
-    int next_depth = ((p->color == RBTREE_BLACK) ? 1 : 0) + black_depth;
-    return color_traverse(p->left, p->color, next_depth, nil) && color_traverse(p->right, p->color, next_depth, nil);
+    assert(rbtree_select(t, n) == NULL);
+    assert(rbtree_rank(t, sorted[n - 1] + 1) == n);
 }
 
-void test_color_constraint(const rbtree *t) {
-    assert(t != NULL);
-#ifdef SENTINEL
-    node_t *nil = t->nil;
-#else
-    node_t *nil = NULL;
+// 삽입/삭제/회전을 거친 뒤에도 서브트리 크기가 유지되는지 검증
+void test_order_stat(const size_t n, const unsigned int seed) {
+    srand(seed);
+    rbtree *t = new_rbtree();
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (int i = 0; i < n; i++) {
+        arr[i] = rand() % (n / 2); // 중복 키 포함
+    }
+    insert_arr(t, arr, n);
+
+    // 앞쪽 절반을 지워가며 남은 키들로 검증
+    for (int i = 0; i < n / 2; i++) {
+        rbtree_erase(t, rbtree_find(t, arr[i]));
+    }
+    const size_t m = n - n / 2;
+    key_t *rest = arr + n / 2;
+    qsort((void *)rest, m, sizeof(key_t), comp);
+    check_order_stat(t, rest, m);
+    delete_rbtree(t);
+
+    // 정렬된 배열로 한 번에 만든 트리도 size가 채워져 있어야 함
+    t = rbtree_from_sorted(rest, m);
+    check_order_stat(t, rest, m);
+    delete_rbtree(t);
+
+    free(arr);
+}
 #endif
-    node_t *p = t->root;
-    assert(p == nil || p->color == RBTREE_BLACK);
 
-    init_color_traverse();
-    assert(color_traverse(p, RBTREE_BLACK, 0, nil));
+#ifdef RBTREE_INTERVAL
+// 모든 노드의 max_end가 자기 end와 두 자식의 max_end 중 가장 큰 값인지 재귀로 확인하고 그 값을 반환 (nil은 INT_MIN)
+static key_t check_max_end(const rbtree *t, const node_t *p) {
+    if (p == t->nil) {
+        return INT_MIN;
+    }
+    const key_t l = check_max_end(t, p->left), r = check_max_end(t, p->right);
+    key_t m = l > p->end ? l : p->end;
+    m = r > m ? r : m;
+    assert(p->key <= p->end && p->max_end == m);
+    return m;
 }
+#endif
 
-// rbtree should keep search tree and color constraints
-void test_rb_constraints(const key_t arr[], const size_t n) {
+// insert_unique는 같은 키를 한 번만 넣고, 이미 있으면 그 노드를 그대로 돌려줘야 함
+void test_insert_unique(const size_t n, const unsigned int seed) {
+    srand(seed);
     rbtree *t = new_rbtree();
-    assert(t != NULL);
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (int i = 0; i < n; i++) {
+        arr[i] = rand() % (n / 2); // 중복 키 포함
+    }
 
+    size_t uniq = 0;
+    for (int i = 0; i < n; i++) {
+        node_t *before = rbtree_find(t, arr[i]);
+        int existed = -1;
+        node_t *p = rbtree_insert_unique(t, arr[i], &existed);
+        assert(p != NULL && p->key == arr[i]);
+        assert(existed == (before != NULL));
+        assert(before == NULL || before == p); // 있던 키면 같은 노드
+        uniq += !existed;
+    }
+    assert(rbtree_insert_unique(t, arr[0], NULL) == rbtree_find(t, arr[0])); // existed는 생략 가능
+    test_color_constraint(t);
+    test_search_constraint(t);
+
+    // 중위 순회 결과에 중복이 없어야 하고 개수는 서로 다른 키의 수와 같음
+    qsort((void *)arr, n, sizeof(key_t), comp);
+    size_t distinct = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || arr[i - 1] != arr[i]) {
+            arr[distinct++] = arr[i];
+        }
+    }
+    assert(uniq == distinct);
+    key_t *res = calloc(n, sizeof(key_t));
+    assert(rbtree_to_array(t, res, n) == 0);
+    for (int i = 0; i < distinct; i++) {
+        assert(res[i] == arr[i]);
+    }
+#ifdef RBTREE_ORDER_STAT
+    check_order_stat(t, arr, distinct); // 새 노드를 붙일 때 지나온 경로의 size도 늘어나야 함
+#endif
+
+    free(res);
+    free(arr);
+    delete_rbtree(t);
+}
+
+// fd를 처음부터 다시 쓸 수 있도록 비우고 t를 저장
+static int save_to(const rbtree *t, int fd) {
+    assert(ftruncate(fd, 0) == 0 && lseek(fd, 0, SEEK_SET) == 0);
+    return rbtree_save(t, fd);
+}
+
+// 파일의 off 위치의 바이트 하나를 바꾸면 load가 실패해야 함
+static void check_corrupt(int fd, const off_t off) {
+    unsigned char b;
+    assert(pread(fd, &b, 1, off) == 1);
+    b ^= 0x01;
+    assert(pwrite(fd, &b, 1, off) == 1);
+    assert(rbtree_load(fd) == NULL);
+    b ^= 0x01; // 원래대로 되돌림
+    assert(pwrite(fd, &b, 1, off) == 1);
+}
+
+// save한 파일을 load하면 같은 키의 올바른 RB 트리가 되어야 하고, 손상된 파일은 거부해야 함
+void test_save_load(const size_t n, const unsigned int seed) {
+    srand(seed);
+    rbtree *t = new_rbtree();
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (int i = 0; i < n; i++) {
+        arr[i] = rand() - RAND_MAX / 2; // 음수 포함
+    }
+    arr[0] = -2147483647 - 1; // 키 범위의 양 끝
+    arr[1] = 2147483647;
+    arr[n - 1] = arr[n - 2]; // 중복 키
     insert_arr(t, arr, n);
-    assert(t->root != NULL);
+    qsort((void *)arr, n, sizeof(key_t), comp);
+
+    FILE *f = tmpfile();
+    assert(f != NULL);
+    const int fd = fileno(f);
+    assert(save_to(t, fd) == 0);
+    const off_t size = lseek(fd, 0, SEEK_END);
+    assert(size > 24 && size <= 24 + 5 * (off_t)n); // 헤더 8 + 꼬리 16, 키 하나는 최대 5바이트
+
+    rbtree *u = rbtree_load(fd);
+    assert(u != NULL);
+    key_t *res = calloc(n + 1, sizeof(key_t));
+    assert(rbtree_to_array(u, res, n + 1) == 0);
+    for (int i = 0; i < n; i++) {
+        assert(res[i] == arr[i]);
+    }
+    assert(rbtree_max(u)->key == arr[n - 1]);
+    test_color_constraint(u);
+    test_search_constraint(u);
+#ifdef RBTREE_ORDER_STAT
+    for (size_t k = 0; k < n; k++) { // check_order_stat은 최댓값 + 1을 쓰므로 키 범위의 끝이 든 이 트리에는 못 씀
+        assert(rbtree_select(u, k)->key == arr[k]);
+    }
+#endif
+    assert(rbtree_insert(u, 7) != NULL && rbtree_erase(u, rbtree_find(u, 7)) == 0); // 읽어온 트리도 그대로 수정 가능
+    delete_rbtree(u);
+
+    // 헤더, 본문, 꼬리(개수, 체크섬) 어디가 바뀌어도 거부
+    check_corrupt(fd, 0);
+    check_corrupt(fd, 6);
+    check_corrupt(fd, size / 2);
+    check_corrupt(fd, size - 16);
+    check_corrupt(fd, size - 1);
+    assert(ftruncate(fd, size - 1) == 0); // 잘린 파일
+    assert(rbtree_load(fd) == NULL);
+    assert(ftruncate(fd, 4) == 0);
+    assert(rbtree_load(fd) == NULL);
+
+    // 빈 트리도 왕복
+    rbtree *e = new_rbtree();
+    assert(save_to(e, fd) == 0);
+    delete_rbtree(e);
+    e = rbtree_load(fd);
+    assert(e != NULL && rbtree_min(e) == NULL);
+    delete_rbtree(e);
+
+    // 파이프에도 저장할 수 있지만 (앞에서부터 한 번에 써 내려감) mmap할 수 없으므로 읽지는 못함
+    // 읽는 쪽이 없으므로 파이프 버퍼를 넘지 않게 작은 트리로 확인
+    int fds[2];
+    assert(pipe(fds) == 0);
+    e = new_rbtree();
+    rbtree_insert(e, 1);
+    assert(rbtree_save(e, fds[1]) == 0);
+    delete_rbtree(e);
+    assert(rbtree_load(fds[0]) == NULL);
+    close(fds[0]);
+    close(fds[1]);
+    assert(rbtree_save(t, -1) == -1 && rbtree_load(-1) == NULL);
+
+    fclose(f);
+    free(res);
+    free(arr);
+    delete_rbtree(t);
+}
+
+typedef struct {
+    key_t *out;
+    size_t count, limit;
+} key_collect_ctx;
+
+static int collect_key(key_t key, void *ctx) {
+    key_collect_ctx *c = ctx;
+    c->out[c->count++] = key;
+    return c->count == c->limit;
+}
 
+// 정렬된 arr(n개)에서 x 이상인 첫 위치
+static size_t lower_index(const key_t *arr, const size_t n, const key_t x) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (arr[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// 얼린 트리의 find / lower_bound / range가 정렬된 배열에서 구한 답과 같은지 확인
+static void check_frozen(const rbtree_frozen *f, const key_t *arr, const size_t n) {
+    assert(rbtree_frozen_size(f) == n);
+    const key_t first = -2147483647 - 1, last = 2147483647;
+    const key_t *base = rbtree_frozen_lower_bound(f, first);
+    assert(n == 0 ? base == NULL : base != NULL);
+    for (size_t i = 0; i < n; i++) {
+        assert(base[i] == arr[i]); // 키가 오름차순으로 이어져 있음
+    }
+    for (size_t i = 0; i <= n + 1; i++) {
+        // 모든 키와 그 양옆, 키 범위의 양 끝을 찾아봄
+        key_t probes[3] = {first, last, 0};
+        if (i < n) {
+            probes[0] = arr[i] == first ? first : arr[i] - 1;
+            probes[1] = arr[i];
+            probes[2] = arr[i] == last ? last : arr[i] + 1;
+        }
+        for (int j = 0; j < 3; j++) {
+            const key_t x = probes[j];
+            const size_t k = lower_index(arr, n, x);
+            const key_t *p = rbtree_frozen_lower_bound(f, x);
+            assert(k == n ? p == NULL : p == base + k);
+            assert(rbtree_frozen_find(f, x) == (k < n && arr[k] == x));
+        }
+    }
+
+    key_t *res = calloc(n + 1, sizeof(key_t));
+    const key_t bounds[][2] = {{first, last}, {0, last / 2}, {first, 0}, {5, 4}, {last, last}};
+    for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+        const key_t lo = bounds[b][0], hi = bounds[b][1];
+        key_collect_ctx c = {res, 0, n + 1};
+        assert(rbtree_frozen_range(f, lo, hi, collect_key, &c) == 0);
+        size_t m = 0;
+        for (size_t i = lower_index(arr, n, lo); i < n && arr[i] <= hi; i++) {
+            assert(m < c.count && res[m++] == arr[i]);
+        }
+        assert(m == c.count);
+        c = (key_collect_ctx){res, 0, 3}; // 콜백이 멈추면 더 방문하지 않음
+        rbtree_frozen_range(f, lo, hi, collect_key, &c);
+        assert(c.count <= 3);
+    }
+    free(res);
+}
+
+// 얼린 트리 : 층 경계(블록 16개, 내부 노드 자식 17개)를 넘는 크기와 중복 키, 키 범위의 양 끝
+void test_freeze(const unsigned int seed) {
+    const size_t sizes[] = {0, 1, 15, 16, 17, 16 * 17, 16 * 17 + 1, 16 * 17 * 17 + 5, 20000};
+    srand(seed);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const size_t n = sizes[s];
+        key_t *arr = calloc(n + 1, sizeof(key_t));
+        rbtree *t = new_rbtree();
+        for (size_t i = 0; i < n; i++) {
+            arr[i] = s % 2 ? rand() - RAND_MAX / 2 : rand() % (int)(n / 2 + 1); // 짝수 번째 크기는 중복이 많음
+        }
+        if (n > 3) {
+            arr[0] = -2147483647 - 1;
+            arr[1] = 2147483647;
+            arr[2] = 2147483647;
+        }
+        insert_arr(t, arr, n);
+        qsort((void *)arr, n, sizeof(key_t), comp);
+        rbtree_frozen *f = rbtree_freeze(t);
+        assert(f != NULL);
+        delete_rbtree(t); // 원본과 메모리를 공유하지 않음
+        check_frozen(f, arr, n);
+        rbtree_frozen_free(f);
+        free(arr);
+    }
+    assert(rbtree_freeze(NULL) == NULL && rbtree_frozen_find(NULL, 0) == 0);
+    assert(rbtree_frozen_lower_bound(NULL, 0) == NULL && rbtree_frozen_range(NULL, 0, 1, collect_key, NULL) == -1);
+}
+
+// 트리가 RB 규칙을 지키고 중위 순회 결과가 keys(n개)를 정렬한 것과 같은지 확인. keys는 정렬된 채로 남음
+static void check_tree_keys(const rbtree *t, key_t *keys, const size_t n) {
     test_color_constraint(t);
     test_search_constraint(t);
+    qsort((void *)keys, n, sizeof(key_t), comp);
+    key_t *res = calloc(n + 1, sizeof(key_t));
+    assert(rbtree_to_array(t, res, n + 1) == 0);
+    for (size_t i = 0; i < n; i++) {
+        assert(res[i] == keys[i]);
+    }
+#ifdef RBTREE_ORDER_STAT
+    if (n > 0) {
+        check_order_stat(t, keys, n); // 내려가지 않고 붙인 노드도 조상의 size를 늘려야 함
+    }
+#endif
+#ifdef RBTREE_INTERVAL
+    check_max_end(t, t->root); // 점 구간만 있어도 회전 / join / 힌트 삽입을 거친 max_end가 맞아야 함
+#endif
+    free(res);
+}
+
+// 직전에 넣은 노드를 hint로 넘기며 step * i (± jitter) 키를 차례로 삽입하고 keys에 기록
+static void insert_hinted(rbtree *t, key_t *keys, const size_t n, const int step, const int jitter) {
+    node_t *hint = NULL;
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = step * (int)i + (jitter > 0 ? rand() % (2 * jitter + 1) - jitter : 0);
+        hint = rbtree_insert_hint(t, hint, keys[i]);
+        assert(hint != NULL && hint->key == keys[i]);
+    }
+}
+
+// 힌트 삽입 : 힌트 옆에 들어가는 키는 탐색 없이, 아니면 루트부터 넣어도 결과는 rbtree_insert와 같아야 함
+void test_insert_hint(const size_t n, const unsigned int seed) {
+    srand(seed);
+    key_t *keys = calloc(n, sizeof(key_t));
+    const int steps[] = {1, -1, 1, -1, 0};
+    const int jitters[] = {0, 0, 4, 4, 0}; // 오름차순, 내림차순, 거의 정렬된 키, 같은 키만
+    for (size_t c = 0; c < sizeof(steps) / sizeof(steps[0]); c++) {
+        rbtree *t = c % 2 ? new_rbtree_with_pool(0) : new_rbtree();
+        insert_hinted(t, keys, n, steps[c], jitters[c]);
+        check_tree_keys(t, keys, n);
+#ifdef RBTREE_STATS
+        rbtree_stats st;
+        rbtree_get_stats(t, &st);
+        if (jitters[c] == 0) { // 정렬된 키는 모두 힌트 옆에 들어가므로 삽입마다 비교 2번 (첫 삽입은 빈 트리라 0번)
+            assert(st.inserts == n && st.insert_compares == 2 * (n - 1));
+        }
+#endif
+        delete_rbtree(t);
+    }
+
+    // 엉뚱한 힌트 : 무작위 노드를 힌트로 줘도 루트부터 내려가 올바른 자리에 들어감
+    rbtree *t = new_rbtree();
+    assert(rbtree_insert_hint(t, NULL, 0) != NULL);
+    keys[0] = 0;
+    for (size_t i = 1; i < n; i++) {
+        keys[i] = rand() % (int)n - (int)n / 2;
+        node_t *hint = rbtree_find(t, keys[rand() % i]);
+        node_t *p = rbtree_insert_hint(t, hint, keys[i]);
+        assert(p != NULL && p->key == keys[i]);
+    }
+    check_tree_keys(t, keys, n);
+
+    // 지운 뒤에도 남은 노드를 힌트로 계속 삽입
+    for (size_t i = 0; i < n; i += 2) {
+        assert(rbtree_erase(t, rbtree_find(t, keys[i])) == 0);
+    }
+    node_t *hint = rbtree_min(t);
+    for (size_t i = 0; i < n; i += 2) {
+        keys[i] = (int)n + (int)i; // 최댓값보다 큰 키 -> 힌트가 최댓값이 될 때까지는 루트부터
+        hint = rbtree_insert_hint(t, hint, keys[i]);
+    }
+    check_tree_keys(t, keys, n);
+    delete_rbtree(t);
 
+    // 같은 키는 힌트나 finger로 넣어도 rbtree_insert처럼 기존 같은 키들의 맨 뒤 (5보다 큰 키가 없으니 다음 노드 없음)
+    // 1, 5, 5, 3 뒤에는 finger가 3이고 그 다음 노드가 첫 번째 5
+    t = new_rbtree();
+    const key_t dups[] = {1, 5, 5, 3};
+    node_t *three = NULL;
+    for (size_t i = 0; i < sizeof(dups) / sizeof(dups[0]); i++) {
+        three = rbtree_insert(t, dups[i]);
+    }
+    node_t *p = rbtree_insert(t, 5);
+    assert(p != NULL && rbtree_next(t, p) == NULL);
+    p = rbtree_insert_hint(t, three, 5);
+    assert(p != NULL && rbtree_next(t, p) == NULL);
+    p = rbtree_insert_hint(t, rbtree_find(t, 5), 5);
+    assert(p != NULL && rbtree_next(t, p) == NULL);
+    delete_rbtree(t);
+
+#ifdef RBTREE_FINGER
+    // finger 모드 : 힌트 없이 rbtree_insert만 불러도 마지막 위치 옆이면 비교 두 번으로 자리를 찾음
+    t = new_rbtree();
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = i % 2 ? (int)i : -(int)i; // 양쪽 끝으로 번갈아 -> finger를 자주 벗어남
+        assert(rbtree_insert(t, keys[i]) != NULL);
+        assert(t->finger != NULL && t->finger->key == keys[i]);
+    }
+    check_tree_keys(t, keys, n);
+    assert(rbtree_erase(t, t->finger) == 0 && t->finger == NULL); // 기억한 노드를 지우면 잊음
+    keys[n - 1] = (int)n * 2;
+    assert(rbtree_insert(t, keys[n - 1]) != NULL && t->finger_next == NULL && t->finger_prev != NULL);
+    int existed;
+    assert(rbtree_insert_unique(t, keys[n - 1], &existed) == t->finger && existed == 1);
+    assert(rbtree_insert_unique(t, t->finger_prev->key, &existed) == t->finger_prev && existed == 1);
+    check_tree_keys(t, keys, n);
+    delete_rbtree(t);
+
+    t = new_rbtree();
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = (int)(i / 3); // 같은 키 세 개씩
+        node_t *p = rbtree_insert_unique(t, keys[i], &existed);
+        assert(p != NULL && p->key == keys[i] && existed == (i % 3 != 0));
+    }
+    for (size_t i = 0; i < (n + 2) / 3; i++) {
+        keys[i] = (int)i;
+    }
+    check_tree_keys(t, keys, (n + 2) / 3);
     delete_rbtree(t);
+#endif
+    free(keys);
 }
 
-// rbtree should manage distinct values
-// 삭제 기능 사용 x, 중복 없는 값들에 대해 RED-BLACK 불변식과 BST 불변식 유지를 검증
-void test_distinct_values() {
-    const key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
-    const size_t n = sizeof(entries) / sizeof(entries[0]);
-    test_rb_constraints(entries, n);
+// 구간 삭제 : 작은 구간(하나씩)과 큰 구간(split / join) 모두 지운 개수와 남은 키가 배열로 계산한 것과 같아야 함
+void test_erase_range(const size_t n, const unsigned int seed) {
+    srand(seed);
+    key_t *keys = calloc(2 * n, sizeof(key_t));
+    for (int pool = 0; pool < 2; pool++) {
+        rbtree *t = pool ? new_rbtree_with_pool(0) : new_rbtree();
+        size_t m = n;
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rand() % (int)n - (int)n / 2; // 중복 키와 음수 포함
+            rbtree_insert(t, keys[i]);
+        }
+        assert(rbtree_erase_range(t, 10, 9) == 0 && rbtree_erase_range(NULL, 0, 1) == 0); // lo > hi
+        for (int round = 0; m > 0; round++) {
+            key_t lo, hi;
+            if (round % 3 == 0) { // 폭 2 안팎 (하나씩 지우는 경로)
+                lo = rand() % (int)n - (int)n / 2;
+                hi = lo + rand() % 3;
+            } else { // 넓은 구간 (split / join 경로), 가끔 트리 전체
+                lo = round % 7 == 0 ? INT_MIN : rand() % (int)n - (int)n / 2;
+                hi = round % 11 == 0 ? INT_MAX : lo + rand() % (int)(n / 4 + 1);
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < m; i++) {
+                if (keys[i] < lo || keys[i] > hi) {
+                    keys[kept++] = keys[i];
+                }
+            }
+            assert(rbtree_erase_range(t, lo, hi) == m - kept);
+            m = kept;
+            check_tree_keys(t, keys, m);
+            if (round % 4 == 1 && m + 50 <= 2 * n) { // 나누고 합친 트리에도 계속 삽입할 수 있어야 함
+                for (int j = 0; j < 50; j++) {
+                    keys[m++] = rand() % (int)n - (int)n / 2;
+                    rbtree_insert(t, keys[m - 1]);
+                }
+                check_tree_keys(t, keys, m);
+            }
+        }
+        assert(t->root == t->nil && rbtree_min(t) == NULL);
+        delete_rbtree(t);
+    }
+    free(keys);
 }
 
-// rbtree should manage values with duplicate
-// 중복 값 존재 시에도 RED-BLACK, 탐색 불변식 유지를 검증
-void test_duplicate_values() {
-    const key_t entries[] = {10, 5, 5, 34, 6, 23, 12, 12, 6, 12};
-    const size_t n = sizeof(entries) / sizeof(entries[0]);
-    test_rb_constraints(entries, n);
+// 정렬된 arr(n개)로 구한 답과 lower_bound / upper_bound / floor / ceiling이 같은지 x 하나에 대해 확인
+static void check_bounds(const rbtree *t, const key_t *arr, const size_t n, const key_t x) {
+    const size_t lo = lower_index(arr, n, x);
+    size_t hi = lo; // x 초과인 첫 위치
+    while (hi < n && arr[hi] == x) {
+        hi++;
+    }
+    node_t *lb = rbtree_lower_bound(t, x), *ub = rbtree_upper_bound(t, x), *fl = rbtree_floor(t, x);
+    assert(rbtree_ceiling(t, x) == lb);
+    assert(lo == n ? lb == NULL : lb != NULL && lb->key == arr[lo]);
+    assert(hi == n ? ub == NULL : ub != NULL && ub->key == arr[hi]);
+    assert(hi == 0 ? fl == NULL : fl != NULL && fl->key == arr[hi - 1]);
+    // 중복 키는 lower_bound / upper_bound가 그중 처음, floor가 마지막 -> 그 너머 이웃은 조건을 벗어남
+    node_t *p;
+    assert(lb == NULL || (p = rbtree_prev(t, lb)) == NULL || p->key < x);
+    assert(ub == NULL || (p = rbtree_prev(t, ub)) == NULL || p->key <= x);
+    assert(fl == NULL || (p = rbtree_next(t, fl)) == NULL || p->key > x);
 }
 
-void test_minmax_suite() {
-    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
-    const size_t n = sizeof(entries) / sizeof(entries[0]);
-    test_minmax(entries, n);
+// 경계 탐색 : 키마다 그 키와 양옆 값, 키 범위의 양 끝을 찾아 정렬된 배열의 답과 비교
+void test_bounds(const size_t n, const unsigned int seed) {
+    srand(seed);
+    rbtree *t = new_rbtree();
+    const key_t first = -2147483647 - 1, last = 2147483647;
+    assert(rbtree_lower_bound(NULL, 0) == NULL && rbtree_upper_bound(NULL, 0) == NULL);
+    assert(rbtree_floor(NULL, 0) == NULL && rbtree_ceiling(NULL, 0) == NULL);
+    check_bounds(t, NULL, 0, 0); // 빈 트리
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (size_t i = 0; i < n; i++) {
+        arr[i] = rand() % (int)n - (int)n / 4; // 중복 키와 음수 포함, 키 사이에 빈 값이 있음
+    }
+    arr[0] = first;
+    arr[1] = last;
+    insert_arr(t, arr, n);
+    qsort((void *)arr, n, sizeof(key_t), comp);
+    check_bounds(t, arr, n, first);
+    check_bounds(t, arr, n, last);
+    for (size_t i = 1; i + 1 < n; i++) {
+        check_bounds(t, arr, n, arr[i] - 1);
+        check_bounds(t, arr, n, arr[i]);
+        check_bounds(t, arr, n, arr[i] + 1);
+    }
+    // 양 끝 키를 지우면 그 너머를 찾을 때 NULL
+    rbtree_erase(t, rbtree_find(t, first));
+    rbtree_erase(t, rbtree_find(t, last));
+    check_bounds(t, arr + 1, n - 2, first);
+    check_bounds(t, arr + 1, n - 2, last);
+    assert(rbtree_floor(t, arr[1] - 1) == NULL && rbtree_upper_bound(t, arr[n - 2]) == NULL);
+    delete_rbtree(t);
+    free(arr);
 }
 
-// 중위순회 결과가 오름차순 배열과 같은지 검증
-void test_to_array_suite() {
+// rbtree_erase_key / rbtree_erase_next : 지운 뒤의 트리와 돌려준 다음 노드가 맞는지 확인
+void test_erase_key_next(const size_t n, const unsigned int seed) {
+    srand(seed);
+    key_t *keys = calloc(n, sizeof(key_t)), *rest = calloc(n, sizeof(key_t));
+    for (int pool = 0; pool < 2; pool++) {
+        rbtree *t = pool ? new_rbtree_with_pool(0) : new_rbtree();
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rand() % (int)(n / 2); // 중복 키 포함
+            rbtree_insert(t, keys[i]);
+        }
+        // 넣은 순서대로 절반을 키로 지움. 중복 키는 하나씩만 지워짐
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (i % 2 == 0) {
+                assert(rbtree_erase_key(t, keys[i]) == 0);
+            } else {
+                rest[m++] = keys[i];
+            }
+        }
+        assert(rbtree_erase_key(t, -1) == -1 && rbtree_erase_key(t, (key_t)n) == -1);
+        check_tree_keys(t, rest, m);
+
+        // 훑으면서 3의 배수 키만 지움 -> 돌려준 노드가 곧 다음에 볼 노드
+        // RBTREE_MULTISET : 노드 하나가 같은 키 count개이고, rbtree_erase_next는 그중 하나만 지우고 다음 노드로 감
+        size_t visited = 0, kept = 0;
+        for (node_t *p = rbtree_min(t); p != NULL;) {
+            const uint32_t copies = rbtree_key_count(p);
+            for (uint32_t k = 0; k < copies; k++) {
+                assert(p->key == rest[visited++]); // rest는 check_tree_keys가 정렬해 둠
+            }
+            const int erase = p->key % 3 == 0;
+            for (uint32_t k = erase; k < copies; k++) {
+                rest[kept++] = p->key;
+            }
+            p = erase ? rbtree_erase_next(t, p) : rbtree_next(t, p);
+        }
+        assert(visited == m);
+        check_tree_keys(t, rest, kept);
+
+        // 최댓값을 지우면 NULL, 남은 노드를 모두 앞에서부터 지우면 빈 트리
+        assert(rbtree_erase_next(t, rbtree_max(t)) == NULL);
+        for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_erase_next(t, p)) {
+            while (rbtree_key_count(p) > 1) { // 멀티셋 모드 : 마지막 하나만 남을 때까지 줄임 (노드는 그대로)
+                assert(rbtree_erase(t, p) == 0);
+            }
+        }
+        assert(rbtree_min(t) == NULL && rbtree_erase_next(t, NULL) == NULL && rbtree_erase_key(t, 0) == -1);
+        delete_rbtree(t);
+    }
+#ifdef RBTREE_COW
+    // 스냅샷이 있으면 지우는 경로가 복사됨 -> 돌려준 노드는 원본 트리의 (복사된) 노드여야 하고 스냅샷은 그대로
     rbtree *t = new_rbtree();
-    assert(t != NULL);
+    for (size_t i = 0; i < n; i++) {
+        rbtree_insert(t, (key_t)((i * 7919) % n)); // 겹치지 않는 키를 섞인 순서로
+    }
+    const rbtree *snap = rbtree_snapshot(t);
+    size_t kept = 0;
+    for (node_t *p = rbtree_min(t); p != NULL;) {
+        if (rand() % 2) {
+            const node_t *next = rbtree_next(t, p);
+            const key_t key = next == NULL ? 0 : next->key;
+            p = rbtree_erase_next(t, p);
+            assert(next == NULL ? p == NULL : p == rbtree_find(t, key)); // 스냅샷에만 남은 옛 노드가 아님
+        } else {
+            rest[kept++] = p->key;
+            p = rbtree_next(t, p);
+        }
+        if (rand() % 4 == 0) { // 스냅샷을 자주 새로 떠서 복사한 경로도 다시 공유되게 함
+            rbtree_snapshot_release(snap);
+            snap = rbtree_snapshot(t);
+        }
+    }
+    check_tree_keys(t, rest, kept);
+    rbtree_snapshot_release(snap);
+    delete_rbtree(t);
+#endif
+    free(rest);
+    free(keys);
+}
 
-    key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
-    const size_t n = sizeof(entries) / sizeof(entries[0]);
-    test_to_array(t, entries, n);
+// join / split : 나눈 두 트리와 다시 합친 트리가 배열로 계산한 키를 그대로 가져야 함
+// 풀 모드에서는 나뉜 트리끼리 slab을 함께 가지므로 어느 쪽을 먼저 지워도 나머지를 계속 쓸 수 있어야 함 (누수 검사 포함)
+void test_join_split(const size_t n, const unsigned int seed) {
+    srand(seed);
+    key_t *keys = calloc(n + 128, sizeof(key_t)); // 라운드마다 키가 하나까지 늘고, 끝에서 50개를 더 넣음
+    for (int pool = 0; pool < 2; pool++) {
+        rbtree *t = pool ? new_rbtree_with_pool(0) : new_rbtree();
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rand() % (int)n - (int)n / 2; // 중복 키와 음수 포함
+            rbtree_insert(t, keys[i]);
+        }
+        qsort(keys, n, sizeof(key_t), comp);
+        size_t m = n;
+        for (int round = 0; round < 40; round++) {
+            // 가끔 모든 키보다 작거나 큰 키로 나눠 한쪽이 빈 트리가 되게 함
+            const key_t key = round % 9 == 0 ? -(key_t)n : round % 13 == 0 ? (key_t)n : rand() % (int)n - (int)n / 2;
+            const size_t i = lower_index(keys, m, key);
+            rbtree *lt, *ge;
+            assert(rbtree_split(t, key, &lt, &ge) == 0 && lt == t && ge != t);
+            check_tree_keys(lt, keys, i);
+            check_tree_keys(ge, keys + i, m - i);
 
+            // 나뉜 뒤 양쪽에 따로 지우고 넣어도 서로 영향이 없음 (풀 모드는 free list도 따로)
+            if (i > 0) {
+                assert(rbtree_erase(lt, rbtree_min(lt)) == 0);
+                memmove(keys, keys + 1, --m * sizeof(key_t));
+            }
+            rbtree_insert(ge, key);
+            keys[m++] = key;
+            qsort(keys, m, sizeof(key_t), comp);
+
+            // key 앞의 가장 큰 키를 피벗으로 빼서 다시 합침
+            key_t pivot = key;
+            const size_t j = lower_index(keys, m, key);
+            if (j > 0) {
+                pivot = keys[j - 1];
+                assert(rbtree_erase(lt, rbtree_max(lt)) == 0);
+            } else {
+                keys[m++] = pivot;
+            }
+            if (j + 1 < m && round % 5 == 0) { // 순서가 맞지 않는 피벗은 거절하고 두 트리는 그대로
+                assert(rbtree_join(lt, keys[m - 1] + 1, ge) == -1 && rbtree_join(ge, pivot, lt) == -1);
+            }
+            assert(rbtree_join(lt, pivot, ge) == 0);
+            t = lt;
+            qsort(keys, m, sizeof(key_t), comp);
+            check_tree_keys(t, keys, m);
+        }
+        // 떼어낸 쪽만 남겨도 그 노드가 든 slab은 살아 있어야 함
+        const key_t mid = keys[m / 2];
+        const size_t i = lower_index(keys, m, mid);
+        rbtree *lt, *ge;
+        assert(rbtree_split(t, mid, &lt, &ge) == 0);
+        delete_rbtree(lt);
+        m -= i;
+        memmove(keys, keys + i, m * sizeof(key_t));
+        for (int j = 0; j < 50; j++) { // 기존 키보다 모두 큼
+            keys[m++] = (key_t)n + j;
+            rbtree_insert(ge, (key_t)n + j);
+        }
+        check_tree_keys(ge, keys, m);
+        delete_rbtree(ge);
+    }
+
+    // 따로 만든 트리끼리도 합칠 수 있음 (풀 모드끼리, 빈 트리 포함). 한쪽만 풀 모드이거나 같은 트리면 거절
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = 2 * (key_t)i;
+    }
+    rbtree *a = rbtree_from_sorted(keys, n / 2), *b = rbtree_from_sorted(keys + n / 2 + 1, n - n / 2 - 1);
+    rbtree *e = new_rbtree_with_pool(0), *plain = new_rbtree();
+    assert(rbtree_join(a, keys[n / 2], plain) == -1 && rbtree_join(a, keys[n / 2], a) == -1);
+    assert(rbtree_join(a, keys[n / 2] + 3, b) == -1); // b의 최솟값보다 큰 피벗
+    assert(rbtree_join(a, keys[n / 2], b) == 0 && rbtree_join(e, INT_MIN, a) == 0);
+    keys[n] = INT_MIN;
+    check_tree_keys(e, keys, n + 1);
+    delete_rbtree(e);
+    rbtree *x = new_rbtree(); // 빈 트리 둘을 합치면 피벗 하나만 남음
+    assert(rbtree_join(plain, 7, x) == 0 && rbtree_find(plain, 7) != NULL && rbtree_min(plain) == rbtree_max(plain));
+    delete_rbtree(plain);
+    free(keys);
+}
+
+// 정렬된 a(na개)와 b(nb개)에 집합 연산 op(0 합집합, 1 교집합, 2 차집합)를 한 결과를 out에 쓰고 개수를 반환
+// 키 단위로 판단 : a에 있는 키는 a의 개수만큼, 합집합에서 a에 없는 키는 b의 개수만큼
+static size_t merge_keys(const key_t *a, const size_t na, const key_t *b, const size_t nb, const int op, key_t *out) {
+    size_t i = 0, j = 0, m = 0;
+    while (i < na || j < nb) {
+        const key_t key = i < na && (j == nb || a[i] <= b[j]) ? a[i] : b[j];
+        const size_t i0 = i, j0 = j;
+        for (; i < na && a[i] == key; i++) {
+        }
+        for (; j < nb && b[j] == key; j++) {
+        }
+        const bool keep_a = op == 0 || (op == 1) == (j > j0);
+        for (size_t k = i0; k < i && keep_a; k++) {
+            out[m++] = key;
+        }
+        for (size_t k = j0; k < j && op == 0 && i == i0; k++) {
+            out[m++] = key;
+        }
+    }
+    return m;
+}
+
+void test_set_ops(const size_t n, const unsigned int seed) {
+    setenv("RBTREE_THREADS", "4", 0); // CPU가 하나뿐인 환경에서도 작업을 훔쳐 가는 경로를 거치게 함
+    srand(seed);
+    key_t *a = calloc(n, sizeof(key_t)), *b = calloc(n, sizeof(key_t)), *expect = calloc(2 * n, sizeof(key_t));
+    // 크기가 비슷한 두 트리, 한쪽이 훨씬 작은 경우, 한쪽이 빈 경우, 키 범위가 겹치지 않는 경우
+    const size_t sizes[][2] = {{n, n}, {n, n / 50}, {n / 50, n}, {n, 0}, {0, n / 3}};
+    for (int pool = 0; pool < 2; pool++) {
+        for (int op = 0; op < 3; op++) {
+            for (size_t c = 0; c < sizeof(sizes) / sizeof(sizes[0]) + 1; c++) {
+                const bool disjoint = c == sizeof(sizes) / sizeof(sizes[0]);
+                const size_t na = disjoint ? n / 2 : sizes[c][0], nb = disjoint ? n / 2 : sizes[c][1];
+                rbtree *t1 = pool ? new_rbtree_with_pool(0) : new_rbtree();
+                rbtree *t2 = pool ? new_rbtree_with_pool(0) : new_rbtree();
+                for (size_t i = 0; i < na; i++) {
+                    a[i] = rand() % (int)n - (int)n / 4; // 중복 키와 음수 포함
+                    rbtree_insert(t1, a[i]);
+                }
+                for (size_t i = 0; i < nb; i++) {
+                    b[i] = disjoint ? (key_t)(n + i) : rand() % (int)n - (int)n / 4;
+                    rbtree_insert(t2, b[i]);
+                }
+                qsort(a, na, sizeof(key_t), comp);
+                qsort(b, nb, sizeof(key_t), comp);
+                const size_t m = merge_keys(a, na, b, nb, op, expect);
+                assert((op == 0 ? rbtree_union : op == 1 ? rbtree_intersect : rbtree_difference)(t1, t2) == 0);
+                check_tree_keys(t1, expect, m);
+
+                // 결과 트리는 그대로 계속 쓸 수 있음 (풀 모드는 t2의 slab과 free list를 넘겨받음)
+                for (size_t i = 0; i < m; i += 3) {
+                    assert(rbtree_erase(t1, rbtree_find(t1, expect[i])) == 0);
+                }
+                for (size_t i = 0; i < 100; i++) {
+                    rbtree_insert(t1, (key_t)i);
+                }
+                delete_rbtree(t1);
+            }
+        }
+    }
+
+    // 한쪽만 풀 모드이거나 같은 트리면 거절하고 두 트리는 그대로
+    rbtree *t1 = new_rbtree(), *t2 = new_rbtree_with_pool(0);
+    rbtree_insert(t1, 1);
+    rbtree_insert(t2, 2);
+    assert(rbtree_union(t1, t2) == -1 && rbtree_intersect(t2, t1) == -1 && rbtree_difference(t1, t1) == -1);
+    assert(rbtree_union(NULL, t1) == -1 && rbtree_union(t1, NULL) == -1);
+    assert(rbtree_find(t1, 1) != NULL && rbtree_find(t2, 2) != NULL);
+#ifdef RBTREE_COW
+    const rbtree *snap = rbtree_snapshot(t1); // 스냅샷과 노드를 공유하는 트리는 옮길 수 없음
+    rbtree *t3 = new_rbtree();
+    assert(rbtree_union(t1, t3) == -1 && rbtree_union(t3, t1) == -1);
+    rbtree_snapshot_release(snap);
+    delete_rbtree(t3);
+#endif
+    delete_rbtree(t1);
+    delete_rbtree(t2);
+    free(expect);
+    free(b);
+    free(a);
+}
+
+// rbtree_foreach_par 콜백 : 방문한 노드 수와 키의 합을 여러 스레드에서 함께 셈. limit번째 방문에서 멈춤
+typedef struct {
+    size_t count, limit;
+    long long sum;
+} par_visit_ctx;
+
+static int par_visit(node_t *p, void *ctx) {
+    par_visit_ctx *c = ctx;
+    const uint32_t copies = rbtree_key_count(p); // RBTREE_MULTISET : 같은 키 count개
+    __atomic_add_fetch(&c->sum, (long long)p->key * copies, __ATOMIC_RELAXED);
+    return __atomic_add_fetch(&c->count, copies, __ATOMIC_RELAXED) >= c->limit && c->limit > 0;
+}
+
+void test_parallel_walk(const size_t n, const unsigned int seed) {
+    setenv("RBTREE_THREADS", "4", 0);
+    srand(seed);
+    key_t *keys = calloc(n, sizeof(key_t)), *res = calloc(n + 2, sizeof(key_t)); // 배열 끝 다음 칸까지 확인
+    long long sum = 0;
+    for (int pool = 0; pool < 2; pool++) {
+        rbtree *t = pool ? new_rbtree_with_pool(0) : new_rbtree();
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rand() % (int)n - (int)n / 4; // 중복 키와 음수 포함
+            rbtree_insert(t, keys[i]);
+            sum += pool ? 0 : keys[i];
+        }
+        qsort(keys, n, sizeof(key_t), comp);
+        // 배열이 트리보다 크거나, 작거나(앞쪽만 채움), 비어 있어도 rbtree_to_array와 같음
+        const size_t limits[] = {n + 1, n, n / 3, 1, 0};
+        for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+            res[limits[l]] = INT_MIN; // 채우지 말아야 할 칸
+            assert(rbtree_to_array_par(t, res, limits[l]) == 0);
+            for (size_t i = 0; i < limits[l] && i < n; i++) {
+                assert(res[i] == keys[i]);
+            }
+            assert(limits[l] >= n + 1 || res[limits[l]] == INT_MIN);
+        }
+        par_visit_ctx c = {0, 0, 0};
+        assert(rbtree_foreach_par(t, par_visit, &c) == 0 && c.count == n);
+        assert(pool || c.sum == sum);
+        c = (par_visit_ctx){0, n / 10, 0}; // 콜백이 멈추면 다른 스레드도 곧 멈춤
+        assert(rbtree_foreach_par(t, par_visit, &c) == 1 && c.count < n);
+        delete_rbtree_par(t);
+    }
+
+    // 작은 트리와 빈 트리는 한 스레드로 처리
+    rbtree *t = new_rbtree();
+    assert(rbtree_to_array_par(t, res, n) == 0);
+    par_visit_ctx c = {0, 0, 0};
+    assert(rbtree_foreach_par(t, par_visit, &c) == 0 && c.count == 0);
+    for (key_t k = 0; k < 100; k++) {
+        rbtree_insert(t, 99 - k);
+    }
+    assert(rbtree_to_array_par(t, res, n) == 0 && rbtree_foreach_par(t, par_visit, &c) == 0 && c.count == 100);
+    for (key_t k = 0; k < 100; k++) {
+        assert(res[k] == k);
+    }
+    assert(rbtree_to_array_par(NULL, res, n) == -1 && rbtree_to_array_par(t, NULL, n) == -1);
+    assert(rbtree_foreach_par(NULL, par_visit, &c) == -1 && rbtree_foreach_par(t, NULL, &c) == -1);
+    delete_rbtree_par(t);
+    delete_rbtree_par(NULL);
+    free(res);
+    free(keys);
+}
+
+#ifdef RBTREE_MULTISET
+// 노드 수 (rbtree_next로 걸어서 셈)
+static size_t count_nodes(const rbtree *t) {
+    size_t nodes = 0;
+    for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) {
+        nodes++;
+    }
+    return nodes;
+}
+
+// 멀티셋 모드 : 같은 키는 노드 하나의 count로 세고, 키를 펼치는 연산은 기본 트리와 같은 결과를 내야 함
+void test_multiset(const size_t n, const unsigned int seed) {
+    srand(seed);
+    const int distinct = 50;                    // 키마다 평균 n / 50번씩 들어감
+    key_t *keys = calloc(n + 2, sizeof(key_t)); // join에서 pivot 몫 두 개가 늘어남
+    rbtree *t = new_rbtree();
+    node_t *hint = NULL;
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand() % distinct;
+        node_t *p = i % 2 ? rbtree_insert(t, keys[i]) : (hint = rbtree_insert_hint(t, hint, keys[i]));
+        assert(p != NULL && p == rbtree_find(t, keys[i])); // 같은 키는 항상 같은 노드
+    }
+    int existed = 0;
+    assert(rbtree_insert_unique(t, keys[0], &existed) == rbtree_find(t, keys[0]) && existed == 1);
+    assert(count_nodes(t) == distinct);
+    check_tree_keys(t, keys, n); // 펼친 결과는 중복 키를 노드로 넣은 트리와 같음
+
+    // 하나씩 지우면 count만 줄다가 마지막 하나에서 노드가 사라짐
+    node_t *p = rbtree_find(t, keys[0]);
+    const key_t key = p->key;
+    for (uint32_t c = p->count; c > 1; c--) {
+        assert(rbtree_erase_key(t, key) == 0 && rbtree_find(t, key) == p && p->count == c - 1);
+    }
+    assert(rbtree_erase(t, p) == 0 && rbtree_find(t, key) == NULL && rbtree_erase_key(t, key) == -1);
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (keys[i] != key) {
+            keys[m++] = keys[i];
+        }
+    }
+    check_tree_keys(t, keys, m);
+
+    // 정렬된 배열, 저장한 파일에서 만든 트리도 키마다 노드 하나
+    rbtree *u = rbtree_from_sorted(keys, m);
+    assert(count_nodes(u) == distinct - 1);
+    check_tree_keys(u, keys, m);
+    delete_rbtree(u);
+    FILE *f = tmpfile();
+    assert(f != NULL && save_to(t, fileno(f)) == 0 && (u = rbtree_load(fileno(f))) != NULL);
+    assert(count_nodes(u) == distinct - 1);
+    check_tree_keys(u, keys, m);
+    delete_rbtree(u);
+    fclose(f);
+
+    // join의 pivot이 양쪽 끝 노드와 같은 키이면 세 몫이 노드 하나로 합쳐짐
+    const key_t mid = keys[m / 2];
+    rbtree *ge;
+    assert(rbtree_split(t, mid, &t, &ge) == 0);
+    assert(rbtree_insert(t, mid) != NULL && rbtree_join(t, mid, ge) == 0);
+    keys[m++] = mid;
+    keys[m++] = mid;
+    assert(count_nodes(t) == distinct - 1);
+    check_tree_keys(t, keys, m);
+
+    // rbtree_erase_range는 노드를 통째로 지우고 펼친 키 개수를 반환
+    size_t in_range = 0;
+    for (size_t i = 0; i < m; i++) {
+        in_range += keys[i] >= 10 && keys[i] <= 12;
+    }
+    assert(rbtree_erase_range(t, 10, 12) == in_range && rbtree_erase_range(t, 0, distinct) == m - in_range);
+    assert(rbtree_min(t) == NULL);
     delete_rbtree(t);
+    free(keys);
 }
+#endif
 
-// 올바른 삽입 검증
-// 올바른 삭제 검증
-void test_find_erase(rbtree *t, const key_t *arr, const size_t n) {
-    for (int i = 0; i < n; i++) { // 삽입 검증
-        node_t *p = rbtree_insert(t, arr[i]);
-        assert(p != NULL);
+#ifdef RBTREE_INTERVAL
+typedef struct {
+    key_t (*spans)[2]; // 방문한 구간 [start, end]
+    size_t count, limit;
+    key_t lo, hi;
+} overlap_ctx;
+
+static int collect_overlap(node_t *p, void *ctx) {
+    overlap_ctx *c = (overlap_ctx *)ctx;
+    assert(p->key <= c->hi && p->end >= c->lo);
+    assert(c->count == 0 || c->spans[c->count - 1][0] <= p->key); // 시작점 오름차순
+    c->spans[c->count][0] = p->key;
+    c->spans[c->count][1] = p->end;
+    return ++c->count == c->limit;
+}
+
+static int comp_span(const void *p1, const void *p2) {
+    const key_t *a = (const key_t *)p1, *b = (const key_t *)p2;
+    return a[0] != b[0] ? (a[0] > b[0]) - (a[0] < b[0]) : (a[1] > b[1]) - (a[1] < b[1]);
+}
+
+// rbtree_overlap(t, lo, hi)가 spans(살아 있는 구간 m개)를 전부 훑어 고른 구간과 같은 구간들을 방문하는지 확인
+static void check_overlap(const rbtree *t, key_t (*spans)[2], const size_t m, const key_t lo, const key_t hi) {
+    key_t(*want)[2] = calloc(m + 1, sizeof(*want)), (*got)[2] = calloc(m + 1, sizeof(*got));
+    size_t k = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (spans[i][0] <= hi && spans[i][1] >= lo) {
+            want[k][0] = spans[i][0];
+            want[k++][1] = spans[i][1];
+        }
+    }
+    overlap_ctx c = {.spans = got, .count = 0, .limit = 0, .lo = lo, .hi = hi};
+    assert(rbtree_overlap(t, lo, hi, collect_overlap, &c) == 0 && c.count == k);
+    qsort(want, k, sizeof(*want), comp_span);
+    qsort(got, k, sizeof(*got), comp_span); // 시작점이 같은 구간끼리는 순서가 정해져 있지 않음
+    assert(k == 0 || memcmp(want, got, k * sizeof(*want)) == 0);
+    free(got);
+    free(want);
+}
+
+// RB 규칙과 max_end를 확인하고 무작위 구간 / 점 / 전체 / 빈 질의를 선형 탐색 결과와 비교
+static void check_intervals(const rbtree *t, key_t (*spans)[2], const size_t m, const int span) {
+    test_color_constraint(t);
+    test_search_constraint(t);
+    check_max_end(t, t->root);
+    for (int q = 0; q < 200; q++) {
+        const key_t lo = rand() % span - 16, hi = q % 4 == 0 ? lo : lo + rand() % 64;
+        check_overlap(t, spans, m, lo, hi);
+    }
+    check_overlap(t, spans, m, INT_MIN, INT_MAX);
+    check_overlap(t, spans, m, 10, 9); // 뒤집힌 질의는 아무것도 겹치지 않음
+}
+
+// 구간 트리 모드 : 삽입 / 삭제 / 구간 삭제 / split / join을 거쳐도 max_end가 유지되고 겹침 질의가 선형 탐색과 같아야 함
+void test_interval(const size_t n, const unsigned int seed) {
+    srand(seed);
+    const int span = (int)n * 4;
+    key_t(*spans)[2] = calloc(n + 1, sizeof(*spans)); // 트리에 든 구간 [start, end] (join의 pivot 몫 하나 더)
+    node_t **nodes = calloc(n, sizeof(node_t *));
+    rbtree *t = new_rbtree();
+    assert(rbtree_insert_interval(t, 5, 4) == NULL && rbtree_min(t) == NULL); // 끝이 시작보다 앞
+    assert(rbtree_overlap(NULL, 0, 1, collect_overlap, NULL) == -1 && rbtree_overlap(t, 0, 1, NULL, NULL) == -1);
+    check_intervals(t, spans, 0, span);
+
+    // 대부분 짧은 구간, 가끔 트리 전체에 걸치는 긴 구간, 그리고 rbtree_insert로 넣은 점 구간
+    for (size_t i = 0; i < n; i++) {
+        spans[i][0] = rand() % span;
+        spans[i][1] = spans[i][0] + (i % 5 == 0 ? 0 : i % 16 == 1 ? rand() % span : rand() % 32);
+        nodes[i] = i % 5 == 0 ? rbtree_insert(t, spans[i][0]) : rbtree_insert_interval(t, spans[i][0], spans[i][1]);
+        assert(nodes[i] != NULL && nodes[i]->key == spans[i][0] && nodes[i]->end == spans[i][1]);
     }
+    check_intervals(t, spans, n, span);
 
+    // 콜백이 멈추라고 하면 시작점이 가장 작은 구간 하나에서 끝
+    key_t first[1][2];
+    overlap_ctx c = {.spans = first, .count = 0, .limit = 1, .lo = INT_MIN, .hi = INT_MAX};
+    assert(rbtree_overlap(t, INT_MIN, INT_MAX, collect_overlap, &c) == 0 && c.count == 1);
+    assert(first[0][0] == rbtree_min(t)->key);
+
+    // 무작위로 절반을 지움 (두 자식 노드의 후계자 이동과 delete_fixup의 회전)
+    size_t m = n;
+    for (size_t i = 0; i < n / 2; i++) {
+        const size_t j = rand() % m;
+        assert(rbtree_erase(t, nodes[j]) == 0);
+        m--;
+        nodes[j] = nodes[m];
+        memcpy(spans[j], spans[m], sizeof(spans[j]));
+    }
+    check_intervals(t, spans, m, span);
+
+    // 시작점이 [lo, hi]인 구간을 통째로 지움 (split + join)
+    const key_t lo = span / 4, hi = span / 2;
+    size_t kept = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (spans[i][0] < lo || spans[i][0] > hi) {
+            memcpy(spans[kept++], spans[i], sizeof(spans[i]));
+        }
+    }
+    assert(rbtree_erase_range(t, lo, hi) == m - kept);
+    m = kept;
+    check_intervals(t, spans, m, span);
+
+    // 시작점 기준으로 나눈 두 트리도 각자 질의할 수 있고, 점 구간 pivot으로 다시 합쳐도 max_end가 맞아야 함
+    const key_t key = span * 3 / 4;
+    qsort(spans, m, sizeof(*spans), comp_span);
+    size_t i = 0;
+    while (i < m && spans[i][0] < key) {
+        i++;
+    }
+    rbtree *lt, *ge;
+    assert(rbtree_split(t, key, &lt, &ge) == 0);
+    check_intervals(lt, spans, i, span);
+    check_intervals(ge, spans + i, m - i, span);
+    assert(rbtree_join(lt, key, ge) == 0);
+    spans[m][0] = spans[m][1] = key;
+    check_intervals(lt, spans, m + 1, span);
+
+    delete_rbtree(lt);
+    free(nodes);
+    free(spans);
+}
+#endif
+
+#ifdef RBTREE_STATS
+// 통계 모드 : 카운터가 실제 연산 횟수와 트리 상태를 따라가는지 검증
+void test_stats(const size_t n) {
+    rbtree *t = new_rbtree();
+    rbtree_stats st;
+    rbtree_get_stats(t, &st);
+    assert(st.nodes == 0 && st.height == 0 && st.inserts == 0 && st.rotations == 0);
+    assert(st.bytes == sizeof(rbtree) + sizeof(rbtree_stats)); // 빈 트리는 노드 메모리가 없음 (센티넬은 공용)
+
+    // 오름차순 삽입은 계속 오른쪽으로 기울어 회전이 반드시 일어남
     for (int i = 0; i < n; i++) {
-        node_t *p = rbtree_find(t, arr[i]);
-        // printf("arr[%d] = %d\n", i, arr[i]);
-        assert(p != NULL);
-        assert(p->key == arr[i]);
-        rbtree_erase(t, p);
+        rbtree_insert(t, i);
+    }
+    rbtree_get_stats(t, &st);
+    assert(st.inserts == n && st.node_allocs == n && st.mallocs == n && st.nodes == n);
+    assert(st.rotations > 0 && st.insert_fixups > 0);
+    size_t log2n = 0;
+    while (((size_t)1 << log2n) <= n) {
+        log2n++;
     }
+    assert(st.height >= log2n && st.height <= 2 * log2n); // RB 트리의 높이 상한 2 * log2(n + 1)
+    assert(st.bytes >= n * sizeof(node_t));
 
+    // 비교 횟수는 찾은 노드의 깊이 -> 호출마다 1 이상 height 이하
+    rbtree_reset_stats(t);
     for (int i = 0; i < n; i++) {
-        node_t *p = rbtree_find(t, arr[i]);
-        assert(p == NULL);
+        assert(rbtree_find(t, i) != NULL);
     }
+    assert(rbtree_find(t, -1) == NULL);
+    rbtree_get_stats(t, &st);
+    assert(st.finds == n + 1 && st.inserts == 0 && st.rotations == 0 && st.nodes == n);
+    assert(st.find_compares >= n + 1 && st.find_compares <= (n + 1) * st.height);
 
     for (int i = 0; i < n; i++) {
-        node_t *p = rbtree_insert(t, arr[i]);
-        assert(p != NULL);
-        node_t *q = rbtree_find(t, arr[i]);
-        assert(q != NULL);
-        assert(q->key == arr[i]);
-        assert(p == q);
-        rbtree_erase(t, p);
-        q = rbtree_find(t, arr[i]);
-        assert(q == NULL);
+        rbtree_erase(t, rbtree_find(t, i));
     }
+#ifdef RBTREE_CONCURRENT
+    rbtree_synchronize(t); // 해제를 기다리는 노드까지 반납된 뒤에 비교
+#endif
+    rbtree_get_stats(t, &st);
+    assert(st.erases == n && st.node_frees == n && st.nodes == 0 && st.height == 0);
+    delete_rbtree(t);
+
+    // 풀 모드 : 노드 할당은 n번이지만 malloc은 slab 개수만큼만
+    t = new_rbtree_with_pool(n / 4);
+    for (int i = 0; i < n; i++) {
+        rbtree_insert(t, i);
+    }
+    rbtree_get_stats(t, &st);
+    assert(st.node_allocs == n && st.mallocs <= 4 && st.nodes == n);
+    delete_rbtree(t);
+
+    // 정렬된 배열로 만든 트리는 회전 없이 노드 n개, 높이 floor(log2 n) + 1
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (int i = 0; i < n; i++) {
+        arr[i] = i;
+    }
+    t = rbtree_from_sorted(arr, n);
+    rbtree_get_stats(t, &st);
+    assert(st.nodes == n && st.rotations == 0 && st.mallocs == 1 && st.height == log2n);
+    delete_rbtree(t);
+    free(arr);
 }
+#endif
 
-void test_find_erase_fixed() {
-    const key_t arr[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
-    const size_t n = sizeof(arr) / sizeof(arr[0]);
-    rbtree *t = new_rbtree();
-    assert(t != NULL);
+#ifdef RBTREE_CONCURRENT
+// 동시 읽기 모드 : 쓰기 스레드가 짝수 키를 계속 넣고 지우는 동안 읽기 스레드가 락 없이 읽음
+// 홀수 키는 처음에 넣은 뒤 건드리지 않으므로 언제 읽어도 찾아져야 하고, min/max도 변하지 않아야 함
+#define CONC_STABLE 2000 // 홀수 키 1, 3, ..., 2 * CONC_STABLE - 1
+#define CONC_READERS 4
 
-    test_find_erase(t, arr, n);
+typedef struct {
+    rbtree *t;
+    int stop;
+    size_t reads;
+} conc_ctx;
 
-    delete_rbtree(t);
+static void *conc_reader(void *arg) {
+    conc_ctx *c = arg;
+    unsigned seed = (unsigned)(size_t)&seed;
+    size_t reads = 0;
+    while (!__atomic_load_n(&c->stop, __ATOMIC_ACQUIRE)) {
+        key_t key = 2 * (rand_r(&seed) % CONC_STABLE) + 1;
+        unsigned ticket = rbtree_read_lock(c->t); // 반환된 노드를 읽는 동안 해제되지 않도록
+        node_t *p = rbtree_find(c->t, key);
+        assert(p != NULL && p->key == key);
+        p = rbtree_find(c->t, key + 1); // 넣고 지우는 중인 짝수 키는 있거나 없거나
+        assert(p == NULL || p->key == key + 1);
+        rbtree_read_unlock(c->t, ticket);
+        assert(rbtree_min(c->t)->key == 1);
+        assert(rbtree_max(c->t)->key == 2 * CONC_STABLE - 1);
+        reads++;
+    }
+    __atomic_fetch_add(&c->reads, reads, __ATOMIC_RELAXED);
+    return NULL;
 }
 
-// 난수로 만들어진 키 집합에 대해
-// 1. 전부 삽입 -> 모두 탐색 가능
-// 2. 모두 삭제 -> 더이상 탐색 불가
-// 3. 다시 개별 삽입, 탐색, 삭제를 반복하며 검증
-void test_find_erase_rand(const size_t n, const unsigned int seed) {
-    srand(seed); // 고정 시드 - 매 실행마다 같은 난수를 얻어 테스트를 재현 가능하게 함
+void test_concurrent(const size_t updates) {
+    conc_ctx c = {.t = new_rbtree(), .stop = 0, .reads = 0};
+    for (int i = 0; i < CONC_STABLE; i++) {
+        rbtree_insert(c.t, 2 * i + 1);
+    }
+    pthread_t th[CONC_READERS];
+    for (int i = 0; i < CONC_READERS; i++) {
+        assert(pthread_create(&th[i], NULL, conc_reader, &c) == 0);
+    }
+
+    // 단일 쓰기 스레드 : 짝수 키를 넣고, 같은 횟수만큼 임의의 짝수 키를 지움 (회전과 해제가 계속 일어남)
+    unsigned seed = 17;
+    for (size_t i = 0; i < updates; i++) {
+        rbtree_insert(c.t, 2 * (rand_r(&seed) % (CONC_STABLE - 1)) + 2);
+        node_t *p = rbtree_find(c.t, 2 * (rand_r(&seed) % (CONC_STABLE - 1)) + 2);
+        if (p != NULL) {
+            rbtree_erase(c.t, p);
+        }
+    }
+    __atomic_store_n(&c.stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < CONC_READERS; i++) {
+        pthread_join(th[i], NULL);
+    }
+    assert(c.reads > 0);
+
+    test_color_constraint(c.t);
+    test_search_constraint(c.t);
+    delete_rbtree(c.t); // 해제를 기다리던 노드도 함께 해제되어야 함
+}
+#endif
+
+#ifdef RBTREE_COW
+// 스냅샷 모드 : 원본 트리를 계속 바꿔도 스냅샷은 찍은 순간의 내용을 그대로 보여야 함
+// 키는 [0, SNAP_KEYS) 범위에서 뽑고 키마다 들어 있는 개수(count[])로 기대 결과를 관리
+#define SNAP_KEYS 512
+
+// t의 중위 순회가 count[]와 같은지, RB 트리 조건을 지키는지 확인
+// live이면 원본 트리이므로 부모 포인터(rbtree_next)로 걸은 결과도 같아야 함
+static void check_snapshot(const rbtree *t, const int *count, const size_t total, const bool live) {
+    key_t *res = calloc(total + 1, sizeof(key_t));
+    res[total] = -1; // 노드가 더 있으면 덮어써짐
+    assert(rbtree_to_array(t, res, total + 1) == 0);
+    assert(res[total] == -1);
+    size_t i = 0;
+    for (key_t k = 0; k < SNAP_KEYS; k++) {
+        for (int c = 0; c < count[k]; c++) {
+            assert(res[i++] == k);
+        }
+    }
+    test_color_constraint(t);
+    test_search_constraint(t);
+    if (total > 0) {
+        assert(rbtree_min(t)->key == res[0] && rbtree_max(t)->key == res[total - 1]);
+#ifdef RBTREE_ORDER_STAT
+        check_order_stat(t, res, total);
+#endif
+    }
+    if (live) {
+        i = 0;
+        for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) {
+            for (uint32_t k = rbtree_key_count(p); k > 0; k--) {
+                assert(i < total && p->key == res[i++]);
+            }
+        }
+        assert(i == total);
+    }
+    free(res);
+}
+
+// 키를 하나 넣거나 지움 (반반)
+static void snapshot_update(rbtree *t, int *count, size_t *total) {
+    key_t k = rand() % SNAP_KEYS;
+    if (rand() % 2) {
+        assert(rbtree_insert(t, k) != NULL);
+        count[k]++;
+        (*total)++;
+    } else {
+        node_t *p = rbtree_find(t, k);
+        assert((p != NULL) == (count[k] > 0));
+        if (p != NULL) {
+            assert(rbtree_erase(t, p) == 0);
+            count[k]--;
+            (*total)--;
+        }
+    }
+}
+
+void test_snapshot(const size_t n, const bool use_pool, const unsigned int seed) {
+    srand(seed);
+    rbtree *t = use_pool ? new_rbtree_with_pool(0) : new_rbtree();
+    int count[SNAP_KEYS] = {0};
+    size_t total = 0;
+
+    // 빈 트리의 스냅샷은 삽입 뒤에도 비어 있음
+    const rbtree *empty = rbtree_snapshot(t);
+    assert(empty != NULL && rbtree_min(empty) == NULL);
+    for (size_t i = 0; i < n; i++) {
+        snapshot_update(t, count, &total);
+    }
+    assert(rbtree_min(empty) == NULL && rbtree_find(empty, count[0] > 0 ? 0 : 1) == NULL);
+    rbtree_snapshot_release(empty);
+
+    // 시점이 다른 스냅샷 3개. 찍을 때마다 원본을 n번 더 바꾸고 모든 스냅샷이 그대로인지 확인
+    const rbtree *snap[3];
+    int snap_count[3][SNAP_KEYS];
+    size_t snap_total[3];
+    for (int s = 0; s < 3; s++) {
+        snap[s] = rbtree_snapshot(t);
+        assert(snap[s] != NULL);
+        memcpy(snap_count[s], count, sizeof(count));
+        snap_total[s] = total;
+        for (size_t i = 0; i < n; i++) {
+            snapshot_update(t, count, &total);
+        }
+        check_snapshot(t, count, total, true);
+        for (int r = 0; r <= s; r++) {
+            check_snapshot(snap[r], snap_count[r], snap_total[r], false);
+        }
+    }
+    assert(rbtree_snapshot((rbtree *)snap[0]) == NULL); // 스냅샷의 스냅샷은 만들지 않음
+
+    // 가운데 스냅샷부터 해제해도 나머지 스냅샷과 원본은 그대로
+    rbtree_snapshot_release(snap[1]);
+    for (size_t i = 0; i < n; i++) {
+        snapshot_update(t, count, &total);
+    }
+    size_t removed = 0; // 구간 삭제도 스냅샷이 보는 노드는 건드리지 않음
+    for (int k = SNAP_KEYS / 4; k <= SNAP_KEYS / 2; k++) {
+        removed += count[k];
+        count[k] = 0;
+    }
+    assert(rbtree_erase_range(t, SNAP_KEYS / 4, SNAP_KEYS / 2) == removed);
+    total -= removed;
+    check_snapshot(t, count, total, true);
+    check_snapshot(snap[0], snap_count[0], snap_total[0], false);
+    check_snapshot(snap[2], snap_count[2], snap_total[2], false);
+    rbtree_snapshot_release(snap[0]);
+    check_snapshot(snap[2], snap_count[2], snap_total[2], false);
+    rbtree_snapshot_release(snap[2]);
+    check_snapshot(t, count, total, true);
+
+    // 스냅샷이 없으면 복사하지 않으므로 노드 포인터가 쓰기 뒤에도 그대로
+    node_t *p = rbtree_insert(t, SNAP_KEYS);
+    for (size_t i = 0; i < n; i++) {
+        snapshot_update(t, count, &total);
+    }
+    assert(rbtree_find(t, SNAP_KEYS) == p);
+    delete_rbtree(t); // 해제한 스냅샷이 남긴 노드가 없어야 함 (누수 검사)
+}
+
+typedef struct {
+    const rbtree *snap;
+    const key_t *expected; // 스냅샷을 찍은 순간의 중위 순회 결과
+    size_t n;
+    int stop;
+    size_t reads;
+} snap_reader_ctx;
+
+// 다른 스레드가 원본 트리를 바꾸는 동안 락 없이 스냅샷 전체를 읽음
+static void *snap_reader(void *arg) {
+    snap_reader_ctx *c = arg;
+    key_t *res = calloc(c->n, sizeof(key_t));
+    size_t reads = 0;
+    while (!__atomic_load_n(&c->stop, __ATOMIC_ACQUIRE)) {
+        assert(rbtree_to_array(c->snap, res, c->n) == 0);
+        for (size_t i = 0; i < c->n; i++) {
+            assert(res[i] == c->expected[i]);
+        }
+        node_t *p = rbtree_find(c->snap, c->expected[reads % c->n]);
+        assert(p != NULL && p->key == c->expected[reads % c->n]);
+        reads++;
+    }
+    c->reads = reads;
+    free(res);
+    return NULL;
+}
+
+void test_snapshot_concurrent(const size_t updates) {
+    srand(29);
     rbtree *t = new_rbtree();
-    key_t *arr = calloc(n, sizeof(key_t)); // n개 키를 담을 배열 동적 할당
-    for (int i = 0; i < n; i++) {          // n개의 난수를 arr에 채워넣음
-        arr[i] = rand();
+    int count[SNAP_KEYS] = {0};
+    size_t total = 0;
+    for (int i = 0; i < 2 * SNAP_KEYS; i++) {
+        snapshot_update(t, count, &total);
     }
+    snap_reader_ctx c = {.snap = rbtree_snapshot(t), .n = total};
+    key_t *expected = calloc(total, sizeof(key_t));
+    rbtree_to_array(c.snap, expected, total);
+    c.expected = expected;
 
-    // arr의 모든 원소 삽입 -> find 검증
-    // 각 노드를 삭제 -> 같은 키로 찾을 시 NULL인지 검증
-    // 다시 삽입 -> find가 같은 포인터 주소를 돌려주는디 확인 후 삭제
-    test_find_erase(t, arr, n);
+    pthread_t th;
+    assert(pthread_create(&th, NULL, snap_reader, &c) == 0);
+    for (size_t i = 0; i < updates; i++) { // 쓰기는 이 스레드만 하므로 락이 필요 없음
+        snapshot_update(t, count, &total);
+    }
+    __atomic_store_n(&c.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(th, NULL);
+    assert(c.reads > 0);
 
-    free(arr);
+    rbtree_snapshot_release(c.snap);
+    check_snapshot(t, count, total, true);
+    free(expected);
     delete_rbtree(t);
 }
+#endif
 
 int main(void) {
     test_init();
@@ -392,9 +1715,44 @@ int main(void) {
     test_find_erase_fixed();
     test_minmax_suite();
     test_to_array_suite();
+    test_to_array_partial();
+    test_next_prev();
+    test_range();
     test_distinct_values();
     test_duplicate_values();
+    test_from_sorted();
     test_multi_instance();
     test_find_erase_rand(10000, 17);
+    test_pool(10000, 17);
+    test_insert_unique(10000, 17);
+    test_save_load(10000, 17);
+    test_freeze(17);
+    test_insert_hint(5000, 17);
+    test_erase_range(5000, 17);
+    test_erase_key_next(4000, 17);
+    test_bounds(3000, 17);
+    test_join_split(3000, 17);
+    test_set_ops(5000, 17);
+    test_parallel_walk(100000, 17);
+#ifdef RBTREE_ORDER_STAT
+    test_order_stat(2000, 17);
+#endif
+#ifdef RBTREE_MULTISET
+    test_multiset(20000, 17);
+#endif
+#ifdef RBTREE_INTERVAL
+    test_interval(4000, 17);
+#endif
+#ifdef RBTREE_STATS
+    test_stats(1000);
+#endif
+#ifdef RBTREE_CONCURRENT
+    test_concurrent(100000);
+#endif
+#ifdef RBTREE_COW
+    test_snapshot(2000, false, 17);
+    test_snapshot(2000, true, 18);
+    test_snapshot_concurrent(100000);
+#endif
     printf("Passed all tests!\n");
 }
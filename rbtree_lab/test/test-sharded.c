@@ -0,0 +1,146 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sharded_rbtree.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// sharded_rbtree가 여러 스레드의 동시 삽입/삭제 뒤에도 단일 트리와 같은 결과를 내는지 검증
+// 해시 모드와 구간 모드에 같은 테스트를 돌림
+
+#define THREADS 4
+#define PER_THREAD 5000
+
+static int comp(const void *p1, const void *p2) {
+    const key_t *e1 = (const key_t *)p1;
+    const key_t *e2 = (const key_t *)p2;
+    if (*e1 < *e2) {
+        return -1;
+    } else if (*e1 > *e2) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+typedef struct {
+    sharded_rbtree *st;
+    const key_t *keys; // 이 스레드가 맡은 키 PER_THREAD개
+} worker_ctx;
+
+static void *insert_worker(void *arg) {
+    worker_ctx *w = arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+        assert(sharded_rbtree_insert(w->st, w->keys[i]) == 0);
+    }
+    return NULL;
+}
+
+// 맡은 키 중 짝수 번째만 삭제
+static void *erase_worker(void *arg) {
+    worker_ctx *w = arg;
+    for (int i = 0; i < PER_THREAD; i += 2) {
+        assert(sharded_rbtree_erase(w->st, w->keys[i]) == 0);
+    }
+    return NULL;
+}
+
+static void run_workers(sharded_rbtree *st, key_t *keys, void *(*fn)(void *)) {
+    pthread_t th[THREADS];
+    worker_ctx ctx[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        ctx[i] = (worker_ctx){st, keys + i * PER_THREAD};
+        assert(pthread_create(&th[i], NULL, fn, &ctx[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(th[i], NULL);
+    }
+}
+
+typedef struct {
+    key_t *out;
+    size_t count, limit;
+} range_ctx;
+
+static int collect(node_t *p, void *ctx) {
+    range_ctx *c = ctx;
+    c->out[c->count++] = p->key;
+    return c->count == c->limit;
+}
+
+// sorted(오름차순, m개)와 트리의 to_array / range 결과가 같은지 확인
+static void check_ordered(sharded_rbtree *st, const key_t *sorted, const size_t m, const key_t lo, const key_t hi) {
+    key_t *res = calloc(m + 1, sizeof(key_t));
+    assert(sharded_rbtree_to_array(st, res, m + 1) == 0);
+    for (size_t i = 0; i < m; i++) {
+        assert(res[i] == sorted[i]);
+    }
+
+    // [lo, hi] 구간은 sorted를 걸러낸 것과 같아야 함
+    range_ctx c = {res, 0, m + 1};
+    assert(sharded_rbtree_range(st, lo, hi, collect, &c) == 0);
+    size_t j = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (sorted[i] >= lo && sorted[i] <= hi) {
+            assert(j < c.count && res[j++] == sorted[i]);
+        }
+    }
+    assert(j == c.count);
+
+    // 콜백이 멈추면 더 방문하지 않음
+    c = (range_ctx){res, 0, 3};
+    sharded_rbtree_range(st, lo, hi, collect, &c);
+    assert(c.count <= 3);
+    free(res);
+}
+
+static void test_sharded(sharded_rbtree *st, const key_t key_range, const unsigned seed) {
+    assert(st != NULL);
+    const size_t n = THREADS * PER_THREAD;
+    key_t *keys = calloc(n, sizeof(key_t));
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand() % key_range - key_range / 4; // 중복 키와 구간 밖(음수, key_range 이상)의 키 포함
+    }
+
+    run_workers(st, keys, insert_worker);
+    for (size_t i = 0; i < n; i++) {
+        assert(sharded_rbtree_find(st, keys[i]));
+    }
+    key_t *sorted = calloc(n, sizeof(key_t));
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = keys[i];
+    }
+    qsort(sorted, n, sizeof(key_t), comp);
+    check_ordered(st, sorted, n, key_range / 3, key_range / 2);
+
+    // 스레드마다 맡은 키의 절반을 동시에 삭제 -> 남은 키는 홀수 번째 키들
+    run_workers(st, keys, erase_worker);
+    size_t m = 0;
+    for (int w = 0; w < THREADS; w++) {
+        for (int i = 1; i < PER_THREAD; i += 2) {
+            sorted[m++] = keys[w * PER_THREAD + i];
+        }
+    }
+    qsort(sorted, m, sizeof(key_t), comp);
+    check_ordered(st, sorted, m, -key_range, key_range / 5);
+    for (size_t i = 0; i < m; i++) {
+        assert(sharded_rbtree_find(st, sorted[i]));
+    }
+    assert(!sharded_rbtree_find(st, key_range * 2));
+    assert(sharded_rbtree_erase(st, key_range * 2) == -1);
+
+    free(sorted);
+    free(keys);
+    delete_sharded_rbtree(st);
+}
+
+int main(void) {
+    const key_t key_range = 40000;
+    test_sharded(new_sharded_rbtree_hash(8), key_range, 17);
+    test_sharded(new_sharded_rbtree_hash(1), key_range, 18); // shard 1개 = 락 하나로 감싼 트리
+    test_sharded(new_sharded_rbtree_range(8, 0, key_range - 1), key_range, 19);
+    test_sharded(new_sharded_rbtree_range(3, 0, 10), key_range, 20); // 대부분의 키가 구간 밖
+    assert(new_sharded_rbtree_range(4, 10, 0) == NULL);
+    assert(new_sharded_rbtree_hash(0) == NULL);
+    printf("Passed all tests!\n");
+}